@@ -0,0 +1,417 @@
+// -*- C++ -*-
+
+// PANDA Timeswipe Project
+// Copyright (C) 2021  PANDA GmbH / Dmitry Igrishin
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef PANDA_TIMESWIPE_ACQUISITION_HPP
+#define PANDA_TIMESWIPE_ACQUISITION_HPP
+
+#include "chunk.hpp"
+#include "debug.hpp"
+#include "exceptions.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace panda::timeswipe::detail {
+
+/// The value of `Chunk_read::tco` when more chunks of the data set follow.
+constexpr unsigned chunk_tco_continue{0x00004000}; // BCM 14
+
+/// The maximum number of chunks per data set.
+constexpr std::size_t max_data_set_size{255*32};
+
+/// The maximum number of chunks the RAM (A and B) of the board can hold.
+constexpr std::size_t board_ram_capacity{2*max_data_set_size};
+
+/// The result of reading the chunk.
+struct Chunk_read final {
+  Chunk chunk{};
+  unsigned tco{};
+  bool pi_ok{};
+
+  /// @returns `true` if this is the last chunk of the data set.
+  bool is_last() const noexcept
+  {
+    return !pi_ok || tco != chunk_tco_continue;
+  }
+};
+
+/**
+ * @brief The controller of the interval of polling the source of data sets.
+ *
+ * @details The interval is adjusted after each read so the number of chunks
+ * read per data set approaches the target: the interval is shortened when
+ * the data sets are larger than the target (so the latency is reduced and the
+ * RAM of the board is kept far from the overflow), and lengthened when they
+ * are smaller (so the CPU isn't spent on reading the tiny data sets). The
+ * number of chunks is smoothed, so the occasional late read (e.g. because of
+ * preemption) doesn't shake the interval much.
+ */
+class Read_pacer final {
+public:
+  /// An alias of the duration type.
+  using Duration = std::chrono::microseconds;
+
+  /// The initial interval, which matches the pace of the board.
+  static constexpr Duration initial_interval{700};
+
+  /// The minimum interval.
+  static constexpr Duration min_interval{100};
+
+  /// The maximum interval.
+  static constexpr Duration max_interval{20000};
+
+  /// The target number of chunks per read (~700 us of data at 48 kHz).
+  static constexpr std::uint64_t target_count{32};
+
+  /// @returns The interval to wait before the next read.
+  Duration interval() const noexcept
+  {
+    return interval_;
+  }
+
+  /**
+   * @brief Resets the state.
+   *
+   * @par Effects
+   * `(interval() == initial_interval)`.
+   */
+  void reset() noexcept
+  {
+    interval_ = initial_interval;
+    count_ = target_count;
+  }
+
+  /**
+   * @brief Adjusts the interval by the `count` of chunks of the data set read
+   * after waiting the interval().
+   *
+   * @param is_early `true` if the data set was terminated by the source as
+   * not ready (`!Chunk_read::pi_ok`), in which case the interval is never
+   * shortened.
+   */
+  void update(const std::uint64_t count, const bool is_early) noexcept
+  {
+    // Exponential smoothing with the factor of 1/4.
+    count_ += (static_cast<double>(count) - count_) / 4;
+
+    // Change the interval no more than twice per read.
+    auto ratio = std::clamp(target_count / std::max(count_, 1.), .5, 2.);
+    if (is_early)
+      ratio = std::max(ratio, 1.25);
+    const auto interval = static_cast<Duration::rep>(interval_.count() * ratio);
+    interval_ = std::clamp(Duration{interval}, min_interval, max_interval);
+  }
+
+private:
+  Duration interval_{initial_interval};
+  double count_{target_count};
+};
+
+/**
+ * @brief A source of the data sets.
+ *
+ * @details The data is read by data sets. Each data set is read by calling
+ * await_data() followed by calls of read_chunk() until the last chunk is read,
+ * followed by the call of complete_reading().
+ */
+class Acquisition_source {
+public:
+  /// The destructor.
+  virtual ~Acquisition_source() = default;
+
+  /**
+   * @returns `true` if the source is backed by the real board which can be
+   * controlled via SPI.
+   */
+  virtual bool is_board_attached() const noexcept = 0;
+
+  /**
+   * @brief Initializes the source.
+   *
+   * @remarks Must be idempotent.
+   */
+  virtual void initialize() = 0;
+
+  /// Called after the measurement is started.
+  virtual void start() = 0;
+
+  /// Called before the measurement is stopped.
+  virtual void stop() = 0;
+
+  /**
+   * @brief Waits the data set becomes available for reading.
+   *
+   * @param interval The interval of polling the source.
+   *
+   * @see Read_pacer.
+   */
+  virtual void await_data(std::chrono::microseconds interval) = 0;
+
+  /// @returns The next chunk of the data set.
+  virtual Chunk_read read_chunk() noexcept = 0;
+
+  /// Called after the data set has been read.
+  virtual void complete_reading() noexcept = 0;
+
+  /**
+   * @returns The number of chunks lost (i.e. produced by the board but never
+   * read) since the previous call, or since the start() if this is the first
+   * call after it.
+   *
+   * @remarks The chunks are lost if the data sets aren't read in time, so the
+   * RAM of the board overflows.
+   */
+  virtual std::uint64_t take_lost_count() noexcept = 0;
+};
+
+/**
+ * @brief A source which produces the data sets at the pace of the board.
+ *
+ * @details The number of chunks of each data set depends on the time elapsed
+ * since the previous call of await_data(). The chunks which don't fit into
+ * `ram_capacity` are lost as it happens on the board.
+ */
+class Paced_acquisition_source : public Acquisition_source {
+public:
+  /**
+   * @brief The constructor.
+   *
+   * @param sample_rate The number of chunks per second to produce.
+   * @param speed The speed factor. Zero means "as fast as possible", in which
+   * case each data set consists of `max_data_set_size` chunks.
+   */
+  Paced_acquisition_source(const int sample_rate, const double speed)
+    : sample_rate_{sample_rate}
+    , speed_{speed}
+  {
+    if (!(sample_rate_ > 0))
+      throw Exception{"invalid sample rate of acquisition source"};
+    else if (!(speed_ >= 0))
+      throw Exception{"invalid speed of acquisition source"};
+  }
+
+  /// The maximum number of chunks per data set.
+  static constexpr std::uint64_t max_data_set_size{detail::max_data_set_size};
+
+  /// The maximum number of chunks the RAM (A and B) of the board can hold.
+  static constexpr std::uint64_t ram_capacity{detail::board_ram_capacity};
+
+  bool is_board_attached() const noexcept override
+  {
+    return false;
+  }
+
+  void initialize() override
+  {}
+
+  void start() override
+  {
+    start_time_ = Clock::now();
+    produced_count_ = 0;
+    pending_count_ = 0;
+    lost_count_ = 0;
+  }
+
+  void stop() override
+  {}
+
+  void await_data(const std::chrono::microseconds interval) override
+  {
+    if (speed_ > 0) {
+      while (true) {
+        std::this_thread::sleep_for(interval);
+        const std::chrono::duration<double> elapsed{Clock::now() - start_time_};
+        const auto available = static_cast<std::uint64_t>(
+          elapsed.count() * speed_ * sample_rate_);
+        if (available > produced_count_) {
+          if (const auto backlog = available - produced_count_; backlog > ram_capacity) {
+            const auto lost = backlog - ram_capacity;
+            skip_chunks(produced_count_, lost);
+            produced_count_ += lost;
+            lost_count_ += lost;
+          }
+          pending_count_ = std::min(available - produced_count_, max_data_set_size);
+          break;
+        }
+      }
+    } else
+      pending_count_ = max_data_set_size;
+  }
+
+  Chunk_read read_chunk() noexcept override
+  {
+    Chunk_read result;
+    result.chunk = next_chunk(produced_count_);
+    produced_count_++;
+    if (pending_count_)
+      pending_count_--;
+    result.tco = pending_count_ ? chunk_tco_continue : 0;
+    result.pi_ok = true;
+    return result;
+  }
+
+  void complete_reading() noexcept override
+  {}
+
+  std::uint64_t take_lost_count() noexcept override
+  {
+    return std::exchange(lost_count_, 0);
+  }
+
+protected:
+  /// @returns The chunk of the given `index` since the start().
+  virtual Chunk next_chunk(std::uint64_t index) noexcept = 0;
+
+  /// Skips `count` chunks starting from the given `index` since the start().
+  virtual void skip_chunks(const std::uint64_t index,
+    const std::uint64_t count) noexcept
+  {
+    for (std::uint64_t i{}; i < count; ++i)
+      next_chunk(index + i);
+  }
+
+private:
+  using Clock = std::chrono::steady_clock;
+  int sample_rate_{};
+  double speed_{};
+  Clock::time_point start_time_{};
+  std::uint64_t produced_count_{};
+  std::uint64_t pending_count_{};
+  std::uint64_t lost_count_{};
+};
+
+/**
+ * @brief A source of synthetic data.
+ *
+ * @details Each channel carries a triangle wave of its own period. The codes
+ * are calculated with integer arithmetic only, so the produced chunks are
+ * bit-exact on any platform.
+ *
+ * @see code().
+ */
+class Simulated_acquisition_source final : public Paced_acquisition_source {
+public:
+  /// The constructor.
+  explicit Simulated_acquisition_source(const int sample_rate = 48000,
+    const double speed = 1)
+    : Paced_acquisition_source{sample_rate, speed}
+  {}
+
+  /// @returns The code of the given `channel` at the given sample `index`.
+  static constexpr std::uint16_t code(const unsigned channel,
+    const std::uint64_t index) noexcept
+  {
+    PANDA_TIMESWIPE_ASSERT(channel < max_channel_count);
+    constexpr std::uint64_t half_periods[]{480, 240, 120, 60};
+    constexpr std::int32_t amplitude{16384};
+    const auto half_period = half_periods[channel];
+    const auto phase = index % (2*half_period);
+    const auto ramp = static_cast<std::int32_t>(phase < half_period ?
+      phase : 2*half_period - phase);
+    const auto value = ramp * 2 * amplitude / static_cast<std::int32_t>(half_period)
+      - amplitude;
+    return static_cast<std::uint16_t>(chunk_code_offset + value);
+  }
+
+private:
+  Chunk next_chunk(const std::uint64_t index) noexcept override
+  {
+    Chunk_codes codes;
+    for (unsigned i{}; i < codes.size(); ++i)
+      codes[i] = code(i, index);
+    return encode_chunk(codes);
+  }
+
+  void skip_chunks(std::uint64_t, std::uint64_t) noexcept override
+  {}
+};
+
+/**
+ * @brief A source of data read from file.
+ *
+ * @details The file must contain the chunks in the order they were read from
+ * the board (8 bytes per chunk). The file is replayed from the beginning when
+ * its end is reached.
+ */
+class Replay_acquisition_source final : public Paced_acquisition_source {
+public:
+  /// The constructor.
+  explicit Replay_acquisition_source(std::filesystem::path path,
+    const int sample_rate = 48000, const double speed = 1)
+    : Paced_acquisition_source{sample_rate, speed}
+    , path_{std::move(path)}
+    , buffer_(4096)
+  {}
+
+  void initialize() override
+  {
+    if (file_.is_open())
+      return;
+
+    file_.open(path_, std::ios_base::in | std::ios_base::binary);
+    if (!file_)
+      throw Exception{std::string{"cannot open replay file "}
+        .append(path_.string())};
+    fill_buffer();
+    if (!buffer_size_)
+      throw Exception{std::string{"no chunks in replay file "}
+        .append(path_.string())};
+  }
+
+private:
+  std::filesystem::path path_;
+  std::ifstream file_;
+  std::vector<Chunk> buffer_;
+  std::size_t buffer_size_{};
+  std::size_t buffer_offset_{};
+
+  Chunk next_chunk(std::uint64_t) noexcept override
+  {
+    if (buffer_offset_ == buffer_size_) {
+      fill_buffer();
+      if (!buffer_size_) {
+        file_.clear();
+        file_.seekg(0);
+        fill_buffer();
+      }
+    }
+    PANDA_TIMESWIPE_ASSERT(buffer_offset_ < buffer_size_);
+    return buffer_[buffer_offset_++];
+  }
+
+  void fill_buffer() noexcept
+  {
+    static_assert(sizeof(Chunk) == 8);
+    file_.read(reinterpret_cast<char*>(buffer_.data()),
+      buffer_.size() * sizeof(Chunk));
+    buffer_size_ = file_.gcount() / sizeof(Chunk);
+    buffer_offset_ = 0;
+  }
+};
+
+} // namespace panda::timeswipe::detail
+
+#endif  // PANDA_TIMESWIPE_ACQUISITION_HPP
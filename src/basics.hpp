@@ -65,6 +65,140 @@ constexpr const char* to_literal(const Measurement_mode value) noexcept
   return nullptr;
 }
 
+// -----------------------------------------------------------------------------
+// Wakeup_policy
+// -----------------------------------------------------------------------------
+
+/// The policy of waking up the data processing thread.
+enum class Wakeup_policy {
+  /// Wake up as soon as any data is read from the board.
+  low_latency,
+
+  /// Wake up when the data enough to fill the burst buffer is read.
+  low_cpu
+};
+
+/**
+ * @returns The value of type `Wakeup_policy` converted from `value`, or
+ * `std::nullopt` if `value` doesn't corresponds to any member of Wakeup_policy.
+ */
+constexpr std::optional<Wakeup_policy> to_wakeup_policy(const
+  std::string_view value) noexcept
+{
+  if (value == "low_latency") return Wakeup_policy::low_latency;
+  else if (value == "low_cpu") return Wakeup_policy::low_cpu;
+  else return {};
+}
+
+/**
+ * @returns The character literal converted from `value`, or `nullptr`
+ * if `value` doesn't corresponds to any member of Wakeup_policy.
+ */
+constexpr const char* to_literal(const Wakeup_policy value) noexcept
+{
+  switch (value) {
+  case Wakeup_policy::low_latency: return "low_latency";
+  case Wakeup_policy::low_cpu: return "low_cpu";
+  }
+  return nullptr;
+}
+
+// -----------------------------------------------------------------------------
+// Overflow_policy
+// -----------------------------------------------------------------------------
+
+/// The policy of handling the overflow of the bounded buffer of the driver.
+enum class Overflow_policy {
+  /// Wait until the data is read from the buffer (backpressure).
+  block,
+
+  /// Discard the oldest data of the buffer to make room for the new data.
+  drop_oldest,
+
+  /// Discard the new data which doesn't fit into the buffer.
+  drop_newest,
+
+  /**
+   * Append the new data to the newest data of the buffer to be handled at
+   * once. (Applicable to the handler queue only.)
+   */
+  coalesce
+};
+
+/**
+ * @returns The value of type `Overflow_policy` converted from `value`, or
+ * `std::nullopt` if `value` doesn't corresponds to any member of
+ * Overflow_policy.
+ */
+constexpr std::optional<Overflow_policy> to_overflow_policy(const
+  std::string_view value) noexcept
+{
+  if (value == "block") return Overflow_policy::block;
+  else if (value == "drop_oldest") return Overflow_policy::drop_oldest;
+  else if (value == "drop_newest") return Overflow_policy::drop_newest;
+  else if (value == "coalesce") return Overflow_policy::coalesce;
+  else return {};
+}
+
+/**
+ * @returns The character literal converted from `value`, or `nullptr`
+ * if `value` doesn't corresponds to any member of Overflow_policy.
+ */
+constexpr const char* to_literal(const Overflow_policy value) noexcept
+{
+  switch (value) {
+  case Overflow_policy::block: return "block";
+  case Overflow_policy::drop_oldest: return "drop_oldest";
+  case Overflow_policy::drop_newest: return "drop_newest";
+  case Overflow_policy::coalesce: return "coalesce";
+  }
+  return nullptr;
+}
+
+// -----------------------------------------------------------------------------
+// Scheduling_policy
+// -----------------------------------------------------------------------------
+
+/// The scheduling policy of the driver threads.
+enum class Scheduling_policy {
+  /// The default time-sharing policy (`SCHED_OTHER`).
+  other,
+
+  /// The real-time first-in, first-out policy (`SCHED_FIFO`).
+  fifo,
+
+  /// The real-time round-robin policy (`SCHED_RR`).
+  round_robin
+};
+
+/**
+ * @returns The value of type `Scheduling_policy` converted from `value`, or
+ * `std::nullopt` if `value` doesn't corresponds to any member of
+ * Scheduling_policy.
+ */
+constexpr std::optional<Scheduling_policy> to_scheduling_policy(const
+  std::string_view value) noexcept
+{
+  if (value == "other") return Scheduling_policy::other;
+  else if (value == "fifo") return Scheduling_policy::fifo;
+  else if (value == "round_robin") return Scheduling_policy::round_robin;
+  else return {};
+}
+
+/**
+ * @returns The character literal converted from `value`, or `nullptr`
+ * if `value` doesn't corresponds to any member of Scheduling_policy.
+ */
+constexpr const char* to_literal(const Scheduling_policy value) noexcept
+{
+  switch (value) {
+  case Scheduling_policy::other: return "other";
+  case Scheduling_policy::fifo: return "fifo";
+  case Scheduling_policy::round_robin: return "round_robin";
+  }
+  return nullptr;
+}
+
 } // namespace panda::timeswipe
 
 #endif  // PANDA_TIMESWIPE_BASICS_HPP
@@ -0,0 +1,384 @@
+// -*- C++ -*-
+
+// PANDA Timeswipe Project
+// Copyright (C) 2021  PANDA GmbH / Dmitry Igrishin
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "capture.hpp"
+#include "capture_format.hpp"
+#include "debug.hpp"
+#include "delta_bitpack.hpp"
+#include "exceptions.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace panda::timeswipe {
+
+// -----------------------------------------------------------------------------
+// class Capture_reader::Rep
+// -----------------------------------------------------------------------------
+
+struct Capture_reader::Rep final {
+  ~Rep()
+  {
+    if (data_)
+      ::munmap(const_cast<char*>(data_), size_);
+  }
+
+  Rep(const Rep&) = delete;
+  Rep& operator=(const Rep&) = delete;
+
+  explicit Rep(const std::string& path)
+  {
+    const int fd{::open(path.c_str(), O_RDONLY | O_CLOEXEC)};
+    if (fd < 0) {
+      const auto code = errno;
+      throw Sys_exception{code, std::string{"cannot open file "}.append(path)};
+    }
+    struct stat st{};
+    if (::fstat(fd, &st)) {
+      const auto code = errno;
+      ::close(fd);
+      throw Sys_exception{code, std::string{"cannot stat file "}.append(path)};
+    }
+    size_ = static_cast<std::size_t>(st.st_size);
+    if (size_ < sizeof(detail::capture::Header) + sizeof(detail::capture::Trailer)) {
+      ::close(fd);
+      throw Exception{Errc::capture_file_invalid,
+        std::string{"capture file is too small: "}.append(path)};
+    }
+    void* const data{::mmap(nullptr, size_, PROT_READ, MAP_SHARED, fd, 0)};
+    ::close(fd);
+    if (data == MAP_FAILED) {
+      const auto code = errno;
+      throw Sys_exception{code, std::string{"cannot map file "}.append(path)};
+    }
+    data_ = static_cast<const char*>(data);
+
+    // Validate the header.
+    const auto invalid = [&path](const char* const what)
+    {
+      return Exception{Errc::capture_file_invalid,
+        std::string{"invalid capture file "}.append(path).append(": ")
+          .append(what)};
+    };
+    std::memcpy(&header_, data_, sizeof(header_));
+    if (header_.magic != detail::capture::header_magic)
+      throw invalid("no header magic");
+    else if (header_.version != detail::capture::version)
+      throw invalid("unsupported version");
+    else if (!header_.column_count ||
+      header_.column_count > detail::max_channel_count ||
+      !header_.chunk_row_count ||
+      header_.chunk_row_count > detail::capture::max_chunk_row_count ||
+      header_.size > size_ || header_.size < metadata_offset() ||
+      header_.size - metadata_offset() < header_.metadata_size)
+      throw invalid("invalid header");
+    else if (header_.encoding != Encoding::values &&
+      header_.encoding != Encoding::delta_bitpack_codes)
+      throw invalid("unsupported encoding");
+
+    // Validate the trailer and the chunk index.
+    detail::capture::Trailer trailer;
+    std::memcpy(&trailer, data_ + size_ - sizeof(trailer), sizeof(trailer));
+    if (trailer.magic != detail::capture::trailer_magic)
+      throw invalid("no trailer magic (the recording was interrupted?)");
+    else if (trailer.index_offset < header_.size ||
+      trailer.index_offset > size_ - sizeof(trailer) ||
+      trailer.chunk_count != (size_ - sizeof(trailer) - trailer.index_offset) /
+      sizeof(detail::capture::Index_entry))
+      throw invalid("invalid trailer");
+    index_.resize(trailer.chunk_count);
+    std::memcpy(index_.data(), data_ + trailer.index_offset,
+      index_.size() * sizeof(detail::capture::Index_entry));
+    for (const auto& entry : index_) {
+      // Nothing can overflow here, since the header is validated above.
+      const auto& chunk = entry.chunk;
+      if (!chunk.row_count || chunk.row_count > header_.chunk_row_count ||
+        entry.offset < header_.size || entry.offset % sizeof(float) ||
+        entry.offset > trailer.index_offset ||
+        trailer.index_offset - entry.offset < sizeof(chunk))
+        throw invalid("invalid chunk index");
+
+      const auto max_size = detail::capture::chunk_size(header_.encoding,
+        header_.column_count, chunk.row_count) - sizeof(chunk);
+      if ((is_compressed() ? chunk.size > max_size : chunk.size != max_size) ||
+        chunk.size > trailer.index_offset - entry.offset - sizeof(chunk))
+        throw invalid("invalid chunk index");
+    }
+  }
+
+  using Encoding = detail::capture::Encoding;
+
+  /// @returns The offset of the metadata from the begin of the file.
+  std::size_t metadata_offset() const noexcept
+  {
+    return sizeof(header_) + header_.column_count *
+      sizeof(detail::capture::Value_transform);
+  }
+
+  /// @returns `true` if the chunks contain the compressed codes.
+  bool is_compressed() const noexcept
+  {
+    return header_.encoding == Encoding::delta_bitpack_codes;
+  }
+
+  /// @returns The number of rows of the chunk which were read before `time`.
+  std::size_t row_count_before(const detail::capture::Chunk_header& chunk,
+    const System_time time) const noexcept
+  {
+    const auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+      time.time_since_epoch()).count();
+    const std::int64_t row_count{chunk.row_count};
+    if (ns <= chunk.first_read_time)
+      return 0;
+    else if (ns > chunk.last_read_time)
+      return chunk.row_count;
+
+    /*
+     * Find the least row whose time is not less than `time`, where the time of
+     * the row is interpolated as by Driver::Data_info::read_system_time().
+     */
+    const auto duration = chunk.last_read_time - chunk.first_read_time;
+    const auto offset = ns - chunk.first_read_time;
+    return static_cast<std::size_t>(std::min(row_count,
+        (offset * (row_count - 1) + duration - 1) / duration));
+  }
+
+  Data_view chunk(const std::size_t index, const std::size_t offset,
+    const std::size_t count) const noexcept
+  {
+    PANDA_TIMESWIPE_ASSERT(!is_compressed());
+    PANDA_TIMESWIPE_ASSERT(index < index_.size());
+    const auto& entry = index_[index];
+    const auto* const columns = reinterpret_cast<const float*>(data_ +
+      entry.offset + sizeof(detail::capture::Chunk_header));
+    return Data_view{columns + offset, header_.column_count, count,
+      entry.chunk.row_count};
+  }
+
+  /// Decodes the codes of the chunk of the given `index` to `codes`.
+  void decode(const std::size_t index, std::uint16_t* codes) const
+  {
+    PANDA_TIMESWIPE_ASSERT(is_compressed());
+    PANDA_TIMESWIPE_ASSERT(index < index_.size());
+    const auto& entry = index_[index];
+    const auto* in = reinterpret_cast<const unsigned char*>(data_ +
+      entry.offset + sizeof(detail::capture::Chunk_header));
+    auto size = std::size_t{entry.chunk.size};
+    for (std::size_t c{}; c < header_.column_count; ++c) {
+      const auto consumed = detail::delta_bitpack::decode(in, size, codes,
+        entry.chunk.row_count);
+      if (!consumed)
+        throw Exception{Errc::capture_file_invalid,
+          "invalid compressed capture chunk"};
+      in += consumed;
+      size -= consumed;
+      codes += entry.chunk.row_count;
+    }
+  }
+
+  /**
+   * @brief Calls `f(index, offset, count)` for each chunk with the rows read
+   * in the time range `[first, last)`.
+   */
+  template<class F>
+  void for_each_chunk(const System_time first, const System_time last, F&& f) const
+  {
+    const auto ns = [](const System_time time)
+    {
+      return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        time.time_since_epoch()).count();
+    };
+
+    // Skip the chunks which were read entirely before `first`.
+    const auto b = std::partition_point(index_.cbegin(), index_.cend(),
+      [t = ns(first)](const auto& entry){ return entry.chunk.last_read_time < t; });
+    for (auto i = b; i != index_.cend(); ++i) {
+      if (i->chunk.first_read_time >= ns(last))
+        break;
+
+      const auto offset = row_count_before(i->chunk, first);
+      const auto end = row_count_before(i->chunk, last);
+      if (offset < end)
+        f(static_cast<std::size_t>(i - index_.cbegin()), offset, end - offset);
+    }
+  }
+
+  const char* data_{};
+  std::size_t size_{};
+  detail::capture::Header header_;
+  std::vector<detail::capture::Index_entry> index_;
+};
+
+// -----------------------------------------------------------------------------
+// class Capture_reader
+// -----------------------------------------------------------------------------
+
+Capture_reader::~Capture_reader() = default;
+
+Capture_reader::Capture_reader(Capture_reader&&) = default;
+
+Capture_reader& Capture_reader::operator=(Capture_reader&&) = default;
+
+Capture_reader::Capture_reader(const std::string& path)
+  : rep_{std::make_unique<Rep>(path)}
+{}
+
+int Capture_reader::sample_rate() const noexcept
+{
+  return static_cast<int>(rep_->header_.sample_rate);
+}
+
+std::size_t Capture_reader::column_count() const noexcept
+{
+  return rep_->header_.column_count;
+}
+
+std::size_t Capture_reader::chunk_row_count() const noexcept
+{
+  return rep_->header_.chunk_row_count;
+}
+
+std::string_view Capture_reader::metadata() const noexcept
+{
+  return {rep_->data_ + rep_->metadata_offset(), rep_->header_.metadata_size};
+}
+
+std::vector<Driver::Value_transform> Capture_reader::value_transforms() const
+{
+  std::vector<Driver::Value_transform> result(column_count());
+  for (std::size_t i{}; i < result.size(); ++i) {
+    detail::capture::Value_transform transform;
+    std::memcpy(&transform, rep_->data_ + sizeof(detail::capture::Header) +
+      i*sizeof(transform), sizeof(transform));
+    result[i] = {transform.code_offset, transform.scale, transform.offset};
+  }
+  return result;
+}
+
+bool Capture_reader::is_compressed() const noexcept
+{
+  return rep_->is_compressed();
+}
+
+std::size_t Capture_reader::chunk_count() const noexcept
+{
+  return rep_->index_.size();
+}
+
+auto Capture_reader::chunk_info(const std::size_t index) const -> Chunk_info
+{
+  if (!(index < chunk_count()))
+    throw Exception{"cannot get capture chunk info by invalid index"};
+
+  const auto& chunk = rep_->index_[index].chunk;
+  using std::chrono::nanoseconds;
+  return {chunk.sample_index, chunk.row_count,
+    System_time{std::chrono::duration_cast<System_time::duration>(
+        nanoseconds{chunk.first_read_time})},
+    System_time{std::chrono::duration_cast<System_time::duration>(
+        nanoseconds{chunk.last_read_time})}};
+}
+
+auto Capture_reader::chunk(const std::size_t index) const -> Data_view
+{
+  if (!(index < chunk_count()))
+    throw Exception{"cannot get capture chunk by invalid index"};
+  else if (is_compressed())
+    throw Exception{"cannot get view of compressed capture chunk"};
+
+  return rep_->chunk(index, 0, rep_->index_[index].chunk.row_count);
+}
+
+auto Capture_reader::chunk_codes(const std::size_t index) const -> Raw_data
+{
+  if (!(index < chunk_count()))
+    throw Exception{"cannot get capture chunk by invalid index"};
+  else if (!is_compressed())
+    throw Exception{"cannot get codes of uncompressed capture chunk"};
+
+  const std::size_t row_count{rep_->index_[index].chunk.row_count};
+  std::vector<std::uint16_t> codes(column_count() * row_count);
+  rep_->decode(index, codes.data());
+  Raw_data result(column_count());
+  result.append_generated_rows(row_count,
+    [&codes, row_count](const std::size_t column, std::uint16_t* const out)
+    {
+      const auto* const data = codes.data() + column*row_count;
+      std::copy(data, data + row_count, out);
+    });
+  return result;
+}
+
+auto Capture_reader::view(const System_time first,
+  const System_time last) const -> std::vector<Data_view>
+{
+  if (is_compressed())
+    throw Exception{"cannot get view of compressed capture file"};
+
+  std::vector<Data_view> result;
+  rep_->for_each_chunk(first, last,
+    [this, &result](const auto index, const auto offset, const auto count)
+    {
+      result.push_back(rep_->chunk(index, offset, count));
+    });
+  return result;
+}
+
+Table<float> Capture_reader::read(const System_time first,
+  const System_time last) const
+{
+  Table<float> result(column_count());
+  if (!is_compressed()) {
+    for (const auto& view : this->view(first, last)) {
+      result.append_generated_rows(view.row_count(),
+        [&view](const std::size_t column, float* const out)
+        {
+          const auto data = view.column(column);
+          std::copy(data.begin(), data.end(), out);
+        });
+    }
+  } else {
+    // Decode the codes and transform them exactly as the driver does.
+    const auto transforms = value_transforms();
+    std::vector<std::uint16_t> codes(column_count() * chunk_row_count());
+    rep_->for_each_chunk(first, last,
+      [&](const auto index, const auto offset, const auto count)
+      {
+        const std::size_t row_count{rep_->index_[index].chunk.row_count};
+        rep_->decode(index, codes.data());
+        result.append_generated_rows(count,
+          [&](const std::size_t column, float* const out)
+          {
+            const auto* const data = codes.data() + column*row_count + offset;
+            const auto [code_offset, scale, value_offset] = transforms[column];
+            for (std::size_t i{}; i < count; ++i)
+              out[i] = static_cast<float>(data[i] - code_offset) * scale + value_offset;
+          });
+      });
+  }
+  return result;
+}
+
+} // namespace panda::timeswipe
@@ -0,0 +1,209 @@
+// -*- C++ -*-
+
+// PANDA Timeswipe Project
+// Copyright (C) 2021  PANDA GmbH / Dmitry Igrishin
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef PANDA_TIMESWIPE_CAPTURE_HPP
+#define PANDA_TIMESWIPE_CAPTURE_HPP
+
+#include "driver.hpp"
+#include "table.hpp"
+#include "table_view.hpp"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace panda::timeswipe {
+
+/**
+ * @brief The reader of the capture file.
+ *
+ * @details The file is memory-mapped, so only the header and the chunk index
+ * are read upon construction, while the chunks are paged in on access.
+ *
+ * The capture file (see Recorder_format::capture and
+ * Recorder_format::compressed_capture) consists of the header, the chunks, the
+ * chunk index and the trailer. All the numbers are of the native byte order
+ * (little-endian on the supported platforms), and the values are 32-bit IEEE
+ * 754 floats. The parts of the file are as follows:
+ *   -# the header of 40 bytes: the magic `TSWCAP01` (8 bytes), the version of
+ *   the format (u32, currently 2), the size of the header including the value
+ *   transforms, the metadata and the padding (u32), the column count (u32), the
+ *   maximum row count of the chunk (u32), the sample rate (u32), the size of
+ *   the metadata (u32), the encoding of the columns (u32: 0 - the values, 1 -
+ *   the compressed codes) and the reserved field (u32);
+ *   -# the value transforms: the code offset (i32), the scale and the offset
+ *   (floats) per column (see Driver::value_transforms());
+ *   -# the metadata: the JSON object with members `sampleRate`,
+ *   `boardSettings`, `driverSettings` and `calibrationSlopes` (see
+ *   Board_settings::to_json_text(), Driver_settings::to_json_text()) padded
+ *   with zeros up to the size of the header (multiple of 4096);
+ *   -# the chunks, each of which consists of the chunk header of 32 bytes:
+ *   the index of the first sample (u64), the time at which the first and the
+ *   last samples were read (i64 nanoseconds since the Unix epoch, each), the
+ *   row count (u32) and the size of the columns in bytes (u32), followed by the
+ *   columns of the chunk one after another. The chunks may be separated by the
+ *   padding;
+ *   -# the chunk index: the entry of 40 bytes per chunk in order of the file,
+ *   each of which consists of the offset of the chunk from the begin of the
+ *   file (u64) followed by the copy of the chunk header;
+ *   -# the trailer of 24 bytes: the offset of the chunk index (u64), the
+ *   chunk count (u64) and the magic `TSWCIDX1` (8 bytes).
+ *
+ * The compressed column consists of the first code (u16) followed by the
+ * blocks of 64 deltas between the adjacent codes. The delta is taken modulo
+ * 2^16 and zigzag-encoded (`(d << 1) ^ (d >> 15)` of the signed 16-bit delta
+ * `d`). Each block is the bit width of its widest delta (u8) followed by the
+ * 64 deltas of that width, packed from the least significant bit of the first
+ * byte. The last block is padded with zero deltas.
+ *
+ * The rows of the chunk are the contiguous samples, so the chunk is closed
+ * upon the loss of the data. The read time of the row is linearly interpolated
+ * between the read times of the first and the last rows of the chunk (see
+ * Driver::Data_info::read_system_time()).
+ *
+ * @see Driver::add_recorder().
+ */
+class Capture_reader final {
+public:
+  /// An alias of the time point of `CLOCK_REALTIME`.
+  using System_time = std::chrono::system_clock::time_point;
+
+  /// An alias of the read-only view of data.
+  using Data_view = Table_view<float>;
+
+  /// An alias of the raw data.
+  using Raw_data = Driver::Raw_data;
+
+  /// The information about the chunk.
+  struct Chunk_info final {
+    /// The index of the first sample of the chunk.
+    std::uint64_t sample_index{};
+
+    /// The number of samples (rows) of the chunk.
+    std::size_t row_count{};
+
+    /// The time at which the first sample of the chunk was read.
+    System_time first_read_time{};
+
+    /// The time at which the last sample of the chunk was read.
+    System_time last_read_time{};
+  };
+
+  /// The destructor. Unmaps the file.
+  ~Capture_reader();
+
+  /// Non copy-constructible.
+  Capture_reader(const Capture_reader&) = delete;
+
+  /// Non copy-assignable.
+  Capture_reader& operator=(const Capture_reader&) = delete;
+
+  /// Move-constructible.
+  Capture_reader(Capture_reader&&);
+
+  /// Move-assignable.
+  Capture_reader& operator=(Capture_reader&&);
+
+  /**
+   * @brief The constructor. Maps the file of the given `path` into memory.
+   *
+   * @throws Exception with the code `Errc::capture_file_invalid` if the file
+   * isn't the valid capture file, or Sys_exception on failure of the I/O.
+   */
+  explicit Capture_reader(const std::string& path);
+
+  /// @returns The sample rate of the data.
+  int sample_rate() const noexcept;
+
+  /// @returns The number of columns (channels) of the data.
+  std::size_t column_count() const noexcept;
+
+  /// @returns The maximum number of rows of the chunk.
+  std::size_t chunk_row_count() const noexcept;
+
+  /// @returns The metadata (JSON text).
+  std::string_view metadata() const noexcept;
+
+  /// @returns The value transforms of the columns.
+  std::vector<Driver::Value_transform> value_transforms() const;
+
+  /// @returns `true` if the chunks contain the compressed codes of the ADC.
+  bool is_compressed() const noexcept;
+
+  /// @returns The number of chunks.
+  std::size_t chunk_count() const noexcept;
+
+  /**
+   * @returns The information about the chunk of the given `index`.
+   *
+   * @par Requires
+   * `index < chunk_count()`.
+   */
+  Chunk_info chunk_info(std::size_t index) const;
+
+  /**
+   * @returns The view of the data of the chunk of the given `index`.
+   *
+   * @par Requires
+   * `index < chunk_count() && !is_compressed()`.
+   *
+   * @warning The view is valid only as long as this instance is alive.
+   */
+  Data_view chunk(std::size_t index) const;
+
+  /**
+   * @returns The decoded codes of the chunk of the given `index`.
+   *
+   * @par Requires
+   * `index < chunk_count() && is_compressed()`.
+   */
+  Raw_data chunk_codes(std::size_t index) const;
+
+  /**
+   * @returns The views of the data read in the time range `[first, last)`,
+   * one view per chunk (since the chunks aren't adjacent in the file).
+   *
+   * @par Requires
+   * `!is_compressed()`.
+   *
+   * @remarks The chunks are found by the binary search in the chunk index.
+   *
+   * @warning The views are valid only as long as this instance is alive.
+   */
+  std::vector<Data_view> view(System_time first, System_time last) const;
+
+  /**
+   * @returns The copy of the data read in the time range `[first, last)`.
+   *
+   * @details The compressed codes are decoded and transformed to the values
+   * by value_transforms(), so the result is exactly as it'd be by the driver.
+   */
+  Table<float> read(System_time first, System_time last) const;
+
+private:
+  struct Rep;
+  std::unique_ptr<Rep> rep_;
+};
+
+} // namespace panda::timeswipe
+
+#endif  // PANDA_TIMESWIPE_CAPTURE_HPP
@@ -0,0 +1,141 @@
+// -*- C++ -*-
+
+// PANDA Timeswipe Project
+// Copyright (C) 2021  PANDA GmbH / Dmitry Igrishin
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+/**
+ * @file
+ *
+ * @brief The on-disk structures of the capture file.
+ *
+ * @details See Capture_reader for the description of the format.
+ */
+
+#ifndef PANDA_TIMESWIPE_CAPTURE_FORMAT_HPP
+#define PANDA_TIMESWIPE_CAPTURE_FORMAT_HPP
+
+#include "delta_bitpack.hpp"
+#include "limits.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+
+namespace panda::timeswipe::detail::capture {
+
+/// The magic of the file header.
+constexpr std::array<char, 8> header_magic{'T','S','W','C','A','P','0','1'};
+
+/// The magic of the file trailer.
+constexpr std::array<char, 8> trailer_magic{'T','S','W','C','I','D','X','1'};
+
+/// The version of the format.
+constexpr std::uint32_t version{2};
+
+/// The encoding of the columns of the chunks.
+enum class Encoding : std::uint32_t {
+  /// The values as floats.
+  values = 0,
+
+  /// The codes of the ADC encoded by delta_bitpack::encode().
+  delta_bitpack_codes = 1
+};
+
+/**
+ * @brief The file header, which is followed by the value transforms (the
+ * code offset, the scale and the offset for each column) and the metadata
+ * (JSON text).
+ */
+struct Header final {
+  std::array<char, 8> magic{header_magic};
+  std::uint32_t version{capture::version};
+  std::uint32_t size{}; // including the metadata and the padding
+  std::uint32_t column_count{};
+  std::uint32_t chunk_row_count{}; // the maximum row count of the chunk
+  std::uint32_t sample_rate{};
+  std::uint32_t metadata_size{};
+  Encoding encoding{Encoding::values};
+  std::uint32_t reserved{};
+};
+
+/// The value transform of the column: `(code - code_offset) * scale + offset`.
+struct Value_transform final {
+  std::int32_t code_offset{};
+  float scale{1};
+  float offset{};
+};
+
+/// The chunk header, which is followed by the columns of the chunk.
+struct Chunk_header final {
+  std::uint64_t sample_index{};
+  std::int64_t first_read_time{}; // ns since the epoch of CLOCK_REALTIME
+  std::int64_t last_read_time{}; // ns since the epoch of CLOCK_REALTIME
+  std::uint32_t row_count{};
+  std::uint32_t size{}; // of the columns (in bytes)
+};
+
+/// The entry of the chunk index.
+struct Index_entry final {
+  std::uint64_t offset{}; // of the chunk header from the begin of the file
+  Chunk_header chunk;
+};
+
+/// The file trailer, which follows the chunk index.
+struct Trailer final {
+  std::uint64_t index_offset{};
+  std::uint64_t chunk_count{};
+  std::array<char, 8> magic{trailer_magic};
+};
+
+static_assert(std::is_trivially_copyable_v<Header> && sizeof(Header) == 40);
+static_assert(std::is_trivially_copyable_v<Value_transform> && sizeof(Value_transform) == 12);
+static_assert(std::is_trivially_copyable_v<Chunk_header> && sizeof(Chunk_header) == 32);
+static_assert(std::is_trivially_copyable_v<Index_entry> && sizeof(Index_entry) == 40);
+static_assert(std::is_trivially_copyable_v<Trailer> && sizeof(Trailer) == 24);
+
+/// The alignment of the compressed chunk.
+constexpr std::size_t compressed_chunk_alignment{8};
+
+/**
+ * The maximum row count of the chunk, so the size of the chunk of
+ * `max_channel_count` columns fits into both `Chunk_header::size` and
+ * `std::size_t` of 32 bits.
+ */
+constexpr std::uint32_t max_chunk_row_count{
+  (std::numeric_limits<std::uint32_t>::max() - 4096) /
+  (max_channel_count * sizeof(float))};
+
+/**
+ * @returns The (maximum) size of the chunk of `row_count` rows of
+ * `column_count` columns of the given `encoding`. (The compressed chunk is
+ * padded up to `compressed_chunk_alignment`.)
+ */
+constexpr std::size_t chunk_size(const Encoding encoding,
+  const std::size_t column_count, const std::size_t row_count) noexcept
+{
+  if (encoding == Encoding::values)
+    return sizeof(Chunk_header) + column_count * row_count * sizeof(float);
+
+  const auto size = column_count * delta_bitpack::max_encoded_size(row_count);
+  return sizeof(Chunk_header) + (size + compressed_chunk_alignment - 1) /
+    compressed_chunk_alignment * compressed_chunk_alignment;
+}
+
+} // namespace panda::timeswipe::detail::capture
+
+#endif  // PANDA_TIMESWIPE_CAPTURE_FORMAT_HPP
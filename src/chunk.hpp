@@ -0,0 +1,209 @@
+// -*- C++ -*-
+
+// PANDA Timeswipe Project
+// Copyright (C) 2021  PANDA GmbH / Dmitry Igrishin
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+/**
+ * @file
+ *
+ * @remarks The code of this file is exception-free!
+ */
+
+#ifndef PANDA_TIMESWIPE_CHUNK_HPP
+#define PANDA_TIMESWIPE_CHUNK_HPP
+
+#include "limits.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace panda::timeswipe::detail {
+
+/**
+ * @brief A chunk of the data set as it comes from the board.
+ *
+ * @details Each chunk carries one 16-bit code of each of the four channels.
+ *
+ * Chunk Layout
+ * ------+----------------------------+---------------------------
+ *  Byte | Bit7   Bit6   Bit5   Bit4  | Bit3   Bit2   Bit1   Bit0
+ * ------+----------------------------+---------------------------
+ *     0 | 1-14   2-14   3-14   4-14  | 1-15   2-15   3-15   4-15
+ *     1 | 1-12   2-12   3-12   4-12  | 1-13   2-13   3-13   4-13
+ *     2 | 1-10   2-10   3-10   4-10  | 1-11   2-11   3-11   4-11
+ *     3 |  1-8    2-8    3-8    4-8  |  1-9    2-9    3-9    4-9
+ *     4 |  1-6    2-6    3-6    4-6  |  1-7    2-7    3-7    4-7
+ *     5 |  1-4    2-4    3-4    4-4  |  1-5    2-5    3-5    4-5
+ *     6 |  1-2    2-2    3-2    4-2  |  1-3    2-3    3-3    4-3
+ *     7 |  1-0    2-0    3-0    4-0  |  1-1    2-1    3-1    4-1
+ */
+using Chunk = std::array<std::uint8_t, 8>;
+
+/// An alias of the channel codes carried by a chunk.
+using Chunk_codes = std::array<std::uint16_t, max_channel_count>;
+
+/// The code which corresponds to zero.
+constexpr std::uint16_t chunk_code_offset{32768};
+
+/// @returns The channel codes unpacked from `chunk`.
+inline Chunk_codes decode_chunk(const Chunk& chunk) noexcept
+{
+  Chunk_codes result{};
+  constexpr auto set_bit = [](std::uint16_t& word, const std::uint8_t N, const bool bit) noexcept
+  {
+    word = (word & ~(1UL << N)) | (bit << N);
+  };
+  constexpr auto bit = [](const std::uint8_t byte, const std::uint8_t N) noexcept -> bool
+  {
+    return (byte & (1UL << N));
+  };
+  for (std::size_t i{}, count{}; i < chunk.size(); ++i) {
+    set_bit(result[0], 15 - count, bit(chunk[i], 3));
+    set_bit(result[1], 15 - count, bit(chunk[i], 2));
+    set_bit(result[2], 15 - count, bit(chunk[i], 1));
+    set_bit(result[3], 15 - count, bit(chunk[i], 0));
+    count++;
+
+    set_bit(result[0], 15 - count, bit(chunk[i], 7));
+    set_bit(result[1], 15 - count, bit(chunk[i], 6));
+    set_bit(result[2], 15 - count, bit(chunk[i], 5));
+    set_bit(result[3], 15 - count, bit(chunk[i], 4));
+    count++;
+  }
+  return result;
+}
+
+/**
+ * @returns The chunk packed from `codes`.
+ *
+ * @par Effects
+ * `(decode_chunk(encode_chunk(codes)) == codes)`.
+ */
+inline Chunk encode_chunk(const Chunk_codes& codes) noexcept
+{
+  Chunk result{};
+  for (std::size_t i{}; i < result.size(); ++i) {
+    const auto hi = 15 - 2*i; // goes to the low nibble
+    const auto lo = hi - 1; // goes to the high nibble
+    std::uint8_t byte{};
+    for (std::size_t c{}; c < codes.size(); ++c) {
+      byte |= ((codes[c] >> hi) & 1U) << (3 - c);
+      byte |= ((codes[c] >> lo) & 1U) << (7 - c);
+    }
+    result[i] = byte;
+  }
+  return result;
+}
+
+// -----------------------------------------------------------------------------
+// Batch decoding
+// -----------------------------------------------------------------------------
+
+/// An alias of the array of pointers to the columns of codes.
+using Chunk_code_columns = std::array<std::uint16_t*, max_channel_count>;
+
+/**
+ * @brief Decodes `count` chunks starting from `chunks` into the `columns`.
+ *
+ * @details This is the reference implementation of batch decoding, which is
+ * based on decode_chunk().
+ *
+ * @par Requires
+ * Each of the `columns` must have room for `count` codes.
+ */
+inline void decode_chunks_reference(const Chunk* const chunks,
+  const std::size_t count, const Chunk_code_columns& columns) noexcept
+{
+  for (std::size_t i{}; i < count; ++i) {
+    const auto codes = decode_chunk(chunks[i]);
+    for (std::size_t c{}; c < codes.size(); ++c)
+      columns[c][i] = codes[c];
+  }
+}
+
+namespace chunk_lut {
+
+/**
+ * @returns The table which maps the byte of chunk to the four 16-bit lanes
+ * (one per channel), each of which holds the two bits of the channel code
+ * carried by the byte in the two least significant bits.
+ */
+constexpr std::array<std::uint64_t, 256> make_lanes() noexcept
+{
+  std::array<std::uint64_t, 256> result{};
+  for (unsigned b{}; b < result.size(); ++b) {
+    std::uint64_t lanes{};
+    for (unsigned c{}; c < max_channel_count; ++c) {
+      const std::uint64_t hi = (b >> (3 - c)) & 1U;
+      const std::uint64_t lo = (b >> (7 - c)) & 1U;
+      lanes |= ((hi << 1) | lo) << (16*c);
+    }
+    result[b] = lanes;
+  }
+  return result;
+}
+
+inline constexpr auto lanes = make_lanes();
+
+} // namespace chunk_lut
+
+/**
+ * @brief Decodes `count` chunks by using the lookup table of 256 entries.
+ *
+ * @details Each byte of chunk is mapped to the two bits of each of the four
+ * codes packed in 64-bit word (SWAR), so the chunk is decoded by using just
+ * eight lookups, shifts and ORs.
+ *
+ * @see decode_chunks_reference().
+ */
+inline void decode_chunks_lut(const Chunk* const chunks,
+  const std::size_t count, const Chunk_code_columns& columns) noexcept
+{
+  static_assert(max_channel_count == 4);
+  const auto& lanes = chunk_lut::lanes;
+  for (std::size_t i{}; i < count; ++i) {
+    const auto& chunk = chunks[i];
+    const std::uint64_t acc =
+      (lanes[chunk[0]] << 14) | (lanes[chunk[1]] << 12) |
+      (lanes[chunk[2]] << 10) | (lanes[chunk[3]] <<  8) |
+      (lanes[chunk[4]] <<  6) | (lanes[chunk[5]] <<  4) |
+      (lanes[chunk[6]] <<  2) |  lanes[chunk[7]];
+    columns[0][i] = static_cast<std::uint16_t>(acc);
+    columns[1][i] = static_cast<std::uint16_t>(acc >> 16);
+    columns[2][i] = static_cast<std::uint16_t>(acc >> 32);
+    columns[3][i] = static_cast<std::uint16_t>(acc >> 48);
+  }
+}
+
+/**
+ * @brief Decodes `count` chunks starting from `chunks` into the `columns` by
+ * using the fastest implementation available on the target platform.
+ *
+ * @par Requires
+ * Each of the `columns` must have room for `count` codes.
+ *
+ * @see decode_chunks_reference().
+ */
+inline void decode_chunks(const Chunk* const chunks,
+  const std::size_t count, const Chunk_code_columns& columns) noexcept
+{
+  decode_chunks_lut(chunks, count, columns);
+}
+
+} // namespace panda::timeswipe::detail
+
+#endif  // PANDA_TIMESWIPE_CHUNK_HPP
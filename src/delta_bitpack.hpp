@@ -0,0 +1,194 @@
+// -*- C++ -*-
+
+// PANDA Timeswipe Project
+// Copyright (C) 2021  PANDA GmbH / Dmitry Igrishin
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+/**
+ * @file
+ *
+ * @brief The lossless codec of the columns of 16-bit codes.
+ *
+ * @details The column is encoded as its first code (u16) followed by the
+ * deltas between the adjacent codes, which are packed by blocks of
+ * `block_size`. The delta is taken modulo 2^16 and zigzag-encoded, so the
+ * small deltas of either sign take few bits. Each block is encoded as the bit
+ * width of its widest delta (u8) followed by `block_size` deltas of that width
+ * packed from the least significant bit of the first byte. (The last block is
+ * padded with zero deltas.) Thus, the block of the constant codes takes one
+ * byte, while the block of the arbitrary codes takes `block_size * 2 + 1`
+ * bytes.
+ */
+
+#ifndef PANDA_TIMESWIPE_DELTA_BITPACK_HPP
+#define PANDA_TIMESWIPE_DELTA_BITPACK_HPP
+
+#include "debug.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <utility>
+
+namespace panda::timeswipe::detail::delta_bitpack {
+
+/// The number of deltas of the block.
+constexpr std::size_t block_size{64};
+
+/// @returns The maximum encoded size (in bytes) of the column of `count` codes.
+constexpr std::size_t max_encoded_size(const std::size_t count) noexcept
+{
+  const auto block_count = count > 1 ? (count - 1 + block_size - 1) / block_size : 0;
+  return (count ? sizeof(std::uint16_t) : 0) + block_count * (1 + 2*block_size);
+}
+
+/// @returns The zigzag encoded `delta`.
+constexpr std::uint16_t zigzag(const std::uint16_t delta) noexcept
+{
+  const auto value = static_cast<std::int16_t>(delta);
+  return static_cast<std::uint16_t>((static_cast<unsigned>(value) << 1) ^
+    static_cast<unsigned>(value >> 15));
+}
+
+/// @returns The zigzag decoded `value`.
+constexpr std::uint16_t unzigzag(const std::uint16_t value) noexcept
+{
+  return static_cast<std::uint16_t>((value >> 1) ^ -(value & 1));
+}
+
+/**
+ * @brief Encodes `count` codes starting from `codes` to `out`.
+ *
+ * @par Requires
+ * `out` must be able to hold `max_encoded_size(count)` bytes.
+ *
+ * @returns The number of bytes written to `out`.
+ */
+inline std::size_t encode(const std::uint16_t* const codes, const std::size_t count,
+  unsigned char* const out) noexcept
+{
+  if (!count)
+    return 0;
+
+  std::memcpy(out, codes, sizeof(*codes));
+  std::size_t size{sizeof(*codes)};
+  std::array<std::uint16_t, block_size> deltas;
+  for (std::size_t i{1}; i < count; i += block_size) {
+    // Take the zigzag deltas of the block and their maximum bit width.
+    const auto n = std::min(block_size, count - i);
+    unsigned bits{};
+    for (std::size_t j{}; j < n; ++j) {
+      deltas[j] = zigzag(static_cast<std::uint16_t>(codes[i + j] - codes[i + j - 1]));
+      bits |= deltas[j];
+    }
+    std::fill(deltas.begin() + n, deltas.end(), 0);
+    unsigned width{};
+    for (; bits; bits >>= 1)
+      ++width;
+
+    // Pack the deltas.
+    out[size++] = static_cast<unsigned char>(width);
+    std::uint64_t buffer{};
+    unsigned buffer_width{};
+    for (const auto delta : deltas) {
+      buffer |= std::uint64_t{delta} << buffer_width;
+      buffer_width += width;
+      for (; buffer_width >= 8; buffer_width -= 8, buffer >>= 8)
+        out[size++] = static_cast<unsigned char>(buffer);
+    }
+    PANDA_TIMESWIPE_ASSERT(!buffer_width); // block_size * width is multiple of 8
+  }
+  PANDA_TIMESWIPE_ASSERT(size <= max_encoded_size(count));
+  return size;
+}
+
+/// Unpacks the block of deltas of the width `Width`.
+template<unsigned Width>
+inline void unpack(const unsigned char* const in,
+  std::array<std::uint16_t, block_size>& deltas) noexcept
+{
+  if constexpr (!Width)
+    deltas.fill(0);
+  else {
+    // The block of `Width` 64-bit words (plus one for the branchless reading).
+    std::array<std::uint64_t, Width + 1> words{};
+    std::memcpy(words.data(), in, Width * sizeof(std::uint64_t));
+    constexpr std::uint64_t mask{(std::uint64_t{1} << Width) - 1};
+    for (unsigned i{}; i < block_size; ++i) {
+      const unsigned bit{i * Width};
+      const unsigned word{bit / 64}, shift{bit % 64};
+      const auto value = (words[word] >> shift) |
+        (shift ? words[word + 1] << (64 - shift) : 0);
+      deltas[i] = static_cast<std::uint16_t>(value & mask);
+    }
+  }
+}
+
+/// Unpacks the block of deltas of the given `width`.
+template<unsigned ... Widths>
+inline void unpack(const unsigned width, const unsigned char* const in,
+  std::array<std::uint16_t, block_size>& deltas,
+  std::integer_sequence<unsigned, Widths...>) noexcept
+{
+  using Unpack = void(*)(const unsigned char*, std::array<std::uint16_t, block_size>&);
+  static constexpr Unpack unpacks[]{&unpack<Widths>...};
+  unpacks[width](in, deltas);
+}
+
+/**
+ * @brief Decodes `count` codes from `in` to `codes`.
+ *
+ * @par Requires
+ * `codes` must be able to hold `count` codes.
+ *
+ * @returns The number of bytes read from `in`, or `0` if the input of `size`
+ * bytes is invalid (in which case `codes` may be partially written).
+ */
+inline std::size_t decode(const unsigned char* const in, const std::size_t size,
+  std::uint16_t* const codes, const std::size_t count) noexcept
+{
+  if (!count)
+    return 0;
+  else if (size < sizeof(*codes))
+    return 0;
+
+  std::uint16_t code;
+  std::memcpy(&code, in, sizeof(code));
+  codes[0] = code;
+  std::size_t offset{sizeof(code)};
+  std::array<std::uint16_t, block_size> deltas;
+  for (std::size_t i{1}; i < count; i += block_size) {
+    if (offset >= size)
+      return 0;
+    const unsigned width{in[offset++]};
+    if (width > 16 || size - offset < width * block_size / 8)
+      return 0;
+
+    unpack(width, in + offset, deltas, std::make_integer_sequence<unsigned, 17>{});
+    offset += width * block_size / 8;
+    const auto n = std::min(block_size, count - i);
+    for (std::size_t j{}; j < n; ++j) {
+      code = static_cast<std::uint16_t>(code + unzigzag(deltas[j]));
+      codes[i + j] = code;
+    }
+  }
+  return offset;
+}
+
+} // namespace panda::timeswipe::detail::delta_bitpack
+
+#endif  // PANDA_TIMESWIPE_DELTA_BITPACK_HPP
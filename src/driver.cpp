@@ -16,18 +16,27 @@
 // You should have received a copy of the GNU General Public License
 // along with this program.  If not, see <https://www.gnu.org/licenses/>.
 
-#include "bcmlib.hpp"
+#include "acquisition.hpp"
 #include "bcmspi.hpp"
 #include "debug.hpp"
 #include "driver.hpp"
 #include "exceptions.hpp"
+#include "file_recorder.hpp"
+#include "fir_cache.hpp"
 #include "gain.hpp"
+#include "gpio_acquisition.hpp"
 #include "hat.hpp"
 #include "limits.hpp"
 #include "pidfile.hpp"
+#include "realtime.hpp"
 #include "resampler.hpp"
+#include "ring.hpp"
+#include "table_pool.hpp"
+#include "trace.hpp"
+#include "util.hpp"
 #include "version.hpp"
 #include "board_settings.cpp"
+#include "capture.cpp"
 #include "driver_settings.cpp"
 
 #include "3rdparty/dmitigr/fs/filesystem.hpp"
@@ -35,18 +44,21 @@
 #include "3rdparty/dmitigr/rajson/rajson.hpp"
 #include "3rdparty/dmitigr/str/transform.hpp"
 
-#include <boost/lockfree/spsc_queue.hpp>
-
 #include <algorithm>
 #include <array>
 #include <atomic>
 #include <chrono>
 #include <condition_variable>
+#include <cstdlib>
+#include <exception>
 #include <fstream>
+#include <limits>
 #include <mutex>
 #include <numeric>
+#include <optional>
 #include <thread>
 #include <type_traits>
+#include <variant>
 
 namespace chrono = std::chrono;
 namespace rajson = dmitigr::rajson;
@@ -72,8 +84,17 @@ public:
     , calibration_slopes_(max_channel_count())
     , translation_offsets_(max_channel_count())
     , translation_slopes_(max_channel_count())
-    , burst_buffer_(max_channel_count())
-  {}
+    , record_ring_{default_record_ring_capacity}
+    , record_gap_ring_{record_gap_ring_capacity}
+    , record_batch_ring_{record_batch_ring_capacity}
+    , records_(max_record_batch_size)
+    , decoded_records_(max_channel_count())
+  {
+    chunks_.reserve(max_data_set_size);
+    decoded_records_.reserve_rows(max_record_batch_size);
+    for (auto& codes : record_codes_)
+      codes.reserve(max_record_batch_size);
+  }
 
   iDriver& initialize() override
   {
@@ -88,53 +109,21 @@ public:
     driver_settings_.set_translation_offsets(translation_offsets_);
     driver_settings_.set_translation_slopes(translation_slopes_);
 
-    // Lock PID file.
-    pid_file_.lock();
-
-    // Initialize BCM and SPI.
-    spi_.initialize(detail::Bcm_spi::Pins::spi0);
+    // Make the acquisition source.
+    if (!source_)
+      source_ = make_acquisition_source(); // may throw
 
-    /*
-     * Initialize GPIO pins.
-     *
-     * @par Effects
-     * Restarts firmware on very first run!
-     *
-     * @warning Firmware developers must remember, that restarting the firmware
-     * causes reset of all the settings the firmware keeps in the on-board RAM!
-     */
-    if (!is_gpio_inited_) {
-      detail::setup_io();
-      init_gpio_input(gpio_data0);
-      init_gpio_input(gpio_data1);
-      init_gpio_input(gpio_data2);
-      init_gpio_input(gpio_data3);
-      init_gpio_input(gpio_data4);
-      init_gpio_input(gpio_data5);
-      init_gpio_input(gpio_data6);
-      init_gpio_input(gpio_data7);
-
-      init_gpio_input(gpio_tco);
-      init_gpio_input(gpio_pi_ok);
-      init_gpio_input(gpio_fail);
-      init_gpio_input(gpio_button);
-
-      // init_gpio_output(gpio_pi_ok);
-      init_gpio_output(gpio_clock);
-      init_gpio_output(gpio_reset);
-
-      // Initial Reset
-      set_gpio_low(gpio_clock);
-      set_gpio_high(gpio_reset);
+    if (source_->is_board_attached()) {
+      // Lock PID file.
+      pid_file_.lock();
 
-      /*
-       * On some devices delay is required to get SPI communication work.
-       * There is also delay in Bcm_spi::initialize().
-       */
-      std::this_thread::sleep_for(milliseconds{100});
+      // Initialize BCM and SPI.
+      spi_.initialize(detail::Bcm_spi::Pins::spi0);
+    } else
+      emulated_board_settings_ = default_emulated_board_settings();
 
-      is_gpio_inited_ = true;
-    }
+    // Initialize the acquisition source (GPIO pins in case of the board).
+    source_->initialize();
 
     is_initialized_ = true;
     return *this;
@@ -160,6 +149,11 @@ public:
     return 48000;
   }
 
+  int min_subscriber_sample_rate() const override
+  {
+    return 1;
+  }
+
   unsigned max_channel_count() const override
   {
     return detail::max_channel_count;
@@ -209,7 +203,10 @@ public:
     }
 
     // Attempt to apply.
-    spi_.execute_set("all", rajson::to_text(doc));
+    if (source_->is_board_attached())
+      spi_.execute_set("all", rajson::to_text(doc));
+    else
+      emulated_board_settings_.set(settings);
     return *this;
   }
 
@@ -217,20 +214,14 @@ public:
   {
     if (criteria.empty())
       criteria = "all";
+    if (source_ && !source_->is_board_attached())
+      return emulated_board_settings(criteria);
     auto doc = spi_.execute_get(criteria);
     return Board_settings{std::make_unique<Board_settings::Rep>(std::move(doc))};
   }
 
   iDriver& set_driver_settings(const Driver_settings& settings,
     const bool merge_not_null) override
-  {
-    set_driver_settings(settings, {}, merge_not_null);
-    return *this;
-  }
-
-  /// @overload
-  void set_driver_settings(const Driver_settings& settings,
-    std::unique_ptr<Resampler> resampler, const bool merge_not_null = true)
   {
     if (is_measurement_started(true))
       /*
@@ -258,6 +249,8 @@ public:
       driver_settings_.merge_not_null(settings); // may throw
     else
       driver_settings_ = settings; // may throw
+
+    return *this;
   }
 
   const Driver_settings& driver_settings() const override
@@ -267,139 +260,86 @@ public:
 
   void start_measurement(Data_handler handler) override
   {
-    if (!is_initialized())
-      throw Exception{Errc::driver_not_initialized,
-        "cannot start measurement while driver isn't initialized"};
-
-    /// @returns The calibration map from board settings.
-    static const auto calibration_map = [](const Board_settings& bs)
-    {
-      using hat::atom::Calibration;
-      hat::Calibration_map result;
-      const auto& doc = bs.rep_->doc();
-
-      // Use default slopes and offsets if the calibration data is disabled.
-      if (const auto calib_enabled = rajson::Value_view{doc}.optional("calibrationDataEnabled")) {
-        PANDA_TIMESWIPE_ASSERT(calib_enabled->value().IsBool());
-        if (!rajson::to<bool>(calib_enabled->value()))
-          return result;
-      }
-
-      // Otherwise, use slopes and offset provided by firmware.
-      const auto calib = rajson::Value_view{doc}.mandatory("calibrationData");
-      PANDA_TIMESWIPE_ASSERT(calib.value().IsArray());
-      try {
-        // "calibrationData":[{"type":%, "data":[{"slope":%, "offset":%},...]},...]
-        for (const auto& catom_v : calib.value().GetArray()) {
-          rajson::Value_view catom_view{catom_v};
-
-          // Get the calibration atom type.
-          const auto type = catom_view.mandatory<Calibration::Type>("type");
-
-          // Check that data member is array.
-          const auto& catom_data_view = catom_view.mandatory("data");
-          if (!catom_data_view.value().IsArray())
-            throw Exception{"data member is not array"};
-
-          // Get the data array and ensure it has the proper size.
-          const auto& catom_data = catom_data_view.value().GetArray();
-          const auto catom_data_size = catom_data.Size();
-          if (catom_data_size != result.atom(type).entry_count())
-            throw Exception{"invalid data member size"};
+    if (!handler)
+      throw Exception{"cannot start measurement with invalid data handler"};
+    start_measurement__(std::move(handler));
+  }
 
-          // Extract each entry with slope and offset from the data array.
-          for (std::decay_t<decltype(catom_data_size)> i{}; i < catom_data_size; ++i) {
-            const auto& catom_data_entry = catom_data[i];
-            if (!catom_data_entry.IsObject())
-              throw Exception{"data entry is not object"};
+  void start_measurement(Zero_copy, Data_view_handler handler) override
+  {
+    if (!handler)
+      throw Exception{"cannot start measurement with invalid data handler"};
+    start_measurement__(std::move(handler));
+  }
 
-            rajson::Value_view catom_data_entry_view{catom_data_entry};
-            const auto slope = catom_data_entry_view.mandatory<float>("slope");
-            const auto offset = catom_data_entry_view.mandatory<std::int16_t>("offset");
-            const Calibration::Entry entry{slope, offset};
-            result.atom(type).set_entry(i, entry);
-          }
-        }
-      } catch (const std::exception& e) {
-        throw Exception{Errc::board_settings_invalid,
-          std::string{"cannot use calibration data: "}.append(e.what())};
-      } catch (...) {
-        throw Exception{Errc::board_settings_invalid,
-          "cannot use calibration data: unknown error"};
-      }
+  void start_measurement() override
+  {
+    if (subscriptions_.empty())
+      throw Exception{"cannot start measurement without subscribers"};
+    start_measurement__({});
+  }
 
-      return result;
-    };
+  void start_measurement(Pull) override
+  {
+    start_measurement__(Handler{Data_handler{[this](Data data, int)
+    {
+      handle_read_buffer(std::move(data));
+    }}}, true);
+  }
 
-    const auto bs = board_settings();
-    const auto calib = calibration_map(bs);
-    const auto gains = channel_settings<float>(bs, "Gain");
-    const auto modes = channel_settings<Measurement_mode>(bs, "Mode");
-    const auto srate = driver_settings().sample_rate();
+  void add_subscriber(const int sample_rate, const std::size_t burst_buffer_size,
+    Data_handler handler) override
+  {
     if (!handler)
-      throw Exception{"cannot start measurement with invalid data handler"};
-    else if (is_measurement_started(true))
-      throw Exception{Errc::board_measurement_started,
-        "cannot start measurement because it's already started"};
-    else if (!gains)
-      throw Exception{Errc::board_settings_insufficient,
-        "cannot start measurement with unspecified channel gains"};
-    else if (!modes)
-      throw Exception{Errc::board_settings_insufficient,
-        "cannot start measurement with unspecified channel measurement modes"};
-    else if (!srate)
-      throw Exception{Errc::driver_settings_insufficient,
-        "cannot start measurement with unspecified sample rate"};
-
-    // Pick up the calibration slopes depending on both the gain and measurement mode.
-    const auto mcc = max_channel_count();
-    PANDA_TIMESWIPE_ASSERT(gains && modes &&
-      (gains->size() == modes->size()) &&
-      (gains->size() >= mcc));
-    // may throw
-    decltype(calibration_slopes_) new_calibration_slopes{calibration_slopes_};
-    for (std::decay_t<decltype(mcc)> i{}; i < mcc; ++i) {
-      const auto gain = gains->at(i);
-      const auto mode = modes->at(i);
-      using Ct = hat::atom::Calibration::Type;
-      using Array = std::array<Ct, detail::max_channel_count>;
-      constexpr Array v_types{Ct::v_in1, Ct::v_in2, Ct::v_in3, Ct::v_in4};
-      constexpr Array c_types{Ct::c_in1, Ct::c_in2, Ct::c_in3, Ct::c_in4};
-      const auto& types = (mode == Measurement_mode::voltage) ? v_types : c_types;
-      const auto& atom = calib.atom(types[i]);
-      const auto ogain_index = gain::ogain_table_index(gain);
-      PANDA_TIMESWIPE_ASSERT(ogain_index < atom.entry_count());
-      new_calibration_slopes[i] = atom.entry(ogain_index).slope();
-    }
-    calibration_slopes_.swap(new_calibration_slopes); // noexcept
+      throw Exception{"cannot add subscriber with invalid data handler"};
+    add_subscriber__(sample_rate, burst_buffer_size, std::move(handler));
+  }
 
-    // Reset resampler.
-    set_resampler(*srate, {}); // strong guarantee
+  void add_subscriber(const int sample_rate, const std::size_t burst_buffer_size,
+    Zero_copy, Data_view_handler handler) override
+  {
+    if (!handler)
+      throw Exception{"cannot add subscriber with invalid data handler"};
+    add_subscriber__(sample_rate, burst_buffer_size, std::move(handler));
+  }
 
-    /*
-     * Send the command to the firmware to start the measurement.
-     * Effects: the reader does receive the data from the board.
-     */
-    {
-      PANDA_TIMESWIPE_ASSERT(is_gpio_inited_);
-      std::this_thread::sleep_for(milliseconds{1});
-      spi_set_channels_adc_enabled(true);
-    }
+  void add_recorder(const int sample_rate, const std::size_t burst_buffer_size,
+    Recorder_options options) override
+  {
+    auto recorder = std::make_shared<File_recorder>(std::move(options));
+    recorder->check_chunk_size(max_channel_count());
+    if (recorder->options().format() == Recorder_format::compressed_capture) {
+      if (sample_rate != max_sample_rate())
+        throw Exception{Errc::driver_settings_invalid,
+          "cannot add compressed capture recorder with sample rate other than max"};
+      add_subscriber__(sample_rate, burst_buffer_size, Raw_data_view_handler{
+        [this, recorder = recorder.get()](const Raw_data_view& data, int)
+        {
+          recorder->write(data, data_info());
+        }});
+    } else
+      add_subscriber__(sample_rate, burst_buffer_size, Data_view_handler{
+        [this, recorder = recorder.get()](const Data_view& data, int)
+        {
+          recorder->write(data, data_info());
+        }});
+    subscriptions_.back().recorder = std::move(recorder); // noexcept
+  }
 
-    try {
-      is_threads_running_ = true;
-      is_measurement_started_ = true;
-      threads_.emplace_back(&iDriver::data_reading, this);
-      threads_.emplace_back(&iDriver::data_processing, this, std::move(handler));
-    } catch (...) {
-      is_measurement_started_ = false;
-      join_threads();
-      calibration_slopes_.swap(new_calibration_slopes); // noexcept
-      throw;
-    }
+  void add_subscriber(const std::size_t burst_buffer_size, Raw,
+    Raw_data_view_handler handler) override
+  {
+    if (!handler)
+      throw Exception{"cannot add subscriber with invalid data handler"};
+    add_subscriber__(max_sample_rate(), burst_buffer_size, std::move(handler));
+  }
 
-    // Done.
-    PANDA_TIMESWIPE_ASSERT(is_measurement_started());
+  void remove_subscribers() override
+  {
+    if (is_measurement_started())
+      throw Exception{Errc::board_measurement_started,
+        "cannot remove subscribers while measurement is started"};
+    subscriptions_.clear();
   }
 
   bool is_measurement_started(const bool ask_board = {}) const override
@@ -414,6 +354,106 @@ public:
       return is_measurement_started_;
   }
 
+  Data read(const std::size_t max_row_count, const milliseconds timeout) override
+  {
+    std::unique_lock lock{read_buffer_mutex_};
+    if (!is_read_buffer_active_)
+      throw Exception{"cannot read data of measurement not started for reading"};
+
+    const auto row_count = std::min(max_row_count, read_buffer_capacity_);
+    read_buffer_changed_.wait_for(lock, timeout, [this, row_count]
+    {
+      return read_buffer_.row_count() >= row_count || !is_threads_running_;
+    });
+    auto result = data_pool_.acquire();
+    const auto count = std::min(max_row_count, read_buffer_.row_count());
+    result.append_rows(read_buffer_, count);
+    read_buffer_.remove_begin_rows(count);
+    lock.unlock();
+    read_buffer_changed_.notify_all();
+    return result;
+  }
+
+  std::uint64_t read_lost_sample_count() const override
+  {
+    const std::lock_guard lock{read_buffer_mutex_};
+    return read_lost_sample_count_;
+  }
+
+  void recycle_data(Data&& data) override
+  {
+    data_pool_.release(std::move(data));
+  }
+
+  std::uint64_t data_allocation_count() const override
+  {
+    return data_pool_.allocation_count();
+  }
+
+  Realtime_report realtime_report() const override
+  {
+    return realtime_report_;
+  }
+
+  std::size_t queue_capacity() const override
+  {
+    return record_ring_.capacity();
+  }
+
+  std::size_t queue_high_water_mark() const override
+  {
+    return record_ring_.max_size();
+  }
+
+  void write_trace(std::ostream& out) const override
+  {
+    if (is_measurement_started())
+      throw Exception{Errc::board_measurement_started,
+        "cannot write trace while measurement is started"};
+    trace::Registry::instance().write_chrome_trace(out);
+  }
+
+  Statistics statistics() const override
+  {
+    Statistics result;
+    result.read_loop_duration = statistics_.read_loop_duration.snapshot();
+    result.read_chunk_count = statistics_.read_chunk_count.snapshot();
+    result.queue_size = record_ring_.size();
+    result.queue_capacity = record_ring_.capacity();
+    result.queue_high_water_mark = record_ring_.max_size();
+    result.resampling_duration = statistics_.resampling_duration.snapshot();
+    result.handler_duration = statistics_.handler_duration.snapshot();
+    const auto load = [](const auto& counter)
+    {
+      return counter.load(std::memory_order_relaxed);
+    };
+    result.handler_overrun_count = load(statistics_.handler_overrun_count);
+    result.dropped_batch_count = load(statistics_.dropped_batch_count);
+    result.dropped_burst_count = load(statistics_.dropped_burst_count);
+    result.handler_queue_high_water_mark =
+      load(statistics_.handler_queue_high_water_mark);
+    for (const auto& subscription : subscriptions_) {
+      if (const auto& recorder = subscription.recorder) {
+        result.recorded_byte_count += recorder->written_byte_count();
+        result.recorded_file_count += recorder->file_count();
+        result.recorder_stall_count += recorder->stall_count();
+      }
+    }
+    result.lost_sample_count = load(statistics_.lost_sample_count);
+    return result;
+  }
+
+  const Data_info& data_info() const noexcept override
+  {
+    return handled_data_info_ ? *handled_data_info_ : data_info_;
+  }
+
+  std::vector<Value_transform> value_transforms() const override
+  {
+    const auto begin = value_transforms_.cbegin();
+    return {begin, begin + max_channel_count()};
+  }
+
   void stop_measurement() override
   {
     if (!is_initialized())
@@ -424,13 +464,17 @@ public:
 
     // Wait threads and reset state they are using.
     join_threads();
-    while (record_queue_.pop());
+    record_ring_.clear();
+    record_gap_ring_.clear();
+    record_batch_ring_.clear();
     read_skip_count_ = initial_invalid_datasets_count;
+    read_pacer_.reset();
+    const auto recording_error = stop_recorders();
 
     // Send the command to the firmware to stop the measurement.
     {
       // Reset clock.
-      set_gpio_low(gpio_clock);
+      source_->stop();
 
       // Stop measurement.
       spi_set_channels_adc_enabled(false); // may throw
@@ -439,6 +483,8 @@ public:
     // Done.
     is_measurement_started_ = false;
     PANDA_TIMESWIPE_ASSERT(!is_measurement_started());
+    if (recording_error)
+      std::rethrow_exception(recording_error);
   }
 
   std::vector<float> calculate_drift_references() override
@@ -587,8 +633,9 @@ private:
 
   detail::Pid_file pid_file_;
   mutable detail::Bcm_spi spi_;
+  std::unique_ptr<Acquisition_source> source_;
+  Board_settings emulated_board_settings_;
   std::atomic_bool is_initialized_{};
-  std::atomic_bool is_gpio_inited_{};
   std::atomic_bool is_threads_running_{};
   mutable std::atomic_bool is_measurement_started_{};
 
@@ -596,66 +643,305 @@ private:
   // Measurement data
   // ---------------------------------------------------------------------------
 
+  /// An alias of the handler of any kind.
+  using Handler = std::variant<Data_handler, Data_view_handler,
+    Raw_data_view_handler>;
+
   // The number of initial invalid data sets.
   static constexpr int initial_invalid_datasets_count{32};
-  static constexpr std::uint16_t channel_offset{32768};
+  static constexpr std::uint16_t channel_offset{chunk_code_offset};
   int read_skip_count_{initial_invalid_datasets_count};
+  std::vector<Chunk> chunks_;
   std::vector<float> calibration_slopes_;
   std::vector<float> translation_offsets_;
   std::vector<float> translation_slopes_;
+  std::array<Value_transform, detail::max_channel_count> value_transforms_;
   Driver_settings driver_settings_;
-  std::unique_ptr<Resampler> resampler_;
-
-  // Record queue capacity must be enough to store records for 1s.
-  boost::lockfree::spsc_queue<Data, boost::lockfree::capacity<48000/32*2>> record_queue_;
-  std::atomic_int record_error_count_{};
-  std::size_t burst_buffer_size_{};
-  Data burst_buffer_;
-  std::vector<std::thread> threads_;
-
-  // ---------------------------------------------------------------------------
-  // Drift compensation data
-  // ---------------------------------------------------------------------------
 
-  mutable std::optional<std::vector<float>> drift_references_;
-  std::optional<std::vector<float>> drift_deltas_;
-
-  // ---------------------------------------------------------------------------
-  // RAII protectors
-  // ---------------------------------------------------------------------------
-
-  /**
-   * @brief An automatic restorer of state affected by drift calculation stuff.
-   *
-   * @details Stashed state will be restored upon destruction of the instance of
-   * this class.
+  /*
+   * The raw chunks are passed from the reading thread to the processing
+   * thread as is, so the reading thread doesn't spend time on decoding.
+   * Record ring capacity is limited by the queue memory budget, and is enough
+   * to store records for 2s by default.
    */
-  class Drift_affected_state_guard final {
-    friend iDriver;
-
-    Drift_affected_state_guard(const Drift_affected_state_guard&) = delete;
-    Drift_affected_state_guard& operator=(const Drift_affected_state_guard&) = delete;
-    Drift_affected_state_guard(Drift_affected_state_guard&&) = delete;
-    Drift_affected_state_guard& operator=(Drift_affected_state_guard&&) = delete;
+  static constexpr std::size_t default_record_ring_capacity{2*48000};
+  static constexpr std::size_t max_record_batch_size{max_data_set_size};
+  Spsc_ring<Chunk> record_ring_;
+  /*
+   * The losses of records are passed from the reading thread to the
+   * processing thread as the gaps in the stream of records. The gap is
+   * written before the records which follows it.
+   */
+  struct Record_gap final {
+    std::uint64_t position{}; // the number of records written before the gap
+    std::uint64_t lost_count{};
+  };
+  static constexpr std::size_t record_gap_ring_capacity{1024};
+  Spsc_ring<Record_gap> record_gap_ring_;
+  /*
+   * The time at which the records are read are passed from the reading thread
+   * to the processing thread by batches (one per read_data()). The batch is
+   * written before its records. The batch ring capacity must be enough to
+   * store the batches of the records of the record ring, so it's scaled
+   * along with the record ring capacity.
+   */
+  struct Read_time final {
+    Data_info::Steady_time steady;
+    Data_info::System_time system;
 
-    /// Calls restore().
-    ~Drift_affected_state_guard()
+    static Read_time now() noexcept
     {
-      restore();
+      return {std::chrono::steady_clock::now(), std::chrono::system_clock::now()};
     }
-
-    /**
-     * @brief Stores the rep state and driver settings, and prepares the board
-     * for measurement.
-     */
-    Drift_affected_state_guard(iDriver& driver) try
-      : driver_{driver}
-      , resampler_{std::move(driver_.resampler_)} // store
-      , driver_settings_{std::move(driver_.driver_settings_)} // settings
-      , board_settings_{driver_.board_settings("basic")} // store
-    {
-      /*
-       * Change input modes to `current`.
+  };
+  struct Record_batch final {
+    std::uint64_t position{}; // the number of records written before the batch
+    std::uint64_t count{};
+    Read_time first_read_time;
+    Read_time last_read_time;
+  };
+  static constexpr std::size_t record_batch_ring_capacity{4096};
+  Spsc_ring<Record_batch> record_batch_ring_;
+  /*
+   * The interval of polling the source is adapted to the number of chunks
+   * of the data sets read.
+   */
+  Read_pacer read_pacer_;
+  Read_time chunks_first_read_time_;
+  Read_time chunks_last_read_time_;
+  std::vector<Chunk> records_;
+  /*
+   * The processing thread is woken up by the reading thread when the number
+   * of records reaches the threshold, which depends on the wakeup policy.
+   */
+  static constexpr milliseconds max_record_wakeup_interval{100};
+  std::size_t record_wakeup_threshold_{1};
+  std::mutex record_mutex_;
+  std::condition_variable record_available_;
+  using Code_columns = std::array<std::vector<std::uint16_t>,
+    detail::max_channel_count>;
+  Code_columns record_codes_; // the codes of the records being processed
+  std::size_t burst_buffer_size_{};
+  /*
+   * The data buffers are taken from the pool and returned to it when they are
+   * no longer needed, so no memory is allocated in the steady state.
+   * The pool size must be enough for the data being processed (up to 3) plus
+   * the data being handled by the user.
+   */
+  static constexpr std::size_t data_pool_size{8};
+  Table_pool<float> data_pool_;
+  Table_pool<std::uint16_t> raw_data_pool_;
+  /*
+   * The data of the measurement started by start_measurement(Pull) is
+   * accumulated in the read buffer by the processing thread and taken from
+   * it by read().
+   */
+  Data read_buffer_;
+  std::size_t read_buffer_capacity_{};
+  Overflow_policy read_overflow_policy_{Overflow_policy::block};
+  std::uint64_t read_lost_sample_count_{};
+  bool is_read_buffer_active_{};
+  mutable std::mutex read_buffer_mutex_;
+  std::condition_variable read_buffer_changed_;
+  /*
+   * The records are decoded once for all the subscribers, each of which has
+   * its own burst buffer and resampler.
+   */
+  Data decoded_records_;
+  struct Subscription final {
+    int sample_rate{};
+    std::size_t burst_buffer_size{};
+    Handler handler;
+    std::shared_ptr<File_recorder> recorder; // of add_recorder() only
+  };
+  std::vector<Subscription> subscriptions_;
+  struct Subscriber final {
+    Handler handler;
+    int sample_rate{};
+    std::size_t burst_buffer_size{};
+    std::unique_ptr<Resampler> resampler;
+    Data burst_buffer;
+    Raw_data raw_burst_buffer; // of the subscriber of raw data only
+    int errors{};
+    std::uint64_t next_sample_index{};
+    std::uint64_t lost_sample_count{};
+    std::uint64_t total_lost_sample_count{};
+    Read_time first_read_time;
+    Read_time last_read_time;
+
+    bool is_raw() const noexcept
+    {
+      return std::holds_alternative<Raw_data_view_handler>(handler);
+    }
+
+    std::size_t burst_row_count() const noexcept
+    {
+      return is_raw() ? raw_burst_buffer.row_count() : burst_buffer.row_count();
+    }
+  };
+  std::vector<Subscriber> subscribers_;
+  Data_info data_info_;
+  /*
+   * If the handler queue is enabled, the bursts are passed to the handlers by
+   * the handling thread through the queue, so the processing doesn't wait for
+   * the slow handler until the queue is full. The queue is the circular
+   * buffer, which grows only if the bursts are queued beyond the capacity.
+   * The losses caused by the overflow are derived from the sample indexes of
+   * the bursts handled.
+   */
+  struct Burst final {
+    std::size_t subscriber_index{};
+    Data data;
+    Raw_data raw_data;
+    Data_info info;
+    int errors{};
+  };
+  struct Burst_delivery final {
+    std::uint64_t next_sample_index{};
+    std::uint64_t sample_count{};
+  };
+  std::vector<Burst> burst_queue_;
+  std::size_t burst_queue_begin_{};
+  std::size_t burst_queue_size_{};
+  std::size_t burst_queue_capacity_{}; // zero if the queue is disabled
+  Overflow_policy burst_queue_overflow_policy_{Overflow_policy::block};
+  bool is_burst_queue_closed_{};
+  std::vector<Burst_delivery> burst_deliveries_; // of the handling thread only
+  std::mutex burst_queue_mutex_;
+  std::condition_variable burst_queue_changed_;
+  inline static thread_local const Data_info* handled_data_info_{};
+  /*
+   * The statistics are gathered permanently, so the counters must be cheap.
+   * Each counter is written by one thread only, so it's increased by the
+   * relaxed load and store rather than the read-modify-write operation.
+   */
+  class Histogram_counter final {
+  public:
+    void add(const std::uint64_t value) noexcept
+    {
+      std::size_t bin{};
+      for (auto v = value; v && bin < Histogram::bin_count - 1; v >>= 1)
+        ++bin;
+      Statistics_counters::increase(bins_[bin], 1);
+      Statistics_counters::increase(count_, 1);
+      Statistics_counters::increase(sum_, value);
+      if (value > max_.load(std::memory_order_relaxed))
+        max_.store(value, std::memory_order_relaxed);
+    }
+
+    Histogram snapshot() const noexcept
+    {
+      Histogram result;
+      for (std::size_t i{}; i < bins_.size(); ++i)
+        result.bins[i] = bins_[i].load(std::memory_order_relaxed);
+      result.count = count_.load(std::memory_order_relaxed);
+      result.sum = sum_.load(std::memory_order_relaxed);
+      result.max = max_.load(std::memory_order_relaxed);
+      return result;
+    }
+
+    void reset() noexcept
+    {
+      for (auto& bin : bins_)
+        bin.store(0, std::memory_order_relaxed);
+      count_.store(0, std::memory_order_relaxed);
+      sum_.store(0, std::memory_order_relaxed);
+      max_.store(0, std::memory_order_relaxed);
+    }
+
+  private:
+    std::array<std::atomic<std::uint64_t>, Histogram::bin_count> bins_{};
+    std::atomic<std::uint64_t> count_{};
+    std::atomic<std::uint64_t> sum_{};
+    std::atomic<std::uint64_t> max_{};
+  };
+  struct Statistics_counters final {
+    Histogram_counter read_loop_duration; // written by reading thread
+    Histogram_counter read_chunk_count; // written by reading thread
+    Histogram_counter resampling_duration; // written by processing thread
+    Histogram_counter handler_duration; // written by handling thread
+    std::atomic<std::uint64_t> handler_overrun_count{}; // handling thread
+    std::atomic<std::uint64_t> dropped_batch_count{}; // reading thread
+    std::atomic<std::uint64_t> dropped_burst_count{}; // processing thread
+    std::atomic<std::size_t> handler_queue_high_water_mark{}; // processing thread
+    std::atomic<std::uint64_t> lost_sample_count{}; // reading thread
+
+    static void increase(std::atomic<std::uint64_t>& counter,
+      const std::uint64_t value) noexcept
+    {
+      counter.store(counter.load(std::memory_order_relaxed) + value,
+        std::memory_order_relaxed);
+    }
+
+    void reset() noexcept
+    {
+      read_loop_duration.reset();
+      read_chunk_count.reset();
+      resampling_duration.reset();
+      handler_duration.reset();
+      handler_overrun_count.store(0, std::memory_order_relaxed);
+      dropped_batch_count.store(0, std::memory_order_relaxed);
+      dropped_burst_count.store(0, std::memory_order_relaxed);
+      handler_queue_high_water_mark.store(0, std::memory_order_relaxed);
+      lost_sample_count.store(0, std::memory_order_relaxed);
+    }
+  } statistics_;
+
+  /// @returns The `duration` in microseconds.
+  template<class Rep, class Period>
+  static std::uint64_t to_microseconds(const std::chrono::duration<Rep, Period> duration) noexcept
+  {
+    const auto result = std::chrono::duration_cast<microseconds>(duration).count();
+    return result > 0 ? static_cast<std::uint64_t>(result) : 0;
+  }
+  std::optional<Record_batch> record_batch_; // the batch of last processed record
+  std::vector<std::thread> threads_;
+  Realtime_report realtime_report_;
+  bool is_memory_locked_{};
+
+  // ---------------------------------------------------------------------------
+  // Drift compensation data
+  // ---------------------------------------------------------------------------
+
+  mutable std::optional<std::vector<float>> drift_references_;
+  std::optional<std::vector<float>> drift_deltas_;
+
+  // ---------------------------------------------------------------------------
+  // RAII protectors
+  // ---------------------------------------------------------------------------
+
+  /**
+   * @brief An automatic restorer of state affected by drift calculation stuff.
+   *
+   * @details Stashed state will be restored upon destruction of the instance of
+   * this class.
+   */
+  class Drift_affected_state_guard final {
+    friend iDriver;
+
+    Drift_affected_state_guard(const Drift_affected_state_guard&) = delete;
+    Drift_affected_state_guard& operator=(const Drift_affected_state_guard&) = delete;
+    Drift_affected_state_guard(Drift_affected_state_guard&&) = delete;
+    Drift_affected_state_guard& operator=(Drift_affected_state_guard&&) = delete;
+
+    /// Calls restore().
+    ~Drift_affected_state_guard()
+    {
+      restore();
+    }
+
+    /**
+     * @brief Stores the rep state and driver settings, and prepares the board
+     * for measurement.
+     */
+    Drift_affected_state_guard(iDriver& driver) try
+      : driver_{driver}
+      , subscriptions_{std::move(driver_.subscriptions_)} // store
+      , driver_settings_{std::move(driver_.driver_settings_)} // settings
+      , board_settings_{driver_.board_settings("basic")} // store
+    {
+      /*
+       * Change input modes to `current`.
        * This will cause a "switching oscillation" appears at the output of
        * the measured value, which completely (according to PSpice) decays
        * after 1.5 ms.
@@ -682,8 +968,9 @@ private:
     void restore() noexcept
     {
       try {
-        // Restore driver settings.
-        driver_.set_driver_settings(std::move(driver_settings_), std::move(resampler_));
+        // Restore driver settings and subscriptions.
+        driver_.set_driver_settings(driver_settings_, true);
+        driver_.subscriptions_ = std::move(subscriptions_);
 
         // Restore board settings.
         driver_.set_board_settings(board_settings_);
@@ -691,222 +978,174 @@ private:
     }
 
     iDriver& driver_;
-    decltype(driver_.resampler_) resampler_;
+    decltype(driver_.subscriptions_) subscriptions_;
     decltype(driver_.driver_settings_) driver_settings_;
     Board_settings board_settings_;
     std::optional<std::vector<Measurement_mode>> chmm_;
   };
 
   // ---------------------------------------------------------------------------
-  // GPIO stuff
+  // Acquisition stuff
   // ---------------------------------------------------------------------------
 
-  // PIN NAMES
-  static constexpr std::uint8_t gpio_data0{24};  // BCM 24 - PIN 18
-  static constexpr std::uint8_t gpio_data1{25};  // BCM 25 - PIN 22
-  static constexpr std::uint8_t gpio_data2{7};   // BCM  7 - PIN 26
-  static constexpr std::uint8_t gpio_data3{5};   // BCM  5 - PIN 29
-  static constexpr std::uint8_t gpio_data4{6};   // BCM  6 - PIN 31
-  static constexpr std::uint8_t gpio_data5{12};  // BCM 12 - PIN 32
-  static constexpr std::uint8_t gpio_data6{13};  // BCM 13 - PIN 33
-  static constexpr std::uint8_t gpio_data7{16};  // BCM 16 - PIN 36
-  static constexpr std::uint8_t gpio_clock{4};   // BCM  4 - PIN  7
-  static constexpr std::uint8_t gpio_tco{14};    // BCM 14 - PIN  8
-  static constexpr std::uint8_t gpio_pi_ok{15};  // BCM 15 - PIN 10
-  static constexpr std::uint8_t gpio_fail{18};   // BCM 18 - PIN 12
-  static constexpr std::uint8_t gpio_reset{17};  // BCM 17 - PIN 11
-  static constexpr std::uint8_t gpio_button{25}; // BCM 25 - PIN 22
-
-  static constexpr std::array<std::uint32_t, 8> gpio_data_position{
-    std::uint32_t{1} << gpio_data0,
-    std::uint32_t{1} << gpio_data1,
-    std::uint32_t{1} << gpio_data2,
-    std::uint32_t{1} << gpio_data3,
-    std::uint32_t{1} << gpio_data4,
-    std::uint32_t{1} << gpio_data5,
-    std::uint32_t{1} << gpio_data6,
-    std::uint32_t{1} << gpio_data7
-  };
-
-  static constexpr std::uint32_t gpio_clock_position{std::uint32_t{1} << gpio_clock};
-  static constexpr std::uint32_t gpio_tco_position{std::uint32_t{1} << gpio_tco};
-  static constexpr std::uint32_t gpio_pi_status_position{std::uint32_t{1} << gpio_pi_ok};
-  static constexpr std::uint32_t gpio_fail_position{std::uint32_t{1} << gpio_fail};
-  static constexpr std::uint32_t gpio_button_position{std::uint32_t{1} << gpio_button};
-
-  // (2^32)-1 - ALL BCM pins
-  static constexpr std::uint32_t gpio_all_32_bits_on{0xFFFFFFFF};
-
-  static void pull_gpio(const unsigned pin, const unsigned high) noexcept
+  /**
+   * @returns The acquisition source specified by the environment variable
+   * `PANDA_TIMESWIPE_ACQUISITION`, which can be one of the following:
+   *   - `gpio` (or not set) - the board attached via BCM GPIO;
+   *   - `simulation` - the synthetic data (no board required);
+   *   - `replay:<path>` - the chunks read from the file (no board required).
+   * The pace of the sources which doesn't require the board can be changed
+   * by the environment variable `PANDA_TIMESWIPE_ACQUISITION_SPEED` which
+   * specifies the speed factor (`0` means "as fast as possible").
+   */
+  std::unique_ptr<Acquisition_source> make_acquisition_source() const
   {
-    PANDA_TIMESWIPE_GPIO_PULL = high << pin;
+    const char* const kind_env = std::getenv("PANDA_TIMESWIPE_ACQUISITION");
+    const std::string_view kind{kind_env ? kind_env : "gpio"};
+    const double speed = [&]
+    {
+      const char* const speed_env = std::getenv("PANDA_TIMESWIPE_ACQUISITION_SPEED");
+      try {
+        return speed_env ? std::stod(speed_env) : 1.0;
+      } catch (...) {
+        throw Exception{std::string{"invalid acquisition speed "}.append(speed_env)};
+      }
+    }();
+
+    constexpr std::string_view replay_prefix{"replay:"};
+    if (kind == "gpio")
+      return std::make_unique<Gpio_acquisition_source>();
+    else if (kind == "simulation")
+      return std::make_unique<Simulated_acquisition_source>(max_sample_rate(), speed);
+    else if (kind.substr(0, replay_prefix.size()) == replay_prefix)
+      return std::make_unique<Replay_acquisition_source>(
+        std::string{kind.substr(replay_prefix.size())}, max_sample_rate(), speed);
+    else
+      throw Exception{std::string{"invalid acquisition source "}.append(kind)};
   }
 
-  static void init_gpio_input(const unsigned pin) noexcept
+  /**
+   * @brief Sets `value_transforms_` from the calibration slopes, translation
+   * offsets, translation slopes and drift deltas.
+   *
+   * @details Each value is calculated as:
+   * `((code - chunk_code_offset) / slope - translation_offset) / translation_slope - drift_delta`,
+   * which is folded into `(code - chunk_code_offset) * scale + offset`.
+   */
+  void set_value_transforms() noexcept
   {
-    PANDA_TIMESWIPE_INP_GPIO(pin);
+    const auto mcc = max_channel_count();
+    PANDA_TIMESWIPE_ASSERT((calibration_slopes_.size() == mcc)
+      && (translation_offsets_.size() == mcc)
+      && (translation_slopes_.size() == mcc)
+      && (!drift_deltas_ || drift_deltas_->size() == mcc));
+    for (unsigned i{}; i < mcc; ++i) {
+      const double slope{calibration_slopes_[i]};
+      const double translation_offset{translation_offsets_[i]};
+      const double translation_slope{translation_slopes_[i]};
+      const double drift_delta{drift_deltas_ ? (*drift_deltas_)[i] : 0};
+      const double scale{1 / (slope * translation_slope)};
+      auto& transform = value_transforms_[i];
+      transform.code_offset = channel_offset;
+      transform.scale = static_cast<float>(scale);
+      transform.offset = static_cast<float>(-translation_offset / translation_slope
+        - drift_delta);
+    }
   }
 
-  static void init_gpio_output(const unsigned pin) noexcept
+  /// Decodes the codes of `count` chunks starting from `chunks` to `codes`.
+  static void decode_records(const Chunk* const chunks, const std::size_t count,
+    Code_columns& codes)
   {
-    PANDA_TIMESWIPE_INP_GPIO(pin);
-    PANDA_TIMESWIPE_OUT_GPIO(pin);
-    pull_gpio(pin, 0);
+    Chunk_code_columns columns;
+    for (std::size_t i{}; i < codes.size(); ++i) {
+      codes[i].resize(count);
+      columns[i] = codes[i].data();
+    }
+    decode_chunks(chunks, count, columns);
   }
 
-  static void set_gpio_high(const unsigned pin) noexcept
+  /**
+   * @brief Appends the values of the decoded `codes` to the `data`.
+   *
+   * @details Each value is calculated as `(code - code_offset) * scale + offset`.
+   */
+  static void append_values(Data& data, const Code_columns& codes,
+    const std::array<Value_transform, detail::max_channel_count>& transforms)
   {
-    PANDA_TIMESWIPE_GPIO_SET = 1 << pin;
+    PANDA_TIMESWIPE_ASSERT(data.column_count() <= codes.size());
+    const auto count = codes[0].size();
+    data.append_generated_rows(count, [&](const auto i, float* const out)
+    {
+      const auto* const digits = codes[i].data();
+      const auto [code_offset, scale, offset] = transforms[i];
+      for (std::size_t j{}; j < count; ++j)
+        out[j] = static_cast<float>(digits[j] - code_offset) * scale + offset;
+    });
   }
 
-  static void set_gpio_low(const unsigned pin) noexcept
+  /// Appends the decoded `codes` to the raw `data`.
+  static void append_codes(Raw_data& data, const Code_columns& codes)
   {
-    PANDA_TIMESWIPE_GPIO_CLR = 1 << pin;
+    PANDA_TIMESWIPE_ASSERT(data.column_count() <= codes.size());
+    const auto count = codes[0].size();
+    data.append_generated_rows(count, [&](const auto i, std::uint16_t* const out)
+    {
+      std::copy(codes[i].cbegin(), codes[i].cend(), out);
+    });
   }
 
-  static void reset_all_gpio() noexcept
-  {
-    PANDA_TIMESWIPE_GPIO_CLR = gpio_all_32_bits_on;
-  }
+  // ---------------------------------------------------------------------------
+  // Board emulation stuff
+  // ---------------------------------------------------------------------------
 
-  static unsigned read_all_gpio() noexcept
+  /**
+   * @returns The board settings which are used when the acquisition source
+   * is not backed by the board.
+   */
+  Board_settings default_emulated_board_settings() const
   {
-    return (*(ts::detail::bcm_gpio + 13) & gpio_all_32_bits_on);
+    Board_settings result;
+    result.set_value("calibrationDataEnabled", false);
+    result.set_value("channelsAdcEnabled", false);
+    const unsigned mcc = max_channel_count();
+    for (unsigned i{}; i < mcc; ++i) {
+      const auto channel = "channel"+std::to_string(i+1);
+      result.set_value(channel+"Gain", 1.0f);
+      result.set_value(channel+"Mode", Measurement_mode::voltage);
+    }
+    return result;
   }
 
-  static void sleep_for_55ns() noexcept
+  /// @returns The emulated board settings which matches to `criteria`.
+  Board_settings emulated_board_settings(const std::string_view criteria) const
   {
-    read_all_gpio();
-  }
+    if (criteria == "all" || criteria == "basic")
+      return emulated_board_settings_;
 
-  static void sleep_for_8ns() noexcept
-  {
-    set_gpio_high(10); // ANY UNUSED PIN!!!
+    Board_settings result;
+    if (auto value = emulated_board_settings_.value(criteria); value.has_value())
+      result.set_value(criteria, std::move(value));
+    return result;
   }
 
-  struct Gpio_data final {
-    std::uint8_t byte{};
-    unsigned tco{};
-    bool pi_ok{};
-
-    // Chunk Layout
-    // ------+----------------------------+---------------------------
-    //  Byte | Bit7   Bit6   Bit5   Bit4  | Bit3   Bit2   Bit1   Bit0
-    // ------+----------------------------+---------------------------
-    //     0 | 1-14   2-14   3-14   4-14  | 1-15   2-15   3-15   4-15
-    //     1 | 1-12   2-12   3-12   4-12  | 1-13   2-13   3-13   4-13
-    //     2 | 1-10   2-10   3-10   4-10  | 1-11   2-11   3-11   4-11
-    //     3 |  1-8    2-8    3-8    4-8  |  1-9    2-9    3-9    4-9
-    //     4 |  1-6    2-6    3-6    4-6  |  1-7    2-7    3-7    4-7
-    //     5 |  1-4    2-4    3-4    4-4  |  1-5    2-5    3-5    4-5
-    //     6 |  1-2    2-2    3-2    4-2  |  1-3    2-3    3-3    4-3
-    //     7 |  1-0    2-0    3-0    4-0  |  1-1    2-1    3-1    4-1
-    using Chunk = std::array<std::uint8_t, 8>;
-
-    struct Read_chunk_result final {
-      Chunk chunk{};
-      unsigned tco{};
-      bool pi_ok{};
-    };
-
-    static Read_chunk_result read_chunk() noexcept
-    {
-      Read_chunk_result result;
-      result.chunk[0] = read().byte;
-      {
-        const auto d = read();
-        result.chunk[1] = d.byte;
-        result.tco = d.tco;
-        result.pi_ok = d.pi_ok;
-      }
-      for (unsigned i{2}; i < result.chunk.size(); ++i)
-        result.chunk[i] = read().byte;
-      return result;
-    }
-
-    static void append_chunk(Data& data,
-      const Chunk& chunk,
-      const std::vector<float>& slopes,
-      const std::vector<float>& translation_offsets,
-      const std::vector<float>& translation_slopes)
-    {
-      PANDA_TIMESWIPE_ASSERT((slopes.size() == translation_offsets.size())
-        && (slopes.size() == translation_slopes.size()));
-
-      std::array<std::uint16_t, detail::max_channel_count> digits{};
-      static_assert(sizeof(channel_offset) == sizeof(digits[0]));
-      PANDA_TIMESWIPE_ASSERT(data.column_count() <= digits.size());
-
-      constexpr auto set_bit = [](std::uint16_t& word, const std::uint8_t N, const bool bit) noexcept
-      {
-        word = (word & ~(1UL << N)) | (bit << N);
-      };
-      constexpr auto bit = [](const std::uint8_t byte, const std::uint8_t N) noexcept -> bool
-      {
-        return (byte & (1UL << N));
-      };
-      for (std::size_t i{}, count{}; i < chunk.size(); ++i) {
-        set_bit(digits[0], 15 - count, bit(chunk[i], 3));
-        set_bit(digits[1], 15 - count, bit(chunk[i], 2));
-        set_bit(digits[2], 15 - count, bit(chunk[i], 1));
-        set_bit(digits[3], 15 - count, bit(chunk[i], 0));
-        count++;
-
-        set_bit(digits[0], 15 - count, bit(chunk[i], 7));
-        set_bit(digits[1], 15 - count, bit(chunk[i], 6));
-        set_bit(digits[2], 15 - count, bit(chunk[i], 5));
-        set_bit(digits[3], 15 - count, bit(chunk[i], 4));
-        count++;
-      }
-
-      data.append_generated_row([&](const auto i)
-      {
-        const auto mv = (digits[i] - channel_offset) / slopes[i];
-        return (mv - translation_offsets[i]) / translation_slopes[i];
-      });
-    }
-
-  private:
-    static Gpio_data read() noexcept
-    {
-      set_gpio_high(gpio_clock);
-      sleep_for_55ns();
-      sleep_for_55ns();
-
-      set_gpio_low(gpio_clock);
-      sleep_for_55ns();
-      sleep_for_55ns();
-
-      const unsigned all_gpio{read_all_gpio()};
-      const std::uint8_t byte =
-        ((all_gpio & gpio_data_position[0]) >> 17) |  // Bit 7
-        ((all_gpio & gpio_data_position[1]) >> 19) |  //     6
-        ((all_gpio & gpio_data_position[2]) >>  2) |  //     5
-        ((all_gpio & gpio_data_position[3]) >>  1) |  //     4
-        ((all_gpio & gpio_data_position[4]) >>  3) |  //     3
-        ((all_gpio & gpio_data_position[5]) >> 10) |  //     2
-        ((all_gpio & gpio_data_position[6]) >> 12) |  //     1
-        ((all_gpio & gpio_data_position[7]) >> 16);   //     0
-
-      sleep_for_55ns();
-      sleep_for_55ns();
-
-      return {byte, (all_gpio & gpio_tco_position), (all_gpio & gpio_pi_status_position) != 0};
-    }
-  };
-
   // ---------------------------------------------------------------------------
   // SPI stuff
   // ---------------------------------------------------------------------------
 
   void spi_set_channels_adc_enabled(const bool value)
   {
-    spi_.execute_set("channelsAdcEnabled", value ? "true" : "false");
+    if (source_->is_board_attached())
+      spi_.execute_set("channelsAdcEnabled", value ? "true" : "false");
+    else
+      emulated_board_settings_.set_value("channelsAdcEnabled", value);
   }
 
   bool spi_is_channels_adc_enabled() const
   {
     PANDA_TIMESWIPE_ASSERT(is_initialized());
+    if (!source_->is_board_attached())
+      return std::any_cast<bool>(emulated_board_settings_.value("channelsAdcEnabled"));
     const auto doc = spi_.execute_get("channelsAdcEnabled");
     return rajson::Value_view{doc}.mandatory<bool>("channelsAdcEnabled");
   }
@@ -915,51 +1154,47 @@ private:
   // Channels data reading, queueing and pushing stuff
   // -----------------------------------------------------------------------------
 
-  /// Read records from hardware buffer.
-  Data read_data()
+  /// Read records from hardware buffer into `chunks_`.
+  void read_data()
   {
-    static const auto wait_for_pi_ok = []
-    {
-      // Matches 12 MHz Quartz.
-      std::this_thread::sleep_for(microseconds{700});
-    };
-
     // Skip data sets if needed. (First 32 data sets are always invalid.)
     while (read_skip_count_ > 0) {
-      wait_for_pi_ok();
-      while (true) {
-        const auto [chunk, tco, pi_ok] = Gpio_data::read_chunk();
-        if (!pi_ok || tco != 0x00004000) break;
-      }
+      PANDA_TIMESWIPE_TRACE_SCOPE("skip_data_set");
+      source_->await_data(read_pacer_.interval());
+      std::uint64_t count{1};
+      Chunk_read read;
+      while (!(read = source_->read_chunk()).is_last())
+        ++count;
+      read_pacer_.update(count, !read.pi_ok);
       --read_skip_count_;
     }
 
     // Wait the RAM A or RAM B becomes available for reading.
-    wait_for_pi_ok();
+    {
+      PANDA_TIMESWIPE_TRACE_SCOPE("await_data");
+      source_->await_data(read_pacer_.interval());
+    }
 
     /*
      * Read the data sets. The amount of data depends on the counterstate
      * and can be [1..255]*32 data sets. (The number of data sets are always 32
      * also. Usually, the first data set is of size greater than 1 is followed
      * by 31 data sets of size 1.)
-     *
-     * TODO: the PIN 12 of Pi-Header is for overflow detection. When it's
-     * becomes high it indicates that the RAM is full (failure - data loss).
-     * So, check this case.
      */
-    Data result(max_channel_count());
-    result.reserve_rows(8192);
+    PANDA_TIMESWIPE_TRACE_SCOPE("read_chunks");
+    chunks_.clear();
+    chunks_first_read_time_ = Read_time::now();
     do {
-      const auto [chunk, tco, pi_ok] = Gpio_data::read_chunk();
-      Gpio_data::append_chunk(result, chunk, calibration_slopes_,
-        translation_offsets_, translation_slopes_);
-      if (!pi_ok || tco != 0x00004000) break;
+      const auto read = source_->read_chunk();
+      chunks_.push_back(read.chunk);
+      if (read.is_last()) {
+        read_pacer_.update(chunks_.size(), !read.pi_ok);
+        break;
+      }
     } while (true);
+    chunks_last_read_time_ = Read_time::now();
 
-    sleep_for_55ns();
-    sleep_for_55ns();
-
-    return result;
+    source_->complete_reading();
   }
 
   // ---------------------------------------------------------------------------
@@ -968,74 +1203,837 @@ private:
 
   void data_reading()
   {
+    PANDA_TIMESWIPE_TRACE_THREAD_NAME("data_reading");
+    if (is_memory_locked_)
+      prefault_stack();
+
+    std::uint64_t written_count{};
+    std::uint64_t lost_count{};
+    std::optional<Data_info::Steady_time> previous_read_time;
     while (is_threads_running_) {
-      if (const auto data = read_data(); !record_queue_.push(data))
-        ++record_error_count_;
+      read_data();
+
+      const auto count = chunks_.size();
+      if (previous_read_time)
+        statistics_.read_loop_duration.add(to_microseconds(
+            chunks_last_read_time_.steady - *previous_read_time));
+      previous_read_time = chunks_last_read_time_.steady;
+      statistics_.read_chunk_count.add(count);
+
+      /*
+       * The records are lost either on the board or if there is no room for
+       * them in the ring. In the latter case the processing thread is notified
+       * about the loss when the next records are written.
+       */
+      const auto board_lost_count = source_->take_lost_count();
+      Statistics_counters::increase(statistics_.lost_sample_count, board_lost_count);
+      lost_count += board_lost_count;
+      bool is_writable{record_ring_.capacity() - record_ring_.size() >= count &&
+        record_batch_ring_.capacity() > record_batch_ring_.size()};
+      if (is_writable && lost_count) {
+        const Record_gap gap{written_count, lost_count};
+        is_writable = record_gap_ring_.write(&gap, 1);
+      }
+      if (is_writable) {
+        const Record_batch batch{written_count, count,
+          chunks_first_read_time_, chunks_last_read_time_};
+        record_batch_ring_.write(&batch, 1); // always succeeds here
+        record_ring_.write(chunks_.data(), count); // always succeeds here
+        written_count += count;
+        lost_count = 0;
+      } else {
+        lost_count += count;
+        Statistics_counters::increase(statistics_.dropped_batch_count, 1);
+        Statistics_counters::increase(statistics_.lost_sample_count, count);
+      }
+
+      if (record_ring_.size() >= record_wakeup_threshold_)
+        notify_data_processing();
     }
   }
 
-  void data_processing(Data_handler&& handler)
+  void data_processing()
   {
-    PANDA_TIMESWIPE_ASSERT(handler);
+    PANDA_TIMESWIPE_TRACE_THREAD_NAME("data_processing");
+    if (is_memory_locked_)
+      prefault_stack();
+
+    std::uint64_t read_count{};
+    std::uint64_t lost_count{};
+    std::optional<Record_gap> gap;
+    const auto value_subscriber_count = std::count_if(subscribers_.cbegin(),
+      subscribers_.cend(), [](const auto& subscriber){ return !subscriber.is_raw(); });
+    const auto value_subscriber = std::find_if(subscribers_.begin(),
+      subscribers_.end(), [](const auto& subscriber){ return !subscriber.is_raw(); });
+    Subscriber* const direct_subscriber = value_subscriber_count == 1 &&
+      !value_subscriber->resampler ? &*value_subscriber : nullptr;
+    const bool is_decoding_needed{value_subscriber_count && !direct_subscriber};
     while (is_threads_running_) {
-      Data records[10];
-      const auto num = record_queue_.pop(records);
-      const auto errors = record_error_count_.fetch_and(0);
+      // Wait the records.
+      if (record_ring_.size() < record_wakeup_threshold_) {
+        PANDA_TIMESWIPE_TRACE_SCOPE("await_records");
+        std::unique_lock lock{record_mutex_};
+        record_available_.wait_for(lock, max_record_wakeup_interval, [this]
+        {
+          return !is_threads_running_ ||
+            record_ring_.size() >= record_wakeup_threshold_;
+        });
+      }
 
-      if (!num) {
-        std::this_thread::sleep_for(milliseconds{1});
-        continue;
+      /*
+       * Read the records up to the next gap. (The ring size must be taken
+       * before the gap is read, because the gap is written before the records
+       * which follows it.)
+       */
+      auto max_record_count = std::min(record_ring_.size(), records_.size());
+      if (!gap) {
+        if (Record_gap g; record_gap_ring_.read(&g, 1))
+          gap = g;
+      }
+      if (gap) {
+        PANDA_TIMESWIPE_ASSERT(gap->position >= read_count);
+        if (gap->position == read_count) {
+          for (auto& subscriber : subscribers_)
+            handle_gap(subscriber, lost_count, gap->lost_count);
+          lost_count += gap->lost_count;
+          gap.reset();
+          continue;
+        }
+        max_record_count = std::min<std::uint64_t>(max_record_count,
+          gap->position - read_count);
       }
 
-      // If there are drift deltas substract them.
-      if (drift_deltas_) {
-        const auto& deltas = *drift_deltas_;
-        for (std::decay_t<decltype(num)> i{}; i < num; ++i) {
-          const auto channel_count = records[i].column_count();
-          PANDA_TIMESWIPE_ASSERT(deltas.size() == channel_count);
-          for (std::decay_t<decltype(channel_count)> j{}; j < channel_count; ++j)
-            records[i].transform_column(j,
-              [delta = deltas[j]](const auto value){return value - delta;});
+      const auto record_count = record_ring_.read(records_.data(), max_record_count);
+      if (!record_count)
+        continue;
+
+      // Take the read time of the first and the last records.
+      const auto first_read_time = record_read_time(read_count);
+      read_count += record_count;
+      const auto last_read_time = record_read_time(read_count - 1);
+
+      /*
+       * Decode the records to the values (the drift deltas are subtracted here
+       * as well) once for all the subscribers, or straight into the burst
+       * buffer if there is the only subscriber of values which doesn't need
+       * the resampling.
+       */
+      {
+        PANDA_TIMESWIPE_TRACE_SCOPE("decode");
+        decode_records(records_.data(), record_count, record_codes_);
+        if (is_decoding_needed) {
+          decoded_records_.clear_rows();
+          append_values(decoded_records_, record_codes_, value_transforms_);
         }
       }
+      for (auto& subscriber : subscribers_) {
+        auto& burst_buffer = subscriber.burst_buffer;
+        if (!subscriber.burst_row_count())
+          subscriber.first_read_time = first_read_time;
+        subscriber.last_read_time = last_read_time;
+        {
+          PANDA_TIMESWIPE_TRACE_SCOPE("assemble_burst");
+          if (subscriber.is_raw())
+            append_codes(subscriber.raw_burst_buffer, record_codes_);
+          else if (&subscriber == direct_subscriber)
+            append_values(burst_buffer, record_codes_, value_transforms_);
+          else if (subscriber.resampler) {
+            const auto start_time = std::chrono::steady_clock::now();
+            subscriber.resampler->apply(decoded_records_, burst_buffer);
+            statistics_.resampling_duration.add(to_microseconds(
+                std::chrono::steady_clock::now() - start_time));
+          } else
+            burst_buffer.append_rows(decoded_records_);
+        }
+
+        const auto row_count = subscriber.burst_row_count();
+        if (row_count && row_count >= subscriber.burst_buffer_size)
+          handle_burst_buffer(subscriber);
+      }
+    }
 
-      Data* records_ptr{};
-      Data samples;
-      if (resampler_) {
-        for (std::decay_t<decltype(num)> i{}; i < num; ++i) {
-          auto s = resampler_->apply(std::move(records[i]));
-          samples.append_rows(std::move(s));
+    for (auto& subscriber : subscribers_) {
+      // Flush the resampler instance into the burst buffer.
+      if (subscriber.resampler)
+        subscriber.burst_buffer.append_rows(subscriber.resampler->flush());
+
+      // Flush the remaining values from the burst buffer.
+      if (subscriber.burst_row_count())
+        handle_burst_buffer(subscriber);
+    }
+
+    // Let the handling thread exit once the queue is drained.
+    {
+      const std::lock_guard lock{burst_queue_mutex_};
+      is_burst_queue_closed_ = true;
+    }
+    burst_queue_changed_.notify_all();
+  }
+
+  /**
+   * @brief Passes the data accumulated before the gap of `count` records to
+   * the handler of the `subscriber`, and accounts the lost samples.
+   *
+   * @param lost_count The number of records lost before the gap.
+   */
+  void handle_gap(Subscriber& subscriber, const std::uint64_t lost_count,
+    const std::uint64_t count)
+  {
+    if (subscriber.burst_row_count())
+      handle_burst_buffer(subscriber);
+
+    const auto lost_sample_count = [&subscriber](const std::uint64_t count)
+    {
+      if (!subscriber.resampler)
+        return count;
+      const auto& options = subscriber.resampler->options();
+      return count * options.up_factor() / options.down_factor();
+    };
+    const auto lost_samples = lost_sample_count(lost_count + count) -
+      lost_sample_count(lost_count);
+    subscriber.lost_sample_count += lost_samples;
+    subscriber.total_lost_sample_count += lost_samples;
+    subscriber.errors = static_cast<int>(std::min<std::uint64_t>(
+        subscriber.errors + count, std::numeric_limits<int>::max()));
+  }
+
+  /**
+   * @brief Passes the burst buffer to the handler of the `subscriber`.
+   *
+   * @par Effects
+   * `!subscriber.burst_row_count()`.
+   */
+  void handle_burst_buffer(Subscriber& subscriber)
+  {
+    auto& burst_buffer = subscriber.burst_buffer;
+    auto& raw_burst_buffer = subscriber.raw_burst_buffer;
+    data_info_.sample_index = subscriber.next_sample_index + subscriber.lost_sample_count;
+    data_info_.sample_count = subscriber.burst_row_count();
+    data_info_.lost_sample_count = subscriber.lost_sample_count;
+    data_info_.total_lost_sample_count = subscriber.total_lost_sample_count;
+    data_info_.queue_size = record_ring_.size();
+    data_info_.first_read_time = subscriber.first_read_time.steady;
+    data_info_.last_read_time = subscriber.last_read_time.steady;
+    data_info_.first_read_system_time = subscriber.first_read_time.system;
+    data_info_.last_read_system_time = subscriber.last_read_time.system;
+    subscriber.next_sample_index = data_info_.sample_index + data_info_.sample_count;
+    subscriber.lost_sample_count = 0;
+
+    const auto errors = std::exchange(subscriber.errors, 0);
+    if (burst_queue_capacity_) {
+      const auto index = static_cast<std::size_t>(&subscriber - subscribers_.data());
+      handle_burst_queue({index, std::move(burst_buffer),
+          std::move(raw_burst_buffer), data_info_, errors});
+      if (subscriber.is_raw())
+        raw_burst_buffer = raw_data_pool_.acquire();
+      else
+        burst_buffer = data_pool_.acquire();
+    } else {
+      call_handler(subscriber, burst_buffer, raw_burst_buffer,
+        data_info_.sample_count, errors);
+      if (!subscriber.is_raw() && !burst_buffer.column_count())
+        burst_buffer = data_pool_.acquire();
+    }
+  }
+
+  /**
+   * @brief Calls the handler of the `subscriber` with either the `data` or
+   * the `raw_data` (if the subscriber is of raw data).
+   *
+   * @par Effects
+   * Either `!data.row_count()` or `!data.column_count()` (if moved), or
+   * `!raw_data.row_count()`.
+   */
+  void call_handler(Subscriber& subscriber, Data& data, Raw_data& raw_data,
+    const std::uint64_t sample_count, const int errors)
+  {
+    const auto start_time = std::chrono::steady_clock::now();
+    {
+      PANDA_TIMESWIPE_TRACE_SCOPE("handler");
+      // The view is valid until the handler returns, so the data is reused.
+      if (auto* const h = std::get_if<Data_view_handler>(&subscriber.handler)) {
+        (*h)(Data_view{data}, errors);
+        data.clear_rows();
+      } else if (auto* const h = std::get_if<Raw_data_view_handler>(&subscriber.handler)) {
+        (*h)(Raw_data_view{raw_data}, errors);
+        raw_data.clear_rows();
+      } else
+        std::get<Data_handler>(subscriber.handler)(std::move(data), errors);
+    }
+
+    // Compare the duration of the handler with the duration of the data.
+    const auto duration = to_microseconds(std::chrono::steady_clock::now() - start_time);
+    statistics_.handler_duration.add(duration);
+    if (duration * subscriber.sample_rate > sample_count * 1000000)
+      Statistics_counters::increase(statistics_.handler_overrun_count, 1);
+  }
+
+  /// @returns The burst of the handler queue at the given `index`.
+  Burst& burst_queue_at(const std::size_t index) noexcept
+  {
+    return burst_queue_[(burst_queue_begin_ + index) % burst_queue_.size()];
+  }
+
+  /**
+   * @brief Puts the `burst` to the end of the handler queue.
+   *
+   * @remarks The queue is grown if it's full. Must be called with the lock
+   * of the queue.
+   */
+  void push_burst(Burst&& burst)
+  {
+    if (burst_queue_size_ == burst_queue_.size()) {
+      std::vector<Burst> queue(2*burst_queue_.size());
+      for (std::size_t i{}; i < burst_queue_size_; ++i)
+        queue[i] = std::move(burst_queue_at(i));
+      burst_queue_.swap(queue);
+      burst_queue_begin_ = 0;
+    }
+    burst_queue_at(burst_queue_size_++) = std::move(burst);
+    auto& high_water_mark = statistics_.handler_queue_high_water_mark;
+    if (burst_queue_size_ > high_water_mark.load(std::memory_order_relaxed))
+      high_water_mark.store(burst_queue_size_, std::memory_order_relaxed);
+  }
+
+  /**
+   * @brief Takes the burst from the begin of the handler queue.
+   *
+   * @remarks Must be called with the lock of the non-empty queue.
+   */
+  Burst pop_burst() noexcept
+  {
+    PANDA_TIMESWIPE_ASSERT(burst_queue_size_);
+    auto result = std::move(burst_queue_at(0));
+    burst_queue_begin_ = (burst_queue_begin_ + 1) % burst_queue_.size();
+    --burst_queue_size_;
+    return result;
+  }
+
+  /**
+   * @returns The newest queued burst of the same subscriber as the `burst` if
+   * the `burst` continues it, or `nullptr` otherwise (i.e. if there is no such
+   * burst, or the samples between them are lost).
+   *
+   * @remarks Must be called with the lock of the queue.
+   */
+  Burst* coalescable_burst(const Burst& burst) noexcept
+  {
+    for (auto i = burst_queue_size_; i--;) {
+      auto& queued = burst_queue_at(i);
+      if (queued.subscriber_index == burst.subscriber_index)
+        return queued.info.sample_index + queued.info.sample_count ==
+          burst.info.sample_index ? &queued : nullptr;
+    }
+    return nullptr;
+  }
+
+  /**
+   * @brief Puts the `burst` into the handler queue according to the overflow
+   * policy.
+   *
+   * @remarks Blocks the processing thread while the queue is full if the
+   * overflow policy is `Overflow_policy::block`.
+   */
+  void handle_burst_queue(Burst&& burst)
+  {
+    std::unique_lock lock{burst_queue_mutex_};
+    if (burst_queue_size_ >= burst_queue_capacity_) {
+      switch (burst_queue_overflow_policy_) {
+      case Overflow_policy::block:
+        // (After the stop the burst is queued beyond the capacity.)
+        burst_queue_changed_.wait(lock, [this]
+        {
+          return burst_queue_size_ < burst_queue_capacity_ || !is_threads_running_;
+        });
+        break;
+      case Overflow_policy::coalesce:
+        // Append the burst to the newest queued one of the same subscriber.
+        if (auto* const queued = coalescable_burst(burst)) {
+          queued->data.append_rows(burst.data);
+          queued->raw_data.append_rows(burst.raw_data);
+          queued->info.sample_count += burst.info.sample_count;
+          queued->info.queue_size = burst.info.queue_size;
+          queued->info.last_read_time = burst.info.last_read_time;
+          queued->info.last_read_system_time = burst.info.last_read_system_time;
+          lock.unlock();
+          recycle_burst(std::move(burst));
+          return;
         }
-        records_ptr = &samples;
-      } else {
-        for (std::decay_t<decltype(num)> i{1}; i < num; ++i)
-          records[0].append_rows(std::move(records[i]));
-        records_ptr = records;
+        // Otherwise, make room as with drop_oldest.
+        [[fallthrough]];
+      case Overflow_policy::drop_oldest:
+        recycle_burst(pop_burst());
+        Statistics_counters::increase(statistics_.dropped_burst_count, 1);
+        break;
+      case Overflow_policy::drop_newest:
+        lock.unlock();
+        recycle_burst(std::move(burst));
+        Statistics_counters::increase(statistics_.dropped_burst_count, 1);
+        return;
+      }
+    }
+    push_burst(std::move(burst));
+    lock.unlock();
+    burst_queue_changed_.notify_all();
+  }
+
+  void data_handling()
+  {
+    PANDA_TIMESWIPE_TRACE_THREAD_NAME("data_handling");
+    while (true) {
+      Burst burst;
+      {
+        std::unique_lock lock{burst_queue_mutex_};
+        burst_queue_changed_.wait(lock, [this]
+        {
+          return burst_queue_size_ || is_burst_queue_closed_;
+        });
+        if (!burst_queue_size_)
+          break;
+        burst = pop_burst();
+      }
+      burst_queue_changed_.notify_all();
+
+      /*
+       * Account the samples of the bursts dropped from the queue as lost. The
+       * error marker is increased by the number of such samples.
+       */
+      auto& info = burst.info;
+      auto& delivery = burst_deliveries_[burst.subscriber_index];
+      const auto lost_count = info.sample_index - delivery.next_sample_index;
+      const auto dropped_count = lost_count - info.lost_sample_count;
+      burst.errors = static_cast<int>(std::min<std::uint64_t>(
+          burst.errors + dropped_count, std::numeric_limits<int>::max()));
+      info.lost_sample_count = lost_count;
+      info.total_lost_sample_count = info.sample_index - delivery.sample_count;
+      delivery.next_sample_index = info.sample_index + info.sample_count;
+      delivery.sample_count += info.sample_count;
+
+      handled_data_info_ = &info;
+      call_handler(subscribers_[burst.subscriber_index], burst.data,
+        burst.raw_data, info.sample_count, burst.errors);
+      handled_data_info_ = {};
+      recycle_burst(std::move(burst));
+    }
+  }
+
+  /// Returns the data of the `burst` to the pools.
+  void recycle_burst(Burst&& burst) noexcept
+  {
+    if (burst.data.column_count())
+      recycle_data(std::move(burst.data));
+    if (burst.raw_data.column_count())
+      raw_data_pool_.release(std::move(burst.raw_data));
+  }
+
+  /**
+   * @brief Puts the `data` into the read buffer according to the overflow
+   * policy.
+   *
+   * @remarks Blocks the processing thread while the read buffer is full if
+   * the overflow policy is `Overflow_policy::block`.
+   */
+  void handle_read_buffer(Data data)
+  {
+    std::unique_lock lock{read_buffer_mutex_};
+    read_lost_sample_count_ += data_info().lost_sample_count;
+    const auto free_count = [this]
+    {
+      return read_buffer_capacity_ - read_buffer_.row_count();
+    };
+    switch (read_overflow_policy_) {
+    case Overflow_policy::block:
+      while (data.row_count()) {
+        read_buffer_changed_.wait(lock, [this, &free_count]
+        {
+          return free_count() || !is_threads_running_;
+        });
+        if (!is_threads_running_)
+          break;
+        const auto count = std::min(free_count(), data.row_count());
+        read_buffer_.append_rows(data, count);
+        data.remove_begin_rows(count);
+        read_buffer_changed_.notify_all();
+      }
+      break;
+    case Overflow_policy::drop_oldest: {
+      const auto excess = data.row_count() - std::min(data.row_count(),
+        read_buffer_capacity_);
+      data.remove_begin_rows(excess);
+      const auto drop_count = data.row_count() - std::min(data.row_count(),
+        free_count());
+      read_buffer_.remove_begin_rows(drop_count);
+      read_buffer_.append_rows(data);
+      read_lost_sample_count_ += excess + drop_count;
+      break;
+    }
+    case Overflow_policy::drop_newest: {
+      const auto count = std::min(free_count(), data.row_count());
+      read_buffer_.append_rows(data, count);
+      read_lost_sample_count_ += data.row_count() - count;
+      break;
+    }
+    case Overflow_policy::coalesce:
+      // Rejected by Driver_settings for the read buffer.
+      PANDA_TIMESWIPE_ASSERT(false);
+      break;
+    }
+    lock.unlock();
+    read_buffer_changed_.notify_all();
+    recycle_data(std::move(data));
+  }
+
+  /**
+   * @returns The time at which the record of the given `position` was read,
+   * linearly interpolated within the batch of the record.
+   *
+   * @par Requires
+   * The record of the given `position` is read from the record ring, and
+   * the `position` is not less than the one of the previous call.
+   */
+  Read_time record_read_time(const std::uint64_t position) noexcept
+  {
+    while (!record_batch_ ||
+      record_batch_->position + record_batch_->count <= position) {
+      Record_batch batch;
+      const auto is_read = record_batch_ring_.read(&batch, 1);
+      PANDA_TIMESWIPE_ASSERT(is_read);
+      record_batch_ = batch;
+    }
+    PANDA_TIMESWIPE_ASSERT(record_batch_->position <= position);
+
+    const auto& batch = *record_batch_;
+    if (batch.count < 2)
+      return batch.first_read_time;
+    const auto interpolate = [offset = position - batch.position,
+      count = batch.count - 1](const auto first, const auto last)
+    {
+      using Rep = typename decltype(first)::rep;
+      return first + (last - first) * static_cast<Rep>(offset) /
+        static_cast<Rep>(count);
+    };
+    return {interpolate(batch.first_read_time.steady, batch.last_read_time.steady),
+      interpolate(batch.first_read_time.system, batch.last_read_time.system)};
+  }
+
+  // ---------------------------------------------------------------------------
+  // Measurement
+  // ---------------------------------------------------------------------------
+
+  /// Adds the subscription.
+  void add_subscriber__(const int sample_rate, const std::size_t burst_buffer_size,
+    Handler handler)
+  {
+    if (is_measurement_started())
+      throw Exception{Errc::board_measurement_started,
+        "cannot add subscriber while measurement is started"};
+    else if (!(min_subscriber_sample_rate() <= sample_rate &&
+        sample_rate <= max_sample_rate()))
+      throw Exception{Errc::driver_settings_invalid,
+        "cannot add subscriber with invalid sample rate"};
+    else if (!(1 <= burst_buffer_size &&
+        burst_buffer_size <= static_cast<std::size_t>(max_sample_rate())))
+      throw Exception{Errc::driver_settings_invalid,
+        "cannot add subscriber with invalid burst buffer size"};
+
+    subscriptions_.push_back({sample_rate, burst_buffer_size, std::move(handler), {}});
+  }
+
+  /**
+   * @brief Starts the measurement with the `handler` (if any) and the
+   * subscriptions.
+   *
+   * @param is_pull Whether the `handler` puts the data into the read buffer.
+   */
+  void start_measurement__(std::optional<Handler> handler, const bool is_pull = {})
+  {
+    if (!is_initialized())
+      throw Exception{Errc::driver_not_initialized,
+        "cannot start measurement while driver isn't initialized"};
+
+    /// @returns The calibration map from board settings.
+    static const auto calibration_map = [](const Board_settings& bs)
+    {
+      using hat::atom::Calibration;
+      hat::Calibration_map result;
+      const auto& doc = bs.rep_->doc();
+
+      // Use default slopes and offsets if the calibration data is disabled.
+      if (const auto calib_enabled = rajson::Value_view{doc}.optional("calibrationDataEnabled")) {
+        PANDA_TIMESWIPE_ASSERT(calib_enabled->value().IsBool());
+        if (!rajson::to<bool>(calib_enabled->value()))
+          return result;
       }
 
-      // std::clog << "burst_buffer_.row_count() = " << burst_buffer_.row_count()
-      //           << "burst_buffer_size_ = " << burst_buffer_size_ << std::endl;
-      if (burst_buffer_.row_count() || records_ptr->row_count() < burst_buffer_size_) {
-        // Go through burst buffer.
-        burst_buffer_.append_rows(std::move(*records_ptr));
-        if (burst_buffer_.row_count() >= burst_buffer_size_) {
-          handler(std::move(burst_buffer_), errors);
-          burst_buffer_ = Data(max_channel_count());
+      // Otherwise, use slopes and offset provided by firmware.
+      const auto calib = rajson::Value_view{doc}.mandatory("calibrationData");
+      PANDA_TIMESWIPE_ASSERT(calib.value().IsArray());
+      try {
+        // "calibrationData":[{"type":%, "data":[{"slope":%, "offset":%},...]},...]
+        for (const auto& catom_v : calib.value().GetArray()) {
+          rajson::Value_view catom_view{catom_v};
+
+          // Get the calibration atom type.
+          const auto type = catom_view.mandatory<Calibration::Type>("type");
+
+          // Check that data member is array.
+          const auto& catom_data_view = catom_view.mandatory("data");
+          if (!catom_data_view.value().IsArray())
+            throw Exception{"data member is not array"};
+
+          // Get the data array and ensure it has the proper size.
+          const auto& catom_data = catom_data_view.value().GetArray();
+          const auto catom_data_size = catom_data.Size();
+          if (catom_data_size != result.atom(type).entry_count())
+            throw Exception{"invalid data member size"};
+
+          // Extract each entry with slope and offset from the data array.
+          for (std::decay_t<decltype(catom_data_size)> i{}; i < catom_data_size; ++i) {
+            const auto& catom_data_entry = catom_data[i];
+            if (!catom_data_entry.IsObject())
+              throw Exception{"data entry is not object"};
+
+            rajson::Value_view catom_data_entry_view{catom_data_entry};
+            const auto slope = catom_data_entry_view.mandatory<float>("slope");
+            const auto offset = catom_data_entry_view.mandatory<std::int16_t>("offset");
+            const Calibration::Entry entry{slope, offset};
+            result.atom(type).set_entry(i, entry);
+          }
         }
-      } else
-        // Go directly (burst buffer not used or smaller than data).
-        handler(std::move(*records_ptr), errors);
+      } catch (const std::exception& e) {
+        throw Exception{Errc::board_settings_invalid,
+          std::string{"cannot use calibration data: "}.append(e.what())};
+      } catch (...) {
+        throw Exception{Errc::board_settings_invalid,
+          "cannot use calibration data: unknown error"};
+      }
+
+      return result;
+    };
+
+    const auto bs = board_settings();
+    const auto calib = calibration_map(bs);
+    const auto gains = channel_settings<float>(bs, "Gain");
+    const auto modes = channel_settings<Measurement_mode>(bs, "Mode");
+    const auto srate = driver_settings().sample_rate();
+    if (is_measurement_started(true))
+      throw Exception{Errc::board_measurement_started,
+        "cannot start measurement because it's already started"};
+    else if (!gains)
+      throw Exception{Errc::board_settings_insufficient,
+        "cannot start measurement with unspecified channel gains"};
+    else if (!modes)
+      throw Exception{Errc::board_settings_insufficient,
+        "cannot start measurement with unspecified channel measurement modes"};
+    else if (handler && !srate)
+      throw Exception{Errc::driver_settings_insufficient,
+        "cannot start measurement with unspecified sample rate"};
+
+    /*
+     * Make the subscribers: the one of the handler (if any) followed by the
+     * ones of the subscriptions.
+     */
+    std::vector<Subscriber> subscribers;
+    subscribers.reserve(subscriptions_.size() + 1);
+    const auto add_subscriber = [this, &subscribers](const int rate,
+      const std::size_t burst_buffer_size, Handler handler)
+    {
+      Subscriber subscriber;
+      subscriber.handler = std::move(handler);
+      subscriber.burst_buffer_size = burst_buffer_size;
+      subscriber.sample_rate = rate;
+      subscriber.resampler = make_resampler(rate);
+      subscribers.push_back(std::move(subscriber));
+    };
+    if (handler)
+      add_subscriber(*srate, burst_buffer_size_, std::move(*handler));
+    for (const auto& subscription : subscriptions_)
+      add_subscriber(subscription.sample_rate, subscription.burst_buffer_size,
+        subscription.handler);
+    PANDA_TIMESWIPE_ASSERT(!subscribers.empty());
+
+    // Reset the data info.
+    data_info_ = {};
+    record_batch_.reset();
+
+    // Lock the memory before preallocating the data buffers.
+    realtime_report_ = {};
+    if (const auto lock = driver_settings_.memory_locking(); lock && *lock) {
+      realtime_report_.memory_locking = lock_memory();
+      is_memory_locked_ = *realtime_report_.memory_locking;
     }
 
-    // Flush the resampler instance into the burst buffer.
-    if (resampler_)
-      burst_buffer_.append_rows(resampler_->flush());
+    /*
+     * Size the queue of records according to the memory budget. (The queue is
+     * empty here, so it's safe to replace the storage.)
+     */
+    const auto record_ring_capacity = driver_settings_.queue_memory_budget() ?
+      *driver_settings_.queue_memory_budget() / sizeof(Chunk) :
+      default_record_ring_capacity;
+    if (record_ring_capacity < 2*max_record_batch_size)
+      throw Exception{Errc::driver_settings_invalid,
+        "cannot start measurement with insufficient queue memory budget"};
+    record_ring_.reset(record_ring_capacity);
+    record_batch_ring_.reset(std::max(record_batch_ring_capacity,
+        record_ring_capacity / (default_record_ring_capacity /
+          record_batch_ring_capacity)));
+    record_gap_ring_.clear();
+
+    // Preallocate the data buffers.
+    const auto mcc = max_channel_count();
+    std::size_t max_burst_buffer_size{};
+    for (const auto& subscriber : subscribers)
+      max_burst_buffer_size = std::max(max_burst_buffer_size,
+        subscriber.burst_buffer_size);
+    const auto burst_queue_capacity = driver_settings_.handler_queue_size()
+      .value_or(0);
+    const auto raw_subscriber_count = static_cast<std::size_t>(
+      std::count_if(subscribers.cbegin(), subscribers.cend(),
+        [](const auto& subscriber){ return subscriber.is_raw(); }));
+    const auto value_subscriber_count = subscribers.size() - raw_subscriber_count;
+    data_pool_.reset(data_pool_size * value_subscriber_count + burst_queue_capacity,
+      mcc, max_burst_buffer_size + max_data_set_size);
+    raw_data_pool_.reset(raw_subscriber_count ? data_pool_size * raw_subscriber_count
+      + burst_queue_capacity : 0, mcc, max_burst_buffer_size + max_data_set_size);
+    if (is_memory_locked_) {
+      data_pool_.prefault();
+      raw_data_pool_.prefault();
+    }
+    for (auto& subscriber : subscribers) {
+      if (subscriber.is_raw())
+        subscriber.raw_burst_buffer = raw_data_pool_.acquire();
+      else
+        subscriber.burst_buffer = data_pool_.acquire();
+    }
+
+    /*
+     * Set the number of records which wakes up the processing thread. (The
+     * subscriber with the least burst buffer duration has the priority.)
+     */
+    if (driver_settings_.wakeup_policy() == Wakeup_policy::low_cpu) {
+      const auto max_rate = static_cast<std::size_t>(max_sample_rate());
+      record_wakeup_threshold_ = record_ring_capacity / 2;
+      for (const auto& subscriber : subscribers) {
+        const auto rate = subscriber.resampler ? max_rate *
+          subscriber.resampler->options().up_factor() /
+          subscriber.resampler->options().down_factor() : max_rate;
+        record_wakeup_threshold_ = clamp<std::size_t>(
+          (subscriber.burst_buffer_size*max_rate + rate - 1) / rate, 1,
+          record_wakeup_threshold_);
+      }
+    } else
+      record_wakeup_threshold_ = 1;
 
-    // Flush the remaining values from the burst buffer.
-    if (burst_buffer_.row_count()) {
-      handler(std::move(burst_buffer_), 0);
-      burst_buffer_ = Data(max_channel_count());
+    // Pick up the calibration slopes depending on both the gain and measurement mode.
+    PANDA_TIMESWIPE_ASSERT(gains && modes &&
+      (gains->size() == modes->size()) &&
+      (gains->size() >= mcc));
+    // may throw
+    decltype(calibration_slopes_) new_calibration_slopes{calibration_slopes_};
+    for (std::decay_t<decltype(mcc)> i{}; i < mcc; ++i) {
+      const auto gain = gains->at(i);
+      const auto mode = modes->at(i);
+      using Ct = hat::atom::Calibration::Type;
+      using Array = std::array<Ct, detail::max_channel_count>;
+      constexpr Array v_types{Ct::v_in1, Ct::v_in2, Ct::v_in3, Ct::v_in4};
+      constexpr Array c_types{Ct::c_in1, Ct::c_in2, Ct::c_in3, Ct::c_in4};
+      const auto& types = (mode == Measurement_mode::voltage) ? v_types : c_types;
+      const auto& atom = calib.atom(types[i]);
+      const auto ogain_index = gain::ogain_table_index(gain);
+      PANDA_TIMESWIPE_ASSERT(ogain_index < atom.entry_count());
+      new_calibration_slopes[i] = atom.entry(ogain_index).slope();
+    }
+    calibration_slopes_.swap(new_calibration_slopes); // noexcept
+
+    // Fold the calibration, translation and drift compensation.
+    set_value_transforms(); // noexcept
+
+    // Reset the read buffer.
+    Data read_buffer;
+    const auto read_buffer_capacity = is_pull ? driver_settings_
+      .read_buffer_size().value_or(static_cast<std::size_t>(*srate)) : 0;
+    if (is_pull) {
+      read_buffer = Data(mcc);
+      read_buffer.reserve_rows(read_buffer_capacity);
+    }
+    {
+      const std::lock_guard lock{read_buffer_mutex_};
+      read_buffer_ = std::move(read_buffer);
+      read_buffer_capacity_ = read_buffer_capacity;
+      read_overflow_policy_ = driver_settings_.read_overflow_policy()
+        .value_or(Overflow_policy::block);
+      read_lost_sample_count_ = 0;
+      is_read_buffer_active_ = is_pull;
+    }
+
+    // Reset the handler queue.
+    std::vector<Burst> burst_queue(burst_queue_capacity);
+    std::vector<Burst_delivery> burst_deliveries(burst_queue_capacity ?
+      subscribers.size() : 0);
+    {
+      const std::lock_guard lock{burst_queue_mutex_};
+      burst_queue_.swap(burst_queue);
+      burst_queue_begin_ = burst_queue_size_ = 0;
+      burst_queue_capacity_ = burst_queue_capacity;
+      burst_queue_overflow_policy_ = driver_settings_.handler_overflow_policy()
+        .value_or(Overflow_policy::block);
+      is_burst_queue_closed_ = false;
+      burst_deliveries_.swap(burst_deliveries);
     }
+
+    subscribers_.swap(subscribers); // noexcept
+    statistics_.reset(); // noexcept
+    trace::Registry::instance().clear();
+
+    /*
+     * Send the command to the firmware to start the measurement.
+     * Effects: the reader does receive the data from the board.
+     */
+    {
+      std::this_thread::sleep_for(milliseconds{1});
+      spi_set_channels_adc_enabled(true);
+      source_->start();
+    }
+
+    try {
+      is_threads_running_ = true;
+      is_measurement_started_ = true;
+      for (const auto& subscription : subscriptions_) {
+        if (subscription.recorder)
+          subscription.recorder->start(mcc, subscription.sample_rate,
+            value_transforms(), capture_metadata(bs, subscription.sample_rate));
+      }
+      threads_.emplace_back(&iDriver::data_reading, this);
+      threads_.emplace_back(&iDriver::data_processing, this);
+      if (burst_queue_capacity_)
+        threads_.emplace_back(&iDriver::data_handling, this);
+      set_thread_realtime(threads_[0], driver_settings_.reading_thread_cpu(),
+        driver_settings_.reading_thread_priority(),
+        realtime_report_.reading_thread_affinity,
+        realtime_report_.reading_thread_scheduling);
+      set_thread_realtime(threads_[1], driver_settings_.processing_thread_cpu(),
+        driver_settings_.processing_thread_priority(),
+        realtime_report_.processing_thread_affinity,
+        realtime_report_.processing_thread_scheduling);
+      if (burst_queue_capacity_)
+        set_thread_realtime(threads_[2], driver_settings_.handling_thread_cpu(),
+          driver_settings_.handling_thread_priority(),
+          realtime_report_.handling_thread_affinity,
+          realtime_report_.handling_thread_scheduling);
+    } catch (...) {
+      is_measurement_started_ = false;
+      join_threads();
+      stop_recorders();
+      try {
+        source_->stop();
+        spi_set_channels_adc_enabled(false);
+      } catch (...) {}
+      calibration_slopes_.swap(new_calibration_slopes); // noexcept
+      throw;
+    }
+
+    // Done.
+    PANDA_TIMESWIPE_ASSERT(is_measurement_started());
   }
 
   // ---------------------------------------------------------------------------
@@ -1060,45 +2058,105 @@ private:
   };
 
   /**
-   * @returns Previous resampler if any.
-   *
-   * @par Exception safety guarantee
-   * Strong.
+   * @returns The resampler from the max sample rate to the given `rate`, or
+   * `nullptr` if `rate` is the max sample rate.
    */
-  std::unique_ptr<Resampler> set_resampler(const int rate,
-    std::unique_ptr<Resampler> resampler = {})
+  std::unique_ptr<Resampler> make_resampler(const int rate) const
   {
     const auto max_rate = max_sample_rate();
     PANDA_TIMESWIPE_ASSERT(1 <= rate && rate <= max_rate);
-    PANDA_TIMESWIPE_ASSERT(!is_measurement_started());
-    auto result = std::move(resampler_);
-    try {
-      if (rate != max_rate) {
-        const auto rates_gcd = std::gcd(rate, max_rate);
-        const auto up = rate / rates_gcd;
-        const auto down = max_rate / rates_gcd;
-        if (resampler) {
-          PANDA_TIMESWIPE_ASSERT(up == resampler->options().up_factor());
-          PANDA_TIMESWIPE_ASSERT(down == resampler->options().down_factor());
-          resampler_ = std::move(resampler);
-        } else
-          resampler_ = std::make_unique<Resampler>(detail::Resampler_options{}
-            .set_channel_count(max_channel_count()).set_up_down(up, down));
-      } else {
-        PANDA_TIMESWIPE_ASSERT(!resampler);
-        resampler_.reset();
-      }
-    } catch (...) {
-      resampler_.swap(result);
-      throw;
+    if (rate == max_rate)
+      return nullptr;
+
+    // Cache the FIR coefficients on disk, so restarts with this rate are fast.
+    detail::Fir_cache::instance().set_directory(tmp_dir() / "fir_cache");
+
+    const auto rates_gcd = std::gcd(rate, max_rate);
+    const auto up = rate / rates_gcd;
+    const auto down = max_rate / rates_gcd;
+    auto result = std::make_unique<Resampler>(detail::Resampler_options{}
+      .set_channel_count(max_channel_count()).set_up_down(up, down)
+      .set_multistage_enabled(true));
+    result->reserve_rows(max_record_batch_size);
+    return result;
+  }
+
+  /**
+   * @brief Pins the `thread` to the `cpu` and sets its scheduling as
+   * requested by the driver settings.
+   *
+   * @par Effects
+   * The results of the requests are stored to `affinity` and `scheduling`.
+   */
+  void set_thread_realtime(std::thread& thread, const std::optional<int> cpu,
+    const std::optional<int> priority, std::optional<bool>& affinity,
+    std::optional<bool>& scheduling) noexcept
+  {
+    if (cpu)
+      affinity = set_thread_affinity(thread.native_handle(), *cpu);
+    if (const auto policy = driver_settings_.scheduling_policy())
+      scheduling = set_thread_scheduling(thread.native_handle(), *policy, priority);
+  }
+
+  /// Wakes up the data processing thread.
+  void notify_data_processing()
+  {
+    {
+      // Prevent the lost wakeup.
+      const std::lock_guard lock{record_mutex_};
     }
+    record_available_.notify_all();
+  }
+
+  /// @returns The metadata of the capture files (JSON text).
+  std::string capture_metadata(const Board_settings& bs, const int sample_rate) const
+  {
+    rapidjson::Document result{rapidjson::Type::kObjectType};
+    auto& alloc = result.GetAllocator();
+    result.AddMember("sampleRate", sample_rate, alloc);
+    result.AddMember("boardSettings", rapidjson::Value{bs.rep_->doc(), alloc}, alloc);
+    result.AddMember("driverSettings", rapidjson::Value{
+        rajson::to_document(driver_settings_.to_json_text()), alloc}, alloc);
+    result.AddMember("calibrationSlopes", rajson::to_value(calibration_slopes_,
+        alloc), alloc);
+    return rajson::to_text(result);
+  }
 
+  /**
+   * @brief Stops the recorders of the subscriptions.
+   *
+   * @returns The exception of the first failed recorder.
+   */
+  std::exception_ptr stop_recorders() noexcept
+  {
+    std::exception_ptr result;
+    for (const auto& subscription : subscriptions_) {
+      if (subscription.recorder) {
+        try {
+          subscription.recorder->stop();
+        } catch (...) {
+          if (!result)
+            result = std::current_exception();
+        }
+      }
+    }
     return result;
   }
 
   void join_threads()
   {
     is_threads_running_ = false;
+    notify_data_processing();
+    {
+      // Unblock the processing thread and the readers.
+      const std::lock_guard lock{read_buffer_mutex_};
+    }
+    read_buffer_changed_.notify_all();
+    {
+      // Unblock the processing thread waiting for the handler queue.
+      const std::lock_guard lock{burst_queue_mutex_};
+    }
+    burst_queue_changed_.notify_all();
     for (auto it = threads_.begin(); it != threads_.end();) {
       if (it->get_id() == std::this_thread::get_id()) {
         ++it;
@@ -1128,43 +2186,21 @@ private:
 
     const auto guard{state_guard()};
 
-    std::error_condition errc;
-    std::atomic_bool done{};
-    Data result;
-    std::condition_variable update;
-    start_measurement([this, samples_count,
-      &errc, &done, &result, &update](const Data data, const int)
-    {
-      if (errc || done)
-        return;
-
-      try {
-        if (result.row_count() < samples_count)
-          result.append_rows(data, samples_count - result.row_count());
-      } catch (...) {
-        errc = Errc::generic;
-      }
-
-      if (errc || (!done && (result.row_count() == samples_count))) {
-        done = true;
-        update.notify_one();
+    start_measurement(pull);
+    try {
+      Data result;
+      while (result.row_count() < samples_count) {
+        auto data = read(samples_count - result.row_count(),
+          max_record_wakeup_interval);
+        result.append_rows(data);
+        recycle_data(std::move(data));
       }
-    });
-
-    // Await for notification from the handler.
-    {
-      static std::mutex mutex; // Dummy mutex actually: `done` is atomic already.
-      std::unique_lock lock{mutex};
-      update.wait(lock, [&done]{ return done.load(); });
+      stop_measurement();
+      return result;
+    } catch (...) {
+      stop_measurement();
+      throw;
     }
-    PANDA_TIMESWIPE_ASSERT(done);
-    stop_measurement();
-
-    // Throw away if the data collection failed.
-    if (errc)
-      throw Exception{errc, "cannot collect channels data"};
-
-    return result;
   }
 
   /// @returns Path to directory for temporary files.
@@ -25,10 +25,17 @@
 #include "driver_settings.hpp"
 #include "errc.hpp"
 #include "exceptions.hpp"
+#include "recorder.hpp"
 #include "table.hpp"
+#include "table_view.hpp"
 #include "types_fwd.hpp"
 
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
 #include <functional>
+#include <iosfwd>
 #include <memory>
 #include <optional>
 #include <string_view>
@@ -52,7 +59,9 @@ public:
    * @param data Portion of the incoming data to process.
    * @param error_marker The error marker:
    *   - zero indicates "no error";
-   *   - positive value indicates the number of data losts;
+   *   - positive value indicates the number of samples (at the rate of
+   *   max_sample_rate()) lost right before the `data`, or since the previous
+   *   call of the handler (see data_info());
    *   - negative value indicates the negated error code (some value of
    *   panda::timeswipe::Errc with the minus sign) in case of fatal
    *   error when the measurement is about to stop.
@@ -61,6 +70,323 @@ public:
    */
   using Data_handler = std::function<void(Data data, int error_marker)>;
 
+  /**
+   * @brief The information about the data passed to the handler.
+   *
+   * @details Each row of data is a sample. The samples are counted at the
+   * rate of `driver_settings().sample_rate()` since the start of measurement,
+   * including the lost ones. The data passed to the handler never contains
+   * gaps: the data accumulated before the loss is passed to the handler
+   * immediately, even if it's less than the burst buffer size.
+   *
+   * The records are read from the board by batches, which are polled at the
+   * interval adapted to the sizes of the data sets (from 100 us to 20 ms), so
+   * the read time of each sample is interpolated within its batch.
+   *
+   * @remarks The number of samples dropped by the driver (e.g. because its
+   * queue is full) is exact at the rate of max_sample_rate(), and rounded
+   * down to the resampled rate otherwise.
+   * However, the board doesn't tell how many samples are lost when its RAM
+   * overflows, so the number of such samples (no more than the capacity of
+   * the RAM per overflow) is estimated by the time elapsed. Hence, the
+   * sample_index of the data after such a loss is approximate.
+   *
+   * @see data_info().
+   */
+  struct Data_info final {
+    /// An alias of the time point of `CLOCK_MONOTONIC`.
+    using Steady_time = std::chrono::steady_clock::time_point;
+
+    /// An alias of the time point of `CLOCK_REALTIME`.
+    using System_time = std::chrono::system_clock::time_point;
+
+    /**
+     * The index of the first sample of the data. (Approximate after the loss
+     * on the board, see the remarks above.)
+     */
+    std::uint64_t sample_index{};
+
+    /// The number of samples of the data.
+    std::uint64_t sample_count{};
+
+    /// The number of samples lost right before the first sample of the data.
+    std::uint64_t lost_sample_count{};
+
+    /// The number of samples lost since the start of measurement.
+    std::uint64_t total_lost_sample_count{};
+
+    /**
+     * The number of records (at the rate of max_sample_rate()) read from the
+     * board but not processed yet at the time the data is passed.
+     */
+    std::size_t queue_size{};
+
+    /// The time at which the first sample of the data was read from the board.
+    Steady_time first_read_time{};
+
+    /// The time at which the last sample of the data was read from the board.
+    Steady_time last_read_time{};
+
+    /// The same as first_read_time but of `CLOCK_REALTIME`.
+    System_time first_read_system_time{};
+
+    /// The same as last_read_time but of `CLOCK_REALTIME`.
+    System_time last_read_system_time{};
+
+    /**
+     * @returns The time at which the sample of the given `row` of the data
+     * was read, linearly interpolated between first_read_time and
+     * last_read_time.
+     *
+     * @par Requires
+     * `row < sample_count`.
+     */
+    Steady_time read_time(const std::uint64_t row) const noexcept
+    {
+      return interpolate(first_read_time, last_read_time, row);
+    }
+
+    /// @returns The same as read_time() but of `CLOCK_REALTIME`.
+    System_time read_system_time(const std::uint64_t row) const noexcept
+    {
+      return interpolate(first_read_system_time, last_read_system_time, row);
+    }
+
+  private:
+    template<class Time>
+    Time interpolate(const Time first, const Time last,
+      const std::uint64_t row) const noexcept
+    {
+      if (sample_count < 2)
+        return first;
+      using Rep = typename Time::rep;
+      return first + (last - first) * static_cast<Rep>(row) /
+        static_cast<Rep>(sample_count - 1);
+    }
+  };
+
+  /// An alias of the read-only view of data.
+  using Data_view = Table_view<float>;
+
+  /**
+   * @brief An alias of a function to handle the incoming data without copying.
+   *
+   * @param data The view of the portion of the incoming data to process. The
+   * view is valid only until the function returns.
+   * @param error_marker The error marker (see Data_handler).
+   *
+   * @see start_measurement().
+   */
+  using Data_view_handler = std::function<void(const Data_view& data,
+    int error_marker)>;
+
+  /**
+   * @brief An alias of the raw data: the codes of the ADC of the board as is,
+   * i.e. without both the calibration and the translation.
+   *
+   * @see Value_transform.
+   */
+  using Raw_data = Table<std::uint16_t>;
+
+  /// An alias of the read-only view of raw data.
+  using Raw_data_view = Table_view<std::uint16_t>;
+
+  /**
+   * @brief An alias of a function to handle the incoming raw data without
+   * copying.
+   *
+   * @param data The view of the portion of the incoming raw data to process.
+   * The view is valid only until the function returns.
+   * @param error_marker The error marker (see Data_handler).
+   *
+   * @see add_subscriber(std::size_t, Raw, Raw_data_view_handler).
+   */
+  using Raw_data_view_handler = std::function<void(const Raw_data_view& data,
+    int error_marker)>;
+
+  /**
+   * @brief The transformation of the code of the channel to the value:
+   * `(code - code_offset) * scale + offset`.
+   *
+   * @details The transformation folds the calibration slope, the translation
+   * offset, the translation slope and the drift delta of the channel. The
+   * code offset is subtracted in the integer arithmetic, so the values near
+   * zero are not subject to the cancellation. The values passed to the
+   * handlers are calculated by this very expression (of `float` scale and
+   * offset), so the values calculated from the raw data are the same as the
+   * ones passed to the handlers of data.
+   *
+   * @see value_transforms().
+   */
+  struct Value_transform final {
+    /// The code offset.
+    std::int32_t code_offset{};
+
+    /// The scale.
+    float scale{1};
+
+    /// The offset.
+    float offset{};
+  };
+
+  /**
+   * @brief The report on the real-time requests made upon start_measurement().
+   *
+   * @details Each member is `std::nullopt` if the corresponding request is not
+   * made, `true` if the request is granted, or `false` otherwise.
+   *
+   * @see realtime_report(), Driver_settings::set_scheduling_policy().
+   */
+  struct Realtime_report final {
+    /// The result of pinning the data reading thread to the CPU.
+    std::optional<bool> reading_thread_affinity;
+
+    /// The result of setting the scheduling of the data reading thread.
+    std::optional<bool> reading_thread_scheduling;
+
+    /// The result of pinning the data processing thread to the CPU.
+    std::optional<bool> processing_thread_affinity;
+
+    /// The result of setting the scheduling of the data processing thread.
+    std::optional<bool> processing_thread_scheduling;
+
+    /// The result of pinning the data handling thread to the CPU.
+    std::optional<bool> handling_thread_affinity;
+
+    /// The result of setting the scheduling of the data handling thread.
+    std::optional<bool> handling_thread_scheduling;
+
+    /// The result of locking the memory.
+    std::optional<bool> memory_locking;
+  };
+
+  /**
+   * @brief The histogram of values with the bins of exponentially growing
+   * width.
+   *
+   * @details The bin 0 counts the zeros, and the bin `i > 0` counts the
+   * values in range `[2^(i-1), 2^i)`. The last bin counts all the values
+   * not less than `2^(bin_count-2)`.
+   */
+  struct Histogram final {
+    /// The number of bins.
+    static constexpr std::size_t bin_count{32};
+
+    /// The numbers of values of the bins.
+    std::array<std::uint64_t, bin_count> bins{};
+
+    /// The number of values.
+    std::uint64_t count{};
+
+    /// The sum of values.
+    std::uint64_t sum{};
+
+    /// The maximum value.
+    std::uint64_t max{};
+
+    /// @returns The least value counted by the bin of the given `index`.
+    static constexpr std::uint64_t bin_lower_bound(const std::size_t index) noexcept
+    {
+      return index ? std::uint64_t{1} << (index - 1) : 0;
+    }
+
+    /// @returns The mean value, or zero if `!count`.
+    double mean() const noexcept
+    {
+      return count ? static_cast<double>(sum) / static_cast<double>(count) : 0;
+    }
+  };
+
+  /**
+   * @brief The statistics of the data pipeline of the driver.
+   *
+   * @details The durations are in microseconds. All the values are related to
+   * the last measurement.
+   *
+   * @see statistics().
+   */
+  struct Statistics final {
+    /// The durations of the iterations of the data reading loop.
+    Histogram read_loop_duration;
+
+    /// The numbers of chunks (samples of all channels) read per read.
+    Histogram read_chunk_count;
+
+    /// The current number of samples in the queue of the data read.
+    std::size_t queue_size{};
+
+    /// The capacity of the queue of the data read (see queue_capacity()).
+    std::size_t queue_capacity{};
+
+    /// The high-water mark of the queue (see queue_high_water_mark()).
+    std::size_t queue_high_water_mark{};
+
+    /// The durations of resampling of the batches of data read.
+    Histogram resampling_duration;
+
+    /// The durations of calls of the data handlers (including subscribers').
+    Histogram handler_duration;
+
+    /**
+     * @brief The number of calls of the data handlers which took longer than
+     * the duration of the data passed to them (i.e. the row count divided by
+     * the sample rate).
+     */
+    std::uint64_t handler_overrun_count{};
+
+    /// The number of reads whose data is dropped because the queue is full.
+    std::uint64_t dropped_batch_count{};
+
+    /**
+     * @brief The number of bursts dropped because the handler queue is full
+     * (see Driver_settings::set_handler_queue_size()).
+     */
+    std::uint64_t dropped_burst_count{};
+
+    /**
+     * @brief The maximum number of bursts which have been in the handler
+     * queue at once. (Doesn't exceed Driver_settings::handler_queue_size()
+     * while the measurement is running.)
+     */
+    std::size_t handler_queue_high_water_mark{};
+
+    /// The number of bytes written by the recorders (see add_recorder()).
+    std::uint64_t recorded_byte_count{};
+
+    /// The number of files created by the recorders.
+    std::uint64_t recorded_file_count{};
+
+    /**
+     * @brief The number of times the recorders waited for the file I/O
+     * because it's slower than the data.
+     */
+    std::uint64_t recorder_stall_count{};
+
+    /**
+     * @brief The number of samples (at the sample rate of the board) lost
+     * either on the board or because the queue is full.
+     */
+    std::uint64_t lost_sample_count{};
+  };
+
+  /// The tag type to select the overload of start_measurement().
+  struct Zero_copy final {};
+
+  /// The tag to select the overload of start_measurement().
+  static constexpr Zero_copy zero_copy{};
+
+  /// The tag type to select the overload of start_measurement().
+  struct Pull final {};
+
+  /// The tag to select the overload of start_measurement().
+  static constexpr Pull pull{};
+
+  /// The tag type to select the overload of add_subscriber().
+  struct Raw final {};
+
+  /// The tag to select the overload of add_subscriber().
+  static constexpr Raw raw{};
+
   /**
    * @brief The destructor. Calls stop_measurement().
    *
@@ -119,6 +445,16 @@ public:
   /// @returns Max possible sample rate per second the driver can handle.
   virtual int max_sample_rate() const = 0;
 
+  /**
+   * @returns Min possible sample rate per second of the subscriber.
+   *
+   * @details The data of the subscriber is resampled by the cascade of the
+   * decimation stages, so this rate is much less than min_sample_rate().
+   *
+   * @see add_subscriber().
+   */
+  virtual int min_subscriber_sample_rate() const = 0;
+
   /// @returns Max possible number of (data) channels the board provides.
   virtual unsigned max_channel_count() const = 0;
 
@@ -219,6 +555,9 @@ public:
    * `driver_settings().burst_buffer_size() / driver_settings().sample_rate()`
    * seconds of runtime! Otherwise, the driver will throttle by skipping the
    * incoming data and `handler` will be called with positive error marker.
+   * (Unless the handler queue is enabled, in which case the `handler` may be
+   * late as long as the queue isn't full. See
+   * Driver_settings::set_handler_queue_size().)
    *
    * @warning This method cannot be called from `handler`.
    *
@@ -240,6 +579,158 @@ public:
    */
   virtual void start_measurement(Data_handler handler) = 0;
 
+  /**
+   * @brief Starts the measurement with the handler which receives the view
+   * of data owned by the driver.
+   *
+   * @details Works like `start_measurement(Data_handler)`, but the memory
+   * viewed by the `handler` is reused by the driver after the `handler`
+   * returns, so the data is neither copied to nor allocated for the `handler`.
+   * Usage example:
+   * @code
+   * driver.start_measurement(Driver::zero_copy, [](const auto& data, int)
+   * {
+   *   // Process data.column(0) ...
+   * });
+   * @endcode
+   *
+   * @see start_measurement(Data_handler).
+   */
+  virtual void start_measurement(Zero_copy, Data_view_handler handler) = 0;
+
+  /**
+   * @brief Starts the measurement with the subscribers only.
+   *
+   * @details Works like `start_measurement(Data_handler)`, but the data is
+   * passed only to the subscribers, so `driver_settings().sample_rate()` is
+   * not required.
+   *
+   * @par Requires
+   * At least one subscriber is added.
+   *
+   * @see add_subscriber().
+   */
+  virtual void start_measurement() = 0;
+
+  /**
+   * @brief Starts the measurement the data of which is taken by read().
+   *
+   * @details Works like `start_measurement(Data_handler)`, but the data is
+   * accumulated in the bounded buffer of the driver instead of being passed
+   * to the handler. The capacity of the buffer and the policy of handling
+   * its overflow are specified by the driver settings. Usage example:
+   * @code
+   * driver.start_measurement(Driver::pull);
+   * while (...) {
+   *   auto data = driver.read(4800, std::chrono::milliseconds{500});
+   *   // Process data ...
+   *   driver.recycle_data(std::move(data));
+   * }
+   * @endcode
+   *
+   * @remarks The unread data of the previous measurement is discarded.
+   *
+   * @see read(), Driver_settings::set_read_buffer_size(),
+   * Driver_settings::set_read_overflow_policy().
+   */
+  virtual void start_measurement(Pull) = 0;
+
+  /**
+   * @brief Adds the subscriber to the data of the subsequent measurements.
+   *
+   * @details The data of the board is read and decoded once and then passed
+   * to the handler of measurement (if any) and to each of the subscribers.
+   * Each subscriber is resampled to its own `sample_rate` and receives the
+   * data by bursts of its own `burst_buffer_size`. Within the `handler`,
+   * data_info() returns the information about the data of this subscriber.
+   *
+   * @par Requires
+   * `(handler &&
+   *   !is_measurement_started() &&
+   *   (min_subscriber_sample_rate() <= sample_rate &&
+   *    sample_rate <= max_sample_rate()) &&
+   *   (1 <= burst_buffer_size && burst_buffer_size <= max_sample_rate()))`.
+   *
+   * @par Exception safety guarantee
+   * Strong.
+   *
+   * @see remove_subscribers(), start_measurement().
+   */
+  virtual void add_subscriber(int sample_rate, std::size_t burst_buffer_size,
+    Data_handler handler) = 0;
+
+  /**
+   * @brief Adds the subscriber with the handler which receives the view of
+   * data owned by the driver.
+   *
+   * @see add_subscriber(int, std::size_t, Data_handler),
+   * start_measurement(Zero_copy, Data_view_handler).
+   */
+  virtual void add_subscriber(int sample_rate, std::size_t burst_buffer_size,
+    Zero_copy, Data_view_handler handler) = 0;
+
+  /**
+   * @brief Adds the subscriber with the handler which receives the view of
+   * the raw data owned by the driver.
+   *
+   * @details The raw data is half the size of the data, so it's cheaper to
+   * queue, record or forward, while the values can be calculated by using
+   * value_transforms() whenever needed. The raw data isn't resampled, so it's
+   * received at max_sample_rate().
+   *
+   * @par Requires
+   * `(handler && !is_measurement_started() &&
+   *   (1 <= burst_buffer_size && burst_buffer_size <= max_sample_rate()))`.
+   *
+   * @par Exception safety guarantee
+   * Strong.
+   *
+   * @see add_subscriber(int, std::size_t, Data_handler), value_transforms().
+   */
+  virtual void add_subscriber(std::size_t burst_buffer_size, Raw,
+    Raw_data_view_handler handler) = 0;
+
+  /**
+   * @brief Adds the subscriber which records the data to the files.
+   *
+   * @details The data is received as by the subscriber with the given
+   * `sample_rate` and `burst_buffer_size`, and is written to the files by the
+   * dedicated thread according to the `options` (see Recorder_options), so the
+   * file I/O doesn't block the measurement unless the storage is slower than
+   * the data. Each measurement is recorded to the new file. The format
+   * `Recorder_format::compressed_capture` records the raw data (see
+   * add_subscriber(std::size_t, Raw, Raw_data_view_handler)), and thus
+   * requires `sample_rate == max_sample_rate()`. The chunk of the capture
+   * formats (see Recorder_options::set_chunk_row_count()) must fit into the
+   * buffer along with its header.
+   *
+   * @par Requires
+   * `(!is_measurement_started() &&
+   *   (min_subscriber_sample_rate() <= sample_rate &&
+   *    sample_rate <= max_sample_rate()) &&
+   *   (1 <= burst_buffer_size && burst_buffer_size <= max_sample_rate()))`.
+   *
+   * @par Exception safety guarantee
+   * Strong.
+   *
+   * @remarks The failure of the file I/O stops the recording, and is reported
+   * by the exception thrown by stop_measurement().
+   *
+   * @see remove_subscribers(), statistics().
+   */
+  virtual void add_recorder(int sample_rate, std::size_t burst_buffer_size,
+    Recorder_options options) = 0;
+
+  /**
+   * @brief Removes all the subscribers.
+   *
+   * @par Requires
+   * `!is_measurement_started()`.
+   *
+   * @see add_subscriber().
+   */
+  virtual void remove_subscribers() = 0;
+
   /**
    * @returns `true` if the measurement mode is started.
    *
@@ -267,10 +758,136 @@ public:
    * @par Exception safety guarantee
    * Strong.
    *
+   * @throws The exception of the failure of the recorder (see add_recorder())
+   * after the measurement is stopped.
+   *
    * @see start_measurement().
    */
   virtual void stop_measurement() = 0;
 
+  /**
+   * @brief Takes the data from the buffer of the measurement started by
+   * `start_measurement(Pull)`.
+   *
+   * @details Waits until either the buffer contains `max_row_count` rows (or
+   * as many rows as it can hold, if less), the `timeout` expires or the
+   * measurement is stopped.
+   *
+   * @returns The data of no more than `max_row_count` rows, which is empty
+   * if no data is available upon return.
+   *
+   * @par Requires
+   * The last measurement is started by `start_measurement(Pull)`.
+   *
+   * @remarks This method is thread-safe, and the unread data can be taken
+   * after stop_measurement() as well.
+   *
+   * @see read_lost_sample_count(), recycle_data().
+   */
+  virtual Data read(std::size_t max_row_count, std::chrono::milliseconds timeout) = 0;
+
+  /**
+   * @returns The total number of samples lost by the measurement started by
+   * `start_measurement(Pull)`, including both the samples lost by the board
+   * and the ones discarded upon the overflow of the read buffer.
+   *
+   * @see read().
+   */
+  virtual std::uint64_t read_lost_sample_count() const = 0;
+
+  /**
+   * @brief Returns the `data` passed to the handler back to the driver.
+   *
+   * @details The storage of the `data` will be reused by the driver for the
+   * subsequent data passed to the handler. If the data is not returned, the
+   * driver allocates the new storage instead.
+   *
+   * @remarks This method is thread-safe and can be called from the handler.
+   *
+   * @see start_measurement(), data_allocation_count().
+   */
+  virtual void recycle_data(Data&& data) = 0;
+
+  /**
+   * @returns The number of data buffers allocated by the driver. This number
+   * is not increased during the measurement as long as all the data passed
+   * to the handler is returned by recycle_data().
+   */
+  virtual std::uint64_t data_allocation_count() const = 0;
+
+  /**
+   * @returns The report on the real-time requests made upon the last call of
+   * start_measurement().
+   *
+   * @see Driver_settings::set_scheduling_policy(),
+   * Driver_settings::set_reading_thread_cpu(),
+   * Driver_settings::set_memory_locking().
+   */
+  virtual Realtime_report realtime_report() const = 0;
+
+  /**
+   * @returns The number of samples the queue of the data read from the board
+   * can hold during the last measurement.
+   *
+   * @see Driver_settings::set_queue_memory_budget(), queue_high_water_mark().
+   */
+  virtual std::size_t queue_capacity() const = 0;
+
+  /**
+   * @returns The maximum number of samples held in the queue of the data
+   * read from the board during the last measurement.
+   *
+   * @remarks The value close to queue_capacity() indicates that the data is
+   * at the risk of being lost.
+   *
+   * @see queue_capacity(), Data_info::queue_size.
+   */
+  virtual std::size_t queue_high_water_mark() const = 0;
+
+  /**
+   * @returns The snapshot of the statistics of the data pipeline.
+   *
+   * @remarks The statistics is gathered by using the relaxed atomic counters,
+   * so this method can be called at any time from any thread, but the values
+   * of the snapshot are not necessarily consistent with each other.
+   *
+   * @see Statistics.
+   */
+  virtual Statistics statistics() const = 0;
+
+  /**
+   * @brief Writes the trace of the data pipeline of the last measurement to
+   * `out` in the Chrome trace event format (JSON), which can be opened in
+   * Perfetto or `chrome://tracing`.
+   *
+   * @details The trace contains the events of the reading of the data from
+   * the board, the decoding, the resampling, the burst assembly and the calls
+   * of the data handlers of each thread. The trace has no events unless the
+   * driver is built with the CMake option `PANDA_TIMESWIPE_TRACE`.
+   *
+   * @par Requires
+   * `!is_measurement_started()`, since the trace is written by the threads
+   * of the measurement.
+   */
+  virtual void write_trace(std::ostream& out) const = 0;
+
+  /**
+   * @returns The information about the data being passed to the handler.
+   *
+   * @warning This method must be called from the handler only.
+   *
+   * @see start_measurement().
+   */
+  virtual const Data_info& data_info() const noexcept = 0;
+
+  /**
+   * @returns The transformations of the codes of the raw data to the values
+   * for each channel, which are set upon start_measurement().
+   *
+   * @see add_subscriber(std::size_t, Raw, Raw_data_view_handler).
+   */
+  virtual std::vector<Value_transform> value_transforms() const = 0;
+
   /// @}
 
   /// @name Drift Compensation
@@ -53,6 +53,30 @@ struct Driver_settings::Rep final {
     check_burst_buffer_size(bbs);
     check_frequency(freq);
 
+    // Check wakeup policy. (The conversion throws if it's invalid.)
+    wakeup_policy();
+
+    // Check read buffer settings.
+    check_read_buffer_size(read_buffer_size());
+    check_read_overflow_policy(read_overflow_policy());
+
+    // Check handler queue settings.
+    check_handler_queue_size(handler_queue_size());
+    handler_overflow_policy();
+
+    // Check queue memory budget.
+    check_queue_memory_budget(queue_memory_budget());
+
+    // Check real-time settings.
+    scheduling_policy();
+    check_thread_priority(reading_thread_priority());
+    check_thread_priority(processing_thread_priority());
+    check_thread_priority(handling_thread_priority());
+    check_thread_cpu(reading_thread_cpu());
+    check_thread_cpu(processing_thread_cpu());
+    check_thread_cpu(handling_thread_cpu());
+    memory_locking();
+
     // Check translation offsets.
     check_translation_offsets(translation_offsets());
 
@@ -98,6 +122,20 @@ struct Driver_settings::Rep final {
     apply(&Rep::set_sample_rate, other.sample_rate());
     apply(&Rep::set_burst_buffer_size, other.burst_buffer_size());
     apply(&Rep::set_frequency, other.frequency());
+    apply(&Rep::set_wakeup_policy, other.wakeup_policy());
+    apply(&Rep::set_read_buffer_size, other.read_buffer_size());
+    apply(&Rep::set_read_overflow_policy, other.read_overflow_policy());
+    apply(&Rep::set_handler_queue_size, other.handler_queue_size());
+    apply(&Rep::set_handler_overflow_policy, other.handler_overflow_policy());
+    apply(&Rep::set_queue_memory_budget, other.queue_memory_budget());
+    apply(&Rep::set_scheduling_policy, other.scheduling_policy());
+    apply(&Rep::set_reading_thread_priority, other.reading_thread_priority());
+    apply(&Rep::set_processing_thread_priority, other.processing_thread_priority());
+    apply(&Rep::set_handling_thread_priority, other.handling_thread_priority());
+    apply(&Rep::set_reading_thread_cpu, other.reading_thread_cpu());
+    apply(&Rep::set_processing_thread_cpu, other.processing_thread_cpu());
+    apply(&Rep::set_handling_thread_cpu, other.handling_thread_cpu());
+    apply(&Rep::set_memory_locking, other.memory_locking());
     apply(&Rep::set_translation_offsets, other.translation_offsets());
     apply(&Rep::set_translation_slopes, other.translation_slopes());
   }
@@ -113,6 +151,20 @@ struct Driver_settings::Rep final {
       !(sample_rate() ||
         burst_buffer_size() ||
         frequency() ||
+        wakeup_policy() ||
+        read_buffer_size() ||
+        read_overflow_policy() ||
+        handler_queue_size() ||
+        handler_overflow_policy() ||
+        queue_memory_budget() ||
+        scheduling_policy() ||
+        reading_thread_priority() ||
+        processing_thread_priority() ||
+        handling_thread_priority() ||
+        reading_thread_cpu() ||
+        processing_thread_cpu() ||
+        handling_thread_cpu() ||
+        memory_locking() ||
         translation_offsets() ||
         translation_slopes());
   }
@@ -154,6 +206,156 @@ struct Driver_settings::Rep final {
     return member<int>("frequency");
   }
 
+  void set_wakeup_policy(const std::optional<Wakeup_policy> policy)
+  {
+    set_member("wakeupPolicy", policy);
+  }
+
+  std::optional<Wakeup_policy> wakeup_policy() const
+  {
+    return member<Wakeup_policy>("wakeupPolicy");
+  }
+
+  void set_read_buffer_size(const std::optional<std::size_t> size)
+  {
+    check_read_buffer_size(size);
+    set_member("readBufferSize", size);
+  }
+
+  std::optional<std::size_t> read_buffer_size() const
+  {
+    return member<std::size_t>("readBufferSize");
+  }
+
+  void set_read_overflow_policy(const std::optional<Overflow_policy> policy)
+  {
+    check_read_overflow_policy(policy);
+    set_member("readOverflowPolicy", policy);
+  }
+
+  std::optional<Overflow_policy> read_overflow_policy() const
+  {
+    return member<Overflow_policy>("readOverflowPolicy");
+  }
+
+  void set_handler_queue_size(const std::optional<std::size_t> size)
+  {
+    check_handler_queue_size(size);
+    set_member("handlerQueueSize", size);
+  }
+
+  std::optional<std::size_t> handler_queue_size() const
+  {
+    return member<std::size_t>("handlerQueueSize");
+  }
+
+  void set_handler_overflow_policy(const std::optional<Overflow_policy> policy)
+  {
+    set_member("handlerOverflowPolicy", policy);
+  }
+
+  std::optional<Overflow_policy> handler_overflow_policy() const
+  {
+    return member<Overflow_policy>("handlerOverflowPolicy");
+  }
+
+  void set_queue_memory_budget(const std::optional<std::size_t> budget)
+  {
+    check_queue_memory_budget(budget);
+    set_member("queueMemoryBudget", budget);
+  }
+
+  std::optional<std::size_t> queue_memory_budget() const
+  {
+    return member<std::size_t>("queueMemoryBudget");
+  }
+
+  void set_scheduling_policy(const std::optional<Scheduling_policy> policy)
+  {
+    set_member("schedulingPolicy", policy);
+  }
+
+  std::optional<Scheduling_policy> scheduling_policy() const
+  {
+    return member<Scheduling_policy>("schedulingPolicy");
+  }
+
+  void set_reading_thread_priority(const std::optional<int> priority)
+  {
+    check_thread_priority(priority);
+    set_member("readingThreadPriority", priority);
+  }
+
+  std::optional<int> reading_thread_priority() const
+  {
+    return member<int>("readingThreadPriority");
+  }
+
+  void set_processing_thread_priority(const std::optional<int> priority)
+  {
+    check_thread_priority(priority);
+    set_member("processingThreadPriority", priority);
+  }
+
+  std::optional<int> processing_thread_priority() const
+  {
+    return member<int>("processingThreadPriority");
+  }
+
+  void set_handling_thread_priority(const std::optional<int> priority)
+  {
+    check_thread_priority(priority);
+    set_member("handlingThreadPriority", priority);
+  }
+
+  std::optional<int> handling_thread_priority() const
+  {
+    return member<int>("handlingThreadPriority");
+  }
+
+  void set_reading_thread_cpu(const std::optional<int> cpu)
+  {
+    check_thread_cpu(cpu);
+    set_member("readingThreadCpu", cpu);
+  }
+
+  std::optional<int> reading_thread_cpu() const
+  {
+    return member<int>("readingThreadCpu");
+  }
+
+  void set_processing_thread_cpu(const std::optional<int> cpu)
+  {
+    check_thread_cpu(cpu);
+    set_member("processingThreadCpu", cpu);
+  }
+
+  std::optional<int> processing_thread_cpu() const
+  {
+    return member<int>("processingThreadCpu");
+  }
+
+  void set_handling_thread_cpu(const std::optional<int> cpu)
+  {
+    check_thread_cpu(cpu);
+    set_member("handlingThreadCpu", cpu);
+  }
+
+  std::optional<int> handling_thread_cpu() const
+  {
+    return member<int>("handlingThreadCpu");
+  }
+
+  void set_memory_locking(const std::optional<bool> enabled)
+  {
+    set_member("memoryLocking", enabled);
+  }
+
+  std::optional<bool> memory_locking() const
+  {
+    return member<bool>("memoryLocking");
+  }
+
   void set_translation_offsets(const std::optional<std::vector<float>>& values)
   {
     check_translation_offsets(values);
@@ -211,6 +413,46 @@ private:
     }
   }
 
+  static void check_read_buffer_size(const std::optional<std::size_t> size)
+  {
+    if (size && !*size)
+      throw Exception{Errc::driver_settings_invalid, "invalid read buffer size"};
+  }
+
+  static void check_read_overflow_policy(const std::optional<Overflow_policy> policy)
+  {
+    if (policy == Overflow_policy::coalesce)
+      throw Exception{Errc::driver_settings_invalid, "invalid read overflow policy"};
+  }
+
+  static void check_handler_queue_size(const std::optional<std::size_t> size)
+  {
+    if (size && !*size)
+      throw Exception{Errc::driver_settings_invalid, "invalid handler queue size"};
+  }
+
+  static void check_queue_memory_budget(const std::optional<std::size_t> budget)
+  {
+    if (budget && !*budget)
+      throw Exception{Errc::driver_settings_invalid, "invalid queue memory budget"};
+  }
+
+  static void check_thread_priority(const std::optional<int> priority)
+  {
+    if (priority) {
+      if (!(0 <= *priority && *priority <= 99))
+        throw Exception{Errc::driver_settings_invalid, "invalid thread priority"};
+    }
+  }
+
+  static void check_thread_cpu(const std::optional<int> cpu)
+  {
+    if (cpu) {
+      if (!(*cpu >= 0))
+        throw Exception{Errc::driver_settings_invalid, "invalid thread CPU"};
+    }
+  }
+
   static void check_translation_offsets(const std::optional<std::vector<float>>& values)
   {
     if (!(!values || (values->size() == Driver::instance().max_channel_count())))
@@ -336,6 +578,170 @@ std::optional<int> Driver_settings::frequency() const
   return rep_->frequency();
 }
 
+Driver_settings&
+Driver_settings::set_wakeup_policy(const std::optional<Wakeup_policy> policy)
+{
+  rep_->set_wakeup_policy(policy);
+  return *this;
+}
+
+std::optional<Wakeup_policy> Driver_settings::wakeup_policy() const
+{
+  return rep_->wakeup_policy();
+}
+
+Driver_settings&
+Driver_settings::set_read_buffer_size(const std::optional<std::size_t> size)
+{
+  rep_->set_read_buffer_size(size);
+  return *this;
+}
+
+std::optional<std::size_t> Driver_settings::read_buffer_size() const
+{
+  return rep_->read_buffer_size();
+}
+
+Driver_settings&
+Driver_settings::set_read_overflow_policy(const std::optional<Overflow_policy> policy)
+{
+  rep_->set_read_overflow_policy(policy);
+  return *this;
+}
+
+std::optional<Overflow_policy> Driver_settings::read_overflow_policy() const
+{
+  return rep_->read_overflow_policy();
+}
+
+Driver_settings&
+Driver_settings::set_handler_queue_size(const std::optional<std::size_t> size)
+{
+  rep_->set_handler_queue_size(size);
+  return *this;
+}
+
+std::optional<std::size_t> Driver_settings::handler_queue_size() const
+{
+  return rep_->handler_queue_size();
+}
+
+Driver_settings&
+Driver_settings::set_handler_overflow_policy(const std::optional<Overflow_policy> policy)
+{
+  rep_->set_handler_overflow_policy(policy);
+  return *this;
+}
+
+std::optional<Overflow_policy> Driver_settings::handler_overflow_policy() const
+{
+  return rep_->handler_overflow_policy();
+}
+
+Driver_settings&
+Driver_settings::set_queue_memory_budget(const std::optional<std::size_t> budget)
+{
+  rep_->set_queue_memory_budget(budget);
+  return *this;
+}
+
+std::optional<std::size_t> Driver_settings::queue_memory_budget() const
+{
+  return rep_->queue_memory_budget();
+}
+
+Driver_settings&
+Driver_settings::set_scheduling_policy(const std::optional<Scheduling_policy> policy)
+{
+  rep_->set_scheduling_policy(policy);
+  return *this;
+}
+
+std::optional<Scheduling_policy> Driver_settings::scheduling_policy() const
+{
+  return rep_->scheduling_policy();
+}
+
+Driver_settings&
+Driver_settings::set_reading_thread_priority(const std::optional<int> priority)
+{
+  rep_->set_reading_thread_priority(priority);
+  return *this;
+}
+
+std::optional<int> Driver_settings::reading_thread_priority() const
+{
+  return rep_->reading_thread_priority();
+}
+
+Driver_settings&
+Driver_settings::set_processing_thread_priority(const std::optional<int> priority)
+{
+  rep_->set_processing_thread_priority(priority);
+  return *this;
+}
+
+std::optional<int> Driver_settings::processing_thread_priority() const
+{
+  return rep_->processing_thread_priority();
+}
+
+Driver_settings&
+Driver_settings::set_handling_thread_priority(const std::optional<int> priority)
+{
+  rep_->set_handling_thread_priority(priority);
+  return *this;
+}
+
+std::optional<int> Driver_settings::handling_thread_priority() const
+{
+  return rep_->handling_thread_priority();
+}
+
+Driver_settings& Driver_settings::set_reading_thread_cpu(const std::optional<int> cpu)
+{
+  rep_->set_reading_thread_cpu(cpu);
+  return *this;
+}
+
+std::optional<int> Driver_settings::reading_thread_cpu() const
+{
+  return rep_->reading_thread_cpu();
+}
+
+Driver_settings& Driver_settings::set_processing_thread_cpu(const std::optional<int> cpu)
+{
+  rep_->set_processing_thread_cpu(cpu);
+  return *this;
+}
+
+std::optional<int> Driver_settings::processing_thread_cpu() const
+{
+  return rep_->processing_thread_cpu();
+}
+
+Driver_settings& Driver_settings::set_handling_thread_cpu(const std::optional<int> cpu)
+{
+  rep_->set_handling_thread_cpu(cpu);
+  return *this;
+}
+
+std::optional<int> Driver_settings::handling_thread_cpu() const
+{
+  return rep_->handling_thread_cpu();
+}
+
+Driver_settings& Driver_settings::set_memory_locking(const std::optional<bool> enabled)
+{
+  rep_->set_memory_locking(enabled);
+  return *this;
+}
+
+std::optional<bool> Driver_settings::memory_locking() const
+{
+  return rep_->memory_locking();
+}
+
 Driver_settings&
 Driver_settings::set_translation_offsets(const std::optional<std::vector<float>>& values)
 {
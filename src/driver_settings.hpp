@@ -19,6 +19,8 @@
 #ifndef PANDA_TIMESWIPE_DRIVER_SETTINGS_HPP
 #define PANDA_TIMESWIPE_DRIVER_SETTINGS_HPP
 
+#include "basics.hpp"
+
 #include <cstdint>
 #include <memory>
 #include <optional>
@@ -61,7 +63,21 @@ public:
    *   - `burstBufferSize` - an integer (see burst_buffer_size());
    *   - `frequency` - an integer (see frequency());
    *   - `translationOffsets` - an array of integers (see translation_offsets());
-   *   - `translationSlopes` - an array of floats (see translation_slopes()).
+   *   - `translationSlopes` - an array of floats (see translation_slopes());
+   *   - `wakeupPolicy` - an integer (see wakeup_policy());
+   *   - `readBufferSize` - an integer (see read_buffer_size());
+   *   - `readOverflowPolicy` - an integer (see read_overflow_policy());
+   *   - `handlerQueueSize` - an integer (see handler_queue_size());
+   *   - `handlerOverflowPolicy` - an integer (see handler_overflow_policy());
+   *   - `queueMemoryBudget` - an integer (see queue_memory_budget());
+   *   - `schedulingPolicy` - an integer (see scheduling_policy());
+   *   - `readingThreadPriority` - an integer (see reading_thread_priority());
+   *   - `processingThreadPriority` - an integer (see processing_thread_priority());
+   *   - `handlingThreadPriority` - an integer (see handling_thread_priority());
+   *   - `readingThreadCpu` - an integer (see reading_thread_cpu());
+   *   - `processingThreadCpu` - an integer (see processing_thread_cpu());
+   *   - `handlingThreadCpu` - an integer (see handling_thread_cpu());
+   *   - `memoryLocking` - a boolean (see memory_locking()).
    * The exception with code `Errc::driver_settings_invalid` will be thrown if
    * both `burstBufferSize` and `frequency` are presents in the same JSON input.
    *
@@ -173,6 +189,370 @@ public:
    */
   std::optional<int> frequency() const;
 
+  /**
+   * @brief Sets the policy of waking up the thread which processes the data
+   * read from the board and calls Driver::Data_handler.
+   *
+   * @details If this setting isn't set, the driver will use
+   * `Wakeup_policy::low_latency`. The `Wakeup_policy::low_cpu` reduces the
+   * number of wakeups at the cost of the latency when the burst buffer size
+   * is small.
+   *
+   * @returns The reference to this instance.
+   *
+   * @warning This setting can be applied with Driver::set_driver_settings()
+   * only if `!Driver::instance().is_measurement_started(true)`.
+   *
+   * @see wakeup_policy().
+   */
+  Driver_settings& set_wakeup_policy(std::optional<Wakeup_policy> policy);
+
+  /**
+   * @returns The wakeup policy.
+   *
+   * @see set_wakeup_policy().
+   */
+  std::optional<Wakeup_policy> wakeup_policy() const;
+
+  /**
+   * @brief Sets the capacity (in samples) of the buffer from which the data
+   * is taken by Driver::read().
+   *
+   * @details If this setting isn't set, the driver will use the buffer of
+   * one second of data.
+   *
+   * @par Requires
+   * `(!size || *size > 0)`.
+   *
+   * @returns The reference to this instance.
+   *
+   * @warning This setting can be applied with Driver::set_driver_settings()
+   * only if `!Driver::instance().is_measurement_started(true)`.
+   *
+   * @see read_buffer_size(), set_read_overflow_policy().
+   */
+  Driver_settings& set_read_buffer_size(std::optional<std::size_t> size);
+
+  /**
+   * @returns The read buffer size.
+   *
+   * @see set_read_buffer_size().
+   */
+  std::optional<std::size_t> read_buffer_size() const;
+
+  /**
+   * @brief Sets the policy of handling the overflow of the buffer from which
+   * the data is taken by Driver::read().
+   *
+   * @details If this setting isn't set, the driver will use
+   * `Overflow_policy::block`, in which case the data isn't lost as long as
+   * the reader is behind for no more than the time the driver is able to
+   * queue the data read from the board.
+   *
+   * @par Requires
+   * `(policy != Overflow_policy::coalesce)`.
+   *
+   * @returns The reference to this instance.
+   *
+   * @warning This setting can be applied with Driver::set_driver_settings()
+   * only if `!Driver::instance().is_measurement_started(true)`.
+   *
+   * @see read_overflow_policy(), set_read_buffer_size().
+   */
+  Driver_settings& set_read_overflow_policy(std::optional<Overflow_policy> policy);
+
+  /**
+   * @returns The read overflow policy.
+   *
+   * @see set_read_overflow_policy().
+   */
+  std::optional<Overflow_policy> read_overflow_policy() const;
+
+  /**
+   * @brief Sets the number of bursts of the queue of the data handlers.
+   *
+   * @details If this setting is set, the data handlers (including the ones of
+   * the subscribers) are called by the dedicated thread rather than by the
+   * thread which processes the data, and the bursts are passed to this thread
+   * through the queue of the given size. Thus, the processing (decoding and
+   * resampling) keeps going while the slow handler catches up, and what
+   * happens when the queue is full depends on handler_overflow_policy().
+   * If this setting isn't set, the handlers are called by the processing
+   * thread, which doesn't process the data while the handler is running.
+   * The real-time requests for this thread are set by
+   * set_handling_thread_priority() and set_handling_thread_cpu().
+   *
+   * @par Requires
+   * `(!size || *size > 0)`.
+   *
+   * @returns The reference to this instance.
+   *
+   * @warning This setting can be applied with Driver::set_driver_settings()
+   * only if `!Driver::instance().is_measurement_started(true)`.
+   *
+   * @see handler_queue_size(), set_handler_overflow_policy().
+   */
+  Driver_settings& set_handler_queue_size(std::optional<std::size_t> size);
+
+  /**
+   * @returns The handler queue size.
+   *
+   * @see set_handler_queue_size().
+   */
+  std::optional<std::size_t> handler_queue_size() const;
+
+  /**
+   * @brief Sets the policy of handling the overflow of the queue of the data
+   * handlers.
+   *
+   * @details If this setting isn't set, the driver will use
+   * `Overflow_policy::block`. The bursts dropped from the queue are reported
+   * to the handler of the subscriber as the lost samples (see
+   * Driver::Data_info). With `Overflow_policy::coalesce` the burst is
+   * appended to the newest queued burst of the same subscriber, so the
+   * handler is called less often but with more data. If the burst doesn't
+   * continue the queued one (e.g. because of the lost samples, or because the
+   * queue is full of the bursts of the other subscribers), the oldest burst
+   * is dropped as with `Overflow_policy::drop_oldest`.
+   *
+   * @returns The reference to this instance.
+   *
+   * @warning This setting can be applied with Driver::set_driver_settings()
+   * only if `!Driver::instance().is_measurement_started(true)`.
+   *
+   * @see handler_overflow_policy(), set_handler_queue_size().
+   */
+  Driver_settings& set_handler_overflow_policy(std::optional<Overflow_policy> policy);
+
+  /**
+   * @returns The handler overflow policy.
+   *
+   * @see set_handler_overflow_policy().
+   */
+  std::optional<Overflow_policy> handler_overflow_policy() const;
+
+  /**
+   * @brief Sets the memory (in bytes) of the queue of the data read from
+   * the board but not yet processed.
+   *
+   * @details The queue holds the data as it comes from the board, which
+   * takes 8 bytes per sample of all the channels. If this setting isn't set,
+   * the driver will use the queue of two seconds of data at the maximum
+   * sample rate (768 KB). The data read from the board is lost when the queue
+   * is full, which happens if the processing (including the data handlers)
+   * is behind the board for longer than the queue can hold.
+   *
+   * @par Requires
+   * `(!budget || *budget > 0)`.
+   *
+   * @returns The reference to this instance.
+   *
+   * @warning This setting can be applied with Driver::set_driver_settings()
+   * only if `!Driver::instance().is_measurement_started(true)`.
+   *
+   * @see queue_memory_budget(), Driver::queue_capacity(),
+   * Driver::queue_high_water_mark().
+   */
+  Driver_settings& set_queue_memory_budget(std::optional<std::size_t> budget);
+
+  /**
+   * @returns The queue memory budget.
+   *
+   * @see set_queue_memory_budget().
+   */
+  std::optional<std::size_t> queue_memory_budget() const;
+
+  /// @name Real-time control
+  ///
+  /// @brief This API allows to reduce the chance of data loss caused by the
+  /// preemption of the driver threads by other processes.
+  ///
+  /// @details The driver runs two threads during the measurement: the thread
+  /// which reads the data from the board, and the thread which processes the
+  /// data and calls Driver::Data_handler. If handler_queue_size() is set, the
+  /// handlers are called by the third thread instead (see
+  /// set_handler_queue_size()). These settings are applied upon
+  /// Driver::start_measurement(). Most of them require the privileges (such as
+  /// `CAP_SYS_NICE` and `CAP_IPC_LOCK`), so it's not an error if the request
+  /// is not granted. Use Driver::realtime_report() to check what is granted.
+  ///
+  /// @warning These settings can be applied with Driver::set_driver_settings()
+  /// only if `!Driver::instance().is_measurement_started(true)`.
+  ///
+  /// @{
+
+  /**
+   * @brief Sets the scheduling policy of the driver threads.
+   *
+   * @details If this setting isn't set, the scheduling of the driver threads
+   * isn't changed.
+   *
+   * @returns The reference to this instance.
+   *
+   * @see scheduling_policy(), set_reading_thread_priority(),
+   * set_processing_thread_priority(), set_handling_thread_priority().
+   */
+  Driver_settings& set_scheduling_policy(std::optional<Scheduling_policy> policy);
+
+  /**
+   * @returns The scheduling policy of the driver threads.
+   *
+   * @see set_scheduling_policy().
+   */
+  std::optional<Scheduling_policy> scheduling_policy() const;
+
+  /**
+   * @brief Sets the scheduling priority of the thread which reads the data.
+   *
+   * @details If this setting isn't set, the minimum priority of the
+   * scheduling_policy() is used.
+   *
+   * @par Requires
+   * `!priority || (0 <= *priority && *priority <= 99)`.
+   *
+   * @returns The reference to this instance.
+   *
+   * @remarks The priority must be zero for `Scheduling_policy::other`.
+   *
+   * @see reading_thread_priority().
+   */
+  Driver_settings& set_reading_thread_priority(std::optional<int> priority);
+
+  /**
+   * @returns The scheduling priority of the thread which reads the data.
+   *
+   * @see set_reading_thread_priority().
+   */
+  std::optional<int> reading_thread_priority() const;
+
+  /**
+   * @brief Sets the scheduling priority of the thread which processes the data.
+   *
+   * @details If this setting isn't set, the minimum priority of the
+   * scheduling_policy() is used.
+   *
+   * @par Requires
+   * `!priority || (0 <= *priority && *priority <= 99)`.
+   *
+   * @returns The reference to this instance.
+   *
+   * @see processing_thread_priority().
+   */
+  Driver_settings& set_processing_thread_priority(std::optional<int> priority);
+
+  /**
+   * @returns The scheduling priority of the thread which processes the data.
+   *
+   * @see set_processing_thread_priority().
+   */
+  std::optional<int> processing_thread_priority() const;
+
+  /**
+   * @brief Sets the scheduling priority of the thread which calls the
+   * handlers of the data (see set_handler_queue_size()).
+   *
+   * @details If this setting isn't set, the minimum priority of the
+   * scheduling_policy() is used.
+   *
+   * @par Requires
+   * `!priority || (0 <= *priority && *priority <= 99)`.
+   *
+   * @returns The reference to this instance.
+   *
+   * @see handling_thread_priority().
+   */
+  Driver_settings& set_handling_thread_priority(std::optional<int> priority);
+
+  /**
+   * @returns The scheduling priority of the thread which calls the handlers.
+   *
+   * @see set_handling_thread_priority().
+   */
+  std::optional<int> handling_thread_priority() const;
+
+  /**
+   * @brief Sets the CPU to pin the thread which reads the data to.
+   *
+   * @par Requires
+   * `!cpu || (*cpu >= 0)`.
+   *
+   * @returns The reference to this instance.
+   *
+   * @see reading_thread_cpu().
+   */
+  Driver_settings& set_reading_thread_cpu(std::optional<int> cpu);
+
+  /**
+   * @returns The CPU to pin the thread which reads the data to.
+   *
+   * @see set_reading_thread_cpu().
+   */
+  std::optional<int> reading_thread_cpu() const;
+
+  /**
+   * @brief Sets the CPU to pin the thread which processes the data to.
+   *
+   * @par Requires
+   * `!cpu || (*cpu >= 0)`.
+   *
+   * @returns The reference to this instance.
+   *
+   * @see processing_thread_cpu().
+   */
+  Driver_settings& set_processing_thread_cpu(std::optional<int> cpu);
+
+  /**
+   * @returns The CPU to pin the thread which processes the data to.
+   *
+   * @see set_processing_thread_cpu().
+   */
+  std::optional<int> processing_thread_cpu() const;
+
+  /**
+   * @brief Sets the CPU to pin the thread which calls the handlers of the
+   * data (see set_handler_queue_size()) to.
+   *
+   * @par Requires
+   * `!cpu || (*cpu >= 0)`.
+   *
+   * @returns The reference to this instance.
+   *
+   * @see handling_thread_cpu().
+   */
+  Driver_settings& set_handling_thread_cpu(std::optional<int> cpu);
+
+  /**
+   * @returns The CPU to pin the thread which calls the handlers to.
+   *
+   * @see set_handling_thread_cpu().
+   */
+  std::optional<int> handling_thread_cpu() const;
+
+  /**
+   * @brief Sets the memory locking.
+   *
+   * @details If `true`, all the memory of the process, current and future,
+   * is locked into RAM (by `mlockall()`), and the pipeline buffers and stacks
+   * of the driver threads are prefaulted, so the driver threads don't incur
+   * page faults during the measurement.
+   *
+   * @returns The reference to this instance.
+   *
+   * @remarks The memory remains locked after the measurement is stopped.
+   *
+   * @see memory_locking().
+   */
+  Driver_settings& set_memory_locking(std::optional<bool> enabled);
+
+  /**
+   * @returns The memory locking.
+   *
+   * @see set_memory_locking().
+   */
+  std::optional<bool> memory_locking() const;
+
+  /// @}
+
   /// @name Measured values transformation control
   ///
   /// @brief This API allows to control how the values, measured in `mV` must
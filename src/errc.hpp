@@ -91,7 +91,10 @@ enum class Errc {
   /// Some atom of EEPROM data is corrupted.
   hat_eeprom_atom_corrupted = 50211,
   /// Requested atom is not presents in EEPROM.
-  hat_eeprom_atom_missed = 50221
+  hat_eeprom_atom_missed = 50221,
+
+  /// Capture file is invalid (or corrupted).
+  capture_file_invalid = 60011
 };
 
 /**
@@ -158,6 +161,9 @@ constexpr const char* to_literal(const Errc errc) noexcept
     return "hat_eeprom_atom_corrupted";
   case Errc::hat_eeprom_atom_missed:
     return "hat_eeprom_atom_missed";
+
+  case Errc::capture_file_invalid:
+    return "capture_file_invalid";
   }
   return nullptr;
 }
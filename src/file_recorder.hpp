@@ -0,0 +1,704 @@
+// -*- C++ -*-
+
+// PANDA Timeswipe Project
+// Copyright (C) 2021  PANDA GmbH / Dmitry Igrishin
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef PANDA_TIMESWIPE_FILE_RECORDER_HPP
+#define PANDA_TIMESWIPE_FILE_RECORDER_HPP
+
+#include "capture_format.hpp"
+#include "debug.hpp"
+#include "delta_bitpack.hpp"
+#include "driver.hpp"
+#include "exceptions.hpp"
+#include "recorder.hpp"
+#include "table_view.hpp"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace panda::timeswipe::detail {
+
+/**
+ * @brief The recorder of the data to the files.
+ *
+ * @details The data is copied into one of the two buffers by the thread of
+ * the data handler, while the other one is written to the file by the writing
+ * thread. Thus, the handler waits for the file I/O only if the storage is
+ * slower than the data for longer than the duration of the buffer.
+ *
+ * In the capture format the buffer is filled by the chunks, each of which is
+ * closed either when it's full or upon the discontinuity of the sample index.
+ * (The codes of the compressed chunk are accumulated aside and are encoded
+ * into the buffer upon closing the chunk.)
+ * The index of the chunks of the buffer is passed to the writing thread along
+ * with the buffer, and the index of the chunks of the file is written at the
+ * end of the file upon closing it.
+ *
+ * @see Recorder_options, Capture_reader.
+ */
+class File_recorder final {
+public:
+  /// An alias of the data view.
+  using Data_view = Table_view<float>;
+
+  /// An alias of the raw data view.
+  using Raw_data_view = Table_view<std::uint16_t>;
+
+  /// The destructor. Stops the recording.
+  ~File_recorder()
+  {
+    try {
+      stop();
+    } catch (...) {}
+  }
+
+  /// The constructor.
+  explicit File_recorder(Recorder_options options)
+    : options_{std::move(options)}
+    , buffers_{make_buffer(options_.buffer_size()),
+               make_buffer(options_.buffer_size())}
+  {}
+
+  /// Non copy-constructible.
+  File_recorder(const File_recorder&) = delete;
+
+  /// Non copy-assignable.
+  File_recorder& operator=(const File_recorder&) = delete;
+
+  /// @returns The options.
+  const Recorder_options& options() const noexcept
+  {
+    return options_;
+  }
+
+  /**
+   * @brief Checks that the chunk of `column_count` columns fits into the
+   * buffer (if the format of the recording is the capture one).
+   *
+   * @throws Exception with the code `Errc::driver_settings_invalid` if the
+   * chunk doesn't fit into the buffer.
+   */
+  void check_chunk_size(const std::size_t column_count) const
+  {
+    const auto format = options_.format();
+    if (format == Recorder_format::raw)
+      return;
+
+    const auto encoding = format == Recorder_format::compressed_capture ?
+      capture::Encoding::delta_bitpack_codes : capture::Encoding::values;
+    if (capture::chunk_size(encoding, column_count, options_.chunk_row_count()) >
+      options_.buffer_size())
+      throw Exception{Errc::driver_settings_invalid,
+        "cannot record with chunk which doesn't fit into buffer"};
+  }
+
+  /**
+   * @brief Starts the writing thread.
+   *
+   * @details The data is written to the new file.
+   *
+   * @param column_count The number of columns of the data.
+   * @param sample_rate The sample rate of the data.
+   * @param transforms The transformations of the codes to the values of each
+   * column (see Driver::value_transforms()).
+   * @param metadata The metadata (JSON text) of the capture file.
+   *
+   * @par Requires
+   * The recording isn't started.
+   */
+  void start(const std::size_t column_count, const int sample_rate,
+    const std::vector<Driver::Value_transform>& transforms,
+    const std::string& metadata)
+  {
+    PANDA_TIMESWIPE_ASSERT(!thread_.joinable());
+    PANDA_TIMESWIPE_ASSERT(transforms.size() >= column_count);
+    check_chunk_size(column_count);
+    const auto format = options_.format();
+    if (format != Recorder_format::raw) {
+      encoding_ = format == Recorder_format::compressed_capture ?
+        capture::Encoding::delta_bitpack_codes : capture::Encoding::values;
+      const auto chunk_row_count = options_.chunk_row_count();
+      const auto chunk_size = capture::chunk_size(encoding_, column_count,
+        chunk_row_count);
+
+      /*
+       * Make the file header followed by the value transforms and the
+       * metadata, which is padded to be aligned for the direct I/O.
+       */
+      const auto block_size = Recorder_options::block_size;
+      capture::Header header;
+      header.column_count = static_cast<std::uint32_t>(column_count);
+      header.chunk_row_count = static_cast<std::uint32_t>(chunk_row_count);
+      header.sample_rate = static_cast<std::uint32_t>(sample_rate);
+      header.metadata_size = static_cast<std::uint32_t>(metadata.size());
+      header.encoding = encoding_;
+      const auto transforms_size = column_count * sizeof(capture::Value_transform);
+      header_size_ = (sizeof(header) + transforms_size + metadata.size() +
+        block_size - 1) / block_size * block_size;
+      header.size = static_cast<std::uint32_t>(header_size_);
+      header_ = make_buffer(header_size_);
+      std::memset(header_.get(), 0, header_size_);
+      std::memcpy(header_.get(), &header, sizeof(header));
+      for (std::size_t i{}; i < column_count; ++i) {
+        const capture::Value_transform transform{transforms[i].code_offset,
+          transforms[i].scale, transforms[i].offset};
+        std::memcpy(header_.get() + sizeof(header) + i*sizeof(transform),
+          &transform, sizeof(transform));
+      }
+      std::memcpy(header_.get() + sizeof(header) + transforms_size,
+        metadata.data(), metadata.size());
+      if (encoding_ == capture::Encoding::delta_bitpack_codes)
+        codes_.resize(column_count * chunk_row_count);
+
+      /*
+       * Reserve the index for the chunks which aren't split by the losses.
+       * (The compressed chunk takes at least one byte per block of codes.)
+       */
+      const auto min_chunk_size = encoding_ == capture::Encoding::values ?
+        chunk_size : sizeof(capture::Chunk_header) + column_count *
+        (sizeof(std::uint16_t) + chunk_row_count / delta_bitpack::block_size);
+      for (auto& entries : entries_) {
+        entries.clear();
+        entries.reserve(options_.buffer_size() / min_chunk_size + 1);
+      }
+    }
+    column_count_ = column_count;
+    is_chunk_open_ = false;
+    active_ = 0;
+    active_size_ = 0;
+    pending_size_ = 0;
+    is_stopping_ = false;
+    written_byte_count_.store(0, std::memory_order_relaxed);
+    file_count_.store(0, std::memory_order_relaxed);
+    stall_count_.store(0, std::memory_order_relaxed);
+    thread_ = std::thread{&File_recorder::writing, this};
+  }
+
+  /**
+   * @brief Copies the rows of the `data` into the buffer, which is passed to
+   * the writing thread once it's full.
+   *
+   * @param data The data of the column count specified upon start().
+   * @param info The information about the `data`.
+   *
+   * @remarks Must be called by one thread only between start() and stop().
+   */
+  void write(const Data_view& data, const Driver::Data_info& info)
+  {
+    PANDA_TIMESWIPE_ASSERT(data.column_count() == column_count_);
+    PANDA_TIMESWIPE_ASSERT(options_.format() != Recorder_format::compressed_capture);
+    if (options_.format() == Recorder_format::capture)
+      write_capture(data, info);
+    else
+      write_raw(data);
+  }
+
+  /**
+   * @brief Copies the rows of the raw `data` into the chunk.
+   *
+   * @par Requires
+   * `(options().format() == Recorder_format::compressed_capture)`.
+   *
+   * @see write(const Data_view&, const Driver::Data_info&).
+   */
+  void write(const Raw_data_view& data, const Driver::Data_info& info)
+  {
+    PANDA_TIMESWIPE_ASSERT(data.column_count() == column_count_);
+    PANDA_TIMESWIPE_ASSERT(options_.format() == Recorder_format::compressed_capture);
+    write_capture(data, info);
+  }
+
+  /**
+   * @brief Writes the remaining data, closes the file and stops the writing
+   * thread.
+   *
+   * @details Does nothing if the recording isn't started.
+   *
+   * @throws The exception of the first failure of the file I/O since start(),
+   * if any. (The data isn't written after the failure.)
+   */
+  void stop()
+  {
+    if (!thread_.joinable())
+      return;
+
+    if (is_chunk_open_)
+      close_chunk();
+    if (active_size_)
+      submit(active_size_);
+    {
+      const std::lock_guard lock{mutex_};
+      is_stopping_ = true;
+    }
+    changed_.notify_all();
+    thread_.join();
+
+    if (error_)
+      std::rethrow_exception(std::exchange(error_, nullptr));
+  }
+
+  /// @returns The number of bytes written to the files since start().
+  std::uint64_t written_byte_count() const noexcept
+  {
+    return written_byte_count_.load(std::memory_order_relaxed);
+  }
+
+  /// @returns The number of files created since start().
+  std::uint64_t file_count() const noexcept
+  {
+    return file_count_.load(std::memory_order_relaxed);
+  }
+
+  /**
+   * @returns The number of times write() waited for the writing thread
+   * because both the buffers were full.
+   */
+  std::uint64_t stall_count() const noexcept
+  {
+    return stall_count_.load(std::memory_order_relaxed);
+  }
+
+private:
+  struct Free final {
+    void operator()(void* const ptr) const noexcept
+    {
+      std::free(ptr);
+    }
+  };
+  using Buffer = std::unique_ptr<char, Free>;
+
+  Recorder_options options_;
+  std::array<Buffer, 2> buffers_;
+  std::size_t active_{}; // the index of the buffer being filled
+  std::size_t active_size_{}; // the bytes of the buffer being filled
+  std::size_t column_count_{}; // of the data being written
+  std::vector<const void*> columns_; // of the data being written
+  std::size_t pending_{}; // the index of the buffer being written
+  std::size_t pending_size_{}; // the bytes of the buffer being written
+  bool is_stopping_{};
+  std::mutex mutex_;
+  std::condition_variable changed_;
+  std::thread thread_;
+  std::exception_ptr error_; // of the writing thread
+
+  // The state of the capture format shared by the threads.
+  capture::Encoding encoding_{capture::Encoding::values};
+  Buffer header_; // of the file
+  std::size_t header_size_{};
+  std::array<std::vector<capture::Index_entry>, 2> entries_; // offsets in buffers
+
+  // The state of the capture format of the handler thread.
+  std::vector<std::uint16_t> codes_; // of the compressed chunk being filled
+  bool is_chunk_open_{};
+  std::size_t chunk_offset_{}; // in the buffer being filled
+  capture::Chunk_header chunk_;
+
+  // The state of the writing thread.
+  int fd_{-1};
+  std::string file_name_;
+  std::uint64_t file_offset_{}; // of the next write
+  std::uint64_t file_end_{}; // the offset of the end of the data
+  std::vector<capture::Index_entry> file_entries_; // of the capture file
+  std::uint64_t unsynced_size_{};
+  std::chrono::steady_clock::time_point file_open_time_;
+  bool is_direct_io_{};
+
+  std::uint64_t file_index_{}; // of the next file
+  std::atomic<std::uint64_t> written_byte_count_{};
+  std::atomic<std::uint64_t> file_count_{};
+  std::atomic<std::uint64_t> stall_count_{};
+
+  static Buffer make_buffer(const std::size_t size)
+  {
+    Buffer result{static_cast<char*>(std::aligned_alloc(
+          Recorder_options::block_size, size))};
+    if (!result)
+      throw Exception{Errc::out_of_memory,
+        "cannot allocate buffer for recorder"};
+    return result;
+  }
+
+  /// @returns The nanoseconds since the epoch of the `time`.
+  static std::int64_t to_ns(const Driver::Data_info::System_time time) noexcept
+  {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+      time.time_since_epoch()).count();
+  }
+
+  /// Writes the rows of the `data` one after another.
+  void write_raw(const Data_view& data)
+  {
+    const auto capacity = options_.buffer_size() / sizeof(float);
+    const auto column_count = data.column_count();
+    const auto row_count = data.row_count();
+    columns_.resize(column_count);
+    for (std::size_t c{}; c < column_count; ++c)
+      columns_[c] = data.column(c).data();
+    auto* out = reinterpret_cast<float*>(buffers_[active_].get());
+    auto size = active_size_ / sizeof(float);
+    for (std::size_t r{}; r < row_count; ++r) {
+      for (std::size_t c{}; c < column_count; ++c) {
+        out[size++] = static_cast<const float*>(columns_[c])[r];
+        if (size == capacity) {
+          submit(options_.buffer_size());
+          out = reinterpret_cast<float*>(buffers_[active_].get());
+          size = 0;
+        }
+      }
+    }
+    active_size_ = size * sizeof(float);
+  }
+
+  /// Writes the rows of the `data` into the chunks column by column.
+  template<typename T>
+  void write_capture(const Table_view<T>& data, const Driver::Data_info& info)
+  {
+    const auto capacity = options_.chunk_row_count();
+    const auto column_count = data.column_count();
+    const auto row_count = data.row_count();
+    columns_.resize(column_count);
+    for (std::size_t c{}; c < column_count; ++c)
+      columns_[c] = data.column(c).data();
+    for (std::size_t r{}; r < row_count;) {
+      const auto sample_index = info.sample_index + r;
+      if (is_chunk_open_ && (chunk_.row_count == capacity ||
+          chunk_.sample_index + chunk_.row_count != sample_index))
+        close_chunk();
+      if (!is_chunk_open_)
+        open_chunk(sample_index, to_ns(info.read_system_time(r)));
+
+      // Copy as many rows as fit into the chunk.
+      const auto offset = chunk_.row_count;
+      const auto count = std::min<std::size_t>(capacity - offset, row_count - r);
+      T* out{};
+      if constexpr (std::is_same_v<T, std::uint16_t>)
+        out = codes_.data() + offset;
+      else
+        out = reinterpret_cast<T*>(buffers_[active_].get() + chunk_offset_ +
+          sizeof(capture::Chunk_header)) + offset;
+      for (std::size_t c{}; c < column_count; ++c) {
+        const auto* const column = static_cast<const T*>(columns_[c]);
+        std::copy(column + r, column + r + count, out + c*capacity);
+      }
+      r += count;
+      chunk_.row_count += static_cast<std::uint32_t>(count);
+      chunk_.last_read_time = to_ns(info.read_system_time(r - 1));
+    }
+  }
+
+  /// Reserves the space for the chunk of the maximum size in the buffer.
+  void open_chunk(const std::uint64_t sample_index, const std::int64_t read_time)
+  {
+    PANDA_TIMESWIPE_ASSERT(!is_chunk_open_);
+    const auto size = capture::chunk_size(encoding_, column_count_,
+      options_.chunk_row_count());
+    if (active_size_ + size > options_.buffer_size())
+      submit(active_size_);
+    chunk_ = {};
+    chunk_.sample_index = sample_index;
+    chunk_.first_read_time = chunk_.last_read_time = read_time;
+    chunk_offset_ = active_size_;
+    active_size_ += size;
+    is_chunk_open_ = true;
+  }
+
+  /**
+   * @brief Writes the header of the chunk, and either compacts the columns of
+   * the chunk if it isn't full or encodes the codes of the chunk.
+   */
+  void close_chunk()
+  {
+    PANDA_TIMESWIPE_ASSERT(is_chunk_open_);
+    const auto capacity = options_.chunk_row_count();
+    const auto row_count = chunk_.row_count;
+    auto* const chunk = buffers_[active_].get() + chunk_offset_;
+    auto* const columns = chunk + sizeof(chunk_);
+    std::size_t size{};
+    if (encoding_ == capture::Encoding::values) {
+      auto* const values = reinterpret_cast<float*>(columns);
+      if (row_count < capacity) {
+        for (std::size_t c{1}; c < column_count_; ++c)
+          std::memmove(values + c*row_count, values + c*capacity,
+            row_count * sizeof(float));
+      }
+      size = column_count_ * row_count * sizeof(float);
+    } else {
+      for (std::size_t c{}; c < column_count_; ++c)
+        size += delta_bitpack::encode(codes_.data() + c*capacity, row_count,
+          reinterpret_cast<unsigned char*>(columns) + size);
+    }
+    chunk_.size = static_cast<std::uint32_t>(size);
+    std::memcpy(chunk, &chunk_, sizeof(chunk_));
+    entries_[active_].push_back({chunk_offset_, chunk_});
+    if (encoding_ == capture::Encoding::delta_bitpack_codes) {
+      constexpr auto alignment = capture::compressed_chunk_alignment;
+      const auto padded_size = (size + alignment - 1) / alignment * alignment;
+      std::memset(columns + size, 0, padded_size - size);
+      size = padded_size;
+    }
+    active_size_ = chunk_offset_ + sizeof(chunk_) + size;
+    is_chunk_open_ = false;
+  }
+
+  /// Passes the buffer being filled to the writing thread.
+  void submit(const std::size_t size)
+  {
+    std::unique_lock lock{mutex_};
+    if (pending_size_) {
+      stall_count_.store(stall_count_.load(std::memory_order_relaxed) + 1,
+        std::memory_order_relaxed);
+      changed_.wait(lock, [this]{ return !pending_size_; });
+    }
+    pending_ = active_;
+    pending_size_ = size;
+    active_ ^= 1;
+    active_size_ = 0;
+    lock.unlock();
+    changed_.notify_all();
+  }
+
+  void writing()
+  {
+    while (true) {
+      std::size_t index{}, size{};
+      {
+        std::unique_lock lock{mutex_};
+        changed_.wait(lock, [this]{ return pending_size_ || is_stopping_; });
+        if (!pending_size_)
+          break;
+        index = pending_;
+        size = pending_size_;
+      }
+
+      if (!error_) {
+        try {
+          write_buffer(index, size);
+        } catch (...) {
+          error_ = std::current_exception();
+        }
+      }
+      entries_[index].clear();
+
+      {
+        const std::lock_guard lock{mutex_};
+        pending_size_ = 0;
+      }
+      changed_.notify_all();
+    }
+
+    try {
+      close_file();
+    } catch (...) {
+      if (!error_)
+        error_ = std::current_exception();
+    }
+  }
+
+  void write_buffer(const std::size_t index, const std::size_t size)
+  {
+    // Rotate the file if needed.
+    if (fd_ >= 0) {
+      const auto duration = options_.file_duration();
+      if (file_end_ >= options_.file_size() || (duration &&
+          std::chrono::steady_clock::now() - file_open_time_ >= *duration))
+        close_file();
+    }
+    if (fd_ < 0)
+      open_file();
+
+    /*
+     * The size of the direct I/O must be aligned, so the buffer is padded with
+     * zeros. The padding of the last buffer is truncated upon closing the
+     * file, while the padding of the other buffers of the capture file is
+     * skipped by the chunk index.
+     */
+    auto* const data = buffers_[index].get();
+    const auto write_size = padded_size(data, size);
+    write_all(data, write_size);
+    if (options_.format() != Recorder_format::raw) {
+      for (auto entry : entries_[index]) {
+        entry.offset += file_offset_;
+        file_entries_.push_back(entry);
+      }
+    }
+    file_end_ = file_offset_ + size;
+    file_offset_ += write_size;
+    written_byte_count_.store(written_byte_count_.load(std::memory_order_relaxed)
+      + size, std::memory_order_relaxed);
+
+    // Flush the data to the storage device in batches.
+    unsynced_size_ += write_size;
+    if (unsynced_size_ >= options_.sync_size())
+      sync_file();
+  }
+
+  /**
+   * @returns The `size` aligned for the direct I/O if it's used.
+   *
+   * @par Effects
+   * The `data` is padded with zeros up to the size returned.
+   */
+  std::size_t padded_size(char* const data, const std::size_t size) const noexcept
+  {
+    if (!is_direct_io_)
+      return size;
+
+    const auto block_size = Recorder_options::block_size;
+    const auto result = (size + block_size - 1) / block_size * block_size;
+    std::memset(data + size, 0, result - size);
+    return result;
+  }
+
+  void write_all(const char* const data, const std::size_t size)
+  {
+    for (std::size_t offset{}; offset < size;) {
+      const auto count = ::write(fd_, data + offset, size - offset);
+      if (count < 0) {
+        const auto code = errno;
+        if (code == EINTR)
+          continue;
+        throw Sys_exception{code,
+          std::string{"cannot write to file "}.append(file_name_)};
+      }
+      offset += static_cast<std::size_t>(count);
+    }
+  }
+
+  void open_file()
+  {
+    PANDA_TIMESWIPE_ASSERT(fd_ < 0);
+    const bool is_capture{options_.format() != Recorder_format::raw};
+    const auto index = std::to_string(file_index_);
+    file_name_ = options_.path_prefix();
+    file_name_.append(index.size() < 6 ? 6 - index.size() : 0, '0')
+      .append(index).append(is_capture ? ".tswcap" : ".bin");
+
+    // Fall back to the buffered I/O if the direct I/O isn't supported.
+    constexpr int flags{O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC};
+    is_direct_io_ = options_.is_direct_io_enabled();
+    if (is_direct_io_) {
+      fd_ = ::open(file_name_.c_str(), flags | O_DIRECT, 0644);
+      is_direct_io_ = fd_ >= 0;
+    }
+    if (fd_ < 0)
+      fd_ = ::open(file_name_.c_str(), flags, 0644);
+    if (fd_ < 0) {
+      const auto code = errno;
+      throw Sys_exception{code,
+        std::string{"cannot open file "}.append(file_name_)};
+    }
+    ++file_index_;
+    file_count_.store(file_count_.load(std::memory_order_relaxed) + 1,
+      std::memory_order_relaxed);
+    file_offset_ = file_end_ = 0;
+    file_entries_.clear();
+    unsynced_size_ = 0;
+    file_open_time_ = std::chrono::steady_clock::now();
+
+    // Preallocate the file (if the file system supports it).
+    if (options_.is_preallocation_enabled()) {
+      if (::fallocate(fd_, 0, 0, static_cast<off_t>(options_.file_size()))) {
+        const auto code = errno;
+        if (code != EOPNOTSUPP)
+          throw Sys_exception{code,
+            std::string{"cannot preallocate file "}.append(file_name_)};
+      }
+    }
+
+    // Write the header of the capture file (which is aligned already).
+    if (is_capture) {
+      write_all(header_.get(), header_size_);
+      file_offset_ = file_end_ = header_size_;
+    }
+  }
+
+  void sync_file()
+  {
+    if (::fdatasync(fd_)) {
+      const auto code = errno;
+      throw Sys_exception{code,
+        std::string{"cannot sync file "}.append(file_name_)};
+    }
+    unsynced_size_ = 0;
+  }
+
+  void close_file()
+  {
+    if (fd_ < 0)
+      return;
+
+    const auto fail = [this](const char* const what)
+    {
+      const auto code = errno;
+      ::close(std::exchange(fd_, -1));
+      throw Sys_exception{code, std::string{what}.append(file_name_)};
+    };
+    // Write the chunk index followed by the trailer to the capture file.
+    if (options_.format() != Recorder_format::raw) {
+      capture::Trailer trailer;
+      trailer.index_offset = file_offset_;
+      trailer.chunk_count = file_entries_.size();
+      const auto index_size = file_entries_.size() * sizeof(capture::Index_entry);
+      const auto size = index_size + sizeof(trailer);
+      const auto block_size = Recorder_options::block_size;
+      const auto buffer = make_buffer((size + block_size - 1) / block_size * block_size);
+      std::memcpy(buffer.get(), file_entries_.data(), index_size);
+      std::memcpy(buffer.get() + index_size, &trailer, sizeof(trailer));
+      try {
+        write_all(buffer.get(), padded_size(buffer.get(), size));
+      } catch (...) {
+        ::close(std::exchange(fd_, -1));
+        throw;
+      }
+      file_end_ = file_offset_ + size;
+      file_entries_.clear();
+    }
+
+    // Remove both the preallocated space and the padding.
+    if (::ftruncate(fd_, static_cast<off_t>(file_end_)))
+      fail("cannot truncate file ");
+    if (::fdatasync(fd_))
+      fail("cannot sync file ");
+    if (::close(std::exchange(fd_, -1))) {
+      const auto code = errno;
+      throw Sys_exception{code,
+        std::string{"cannot close file "}.append(file_name_)};
+    }
+  }
+};
+
+} // namespace panda::timeswipe::detail
+
+#endif  // PANDA_TIMESWIPE_FILE_RECORDER_HPP
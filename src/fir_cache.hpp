@@ -0,0 +1,270 @@
+// -*- C++ -*-
+
+// PANDA Timeswipe Project
+// Copyright (C) 2021  PANDA GmbH / Dmitry Igrishin
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef PANDA_TIMESWIPE_FIR_CACHE_HPP
+#define PANDA_TIMESWIPE_FIR_CACHE_HPP
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <unistd.h>
+
+namespace panda::timeswipe::detail {
+
+/**
+ * @brief A thread-safe cache of the designed FIR coefficients.
+ *
+ * @details The coefficients are cached in memory and, if the directory is set,
+ * on disk, so they're designed only once per key even across the restarts of
+ * the process. The key is the byte string which identifies the design (see
+ * Resampler), and the file of the entry is named by the hash of the key. The
+ * file stores the key as well, so the collision of hashes is a miss rather than
+ * the wrong coefficients. The disk cache is best-effort: the files which can't
+ * be read or written are just ignored.
+ */
+class Fir_cache final {
+public:
+  /// An alias of the coefficients of each stage of the filter.
+  using Coefficients = std::vector<std::vector<double>>;
+
+  /// @returns The instance of the cache.
+  static Fir_cache& instance()
+  {
+    static Fir_cache result;
+    return result;
+  }
+
+  /// Non copy-constructible.
+  Fir_cache(const Fir_cache&) = delete;
+
+  /// Non copy-assignable.
+  Fir_cache& operator=(const Fir_cache&) = delete;
+
+  /// Non move-constructible.
+  Fir_cache(Fir_cache&&) = delete;
+
+  /// Non move-assignable.
+  Fir_cache& operator=(Fir_cache&&) = delete;
+
+  /**
+   * @brief Sets the directory of the disk cache. (It's created on demand.)
+   *
+   * @details The disk cache is disabled if the `value` is empty, which is
+   * the default.
+   */
+  void set_directory(std::filesystem::path value)
+  {
+    const std::lock_guard lock{mutex_};
+    directory_ = std::move(value);
+  }
+
+  /// @returns The directory of the disk cache.
+  std::filesystem::path directory() const
+  {
+    const std::lock_guard lock{mutex_};
+    return directory_;
+  }
+
+  /**
+   * @returns The coefficients cached by the `key`, or the ones returned by
+   * `design()` which are cached then.
+   *
+   * @remarks The `design()` is called without the lock, so it may be called
+   * concurrently for the same key by several threads.
+   */
+  template<class F>
+  std::shared_ptr<const Coefficients> get(const std::string& key, F&& design)
+  {
+    std::filesystem::path path;
+    {
+      const std::lock_guard lock{mutex_};
+      if (const auto i = entries_.find(key); i != entries_.cend()) {
+        ++memory_hit_count_;
+        return i->second;
+      } else if (!directory_.empty())
+        path = directory_ / file_name(key);
+    }
+
+    std::shared_ptr<const Coefficients> result;
+    if (!path.empty())
+      result = read(path, key);
+    const bool is_disk_hit{result};
+    if (!is_disk_hit) {
+      result = std::make_shared<const Coefficients>(design());
+      if (!path.empty())
+        write(path, key, *result);
+    }
+
+    const std::lock_guard lock{mutex_};
+    ++(is_disk_hit ? disk_hit_count_ : miss_count_);
+    return entries_.emplace(key, std::move(result)).first->second;
+  }
+
+  /// Clears the memory cache. (The disk cache is kept.)
+  void clear() noexcept
+  {
+    const std::lock_guard lock{mutex_};
+    entries_.clear();
+  }
+
+  /// @returns The number of hits of the memory cache.
+  std::uint64_t memory_hit_count() const noexcept
+  {
+    const std::lock_guard lock{mutex_};
+    return memory_hit_count_;
+  }
+
+  /// @returns The number of hits of the disk cache.
+  std::uint64_t disk_hit_count() const noexcept
+  {
+    const std::lock_guard lock{mutex_};
+    return disk_hit_count_;
+  }
+
+  /// @returns The number of misses (i.e. the calls of the design function).
+  std::uint64_t miss_count() const noexcept
+  {
+    const std::lock_guard lock{mutex_};
+    return miss_count_;
+  }
+
+private:
+  /// The magic of the file of the entry.
+  static constexpr std::array<char, 8> magic_{'T','S','W','F','I','R','C','1'};
+
+  mutable std::mutex mutex_;
+  std::filesystem::path directory_;
+  std::map<std::string, std::shared_ptr<const Coefficients>> entries_;
+  std::uint64_t memory_hit_count_{};
+  std::uint64_t disk_hit_count_{};
+  std::uint64_t miss_count_{};
+
+  Fir_cache() = default;
+
+  /// @returns The name of the file of the entry of the `key`.
+  static std::string file_name(const std::string& key)
+  {
+    // FNV-1a.
+    std::uint64_t hash{0xcbf29ce484222325};
+    for (const unsigned char c : key) {
+      hash ^= c;
+      hash *= 0x100000001b3;
+    }
+    constexpr char digits[]{"0123456789abcdef"};
+    std::string result(16, '0');
+    for (auto i = result.size(); i--; hash >>= 4)
+      result[i] = digits[hash & 0xf];
+    return result.append(".firc");
+  }
+
+  /// @returns The coefficients read from the file, or `nullptr` on failure.
+  static std::shared_ptr<const Coefficients> read(const std::filesystem::path& path,
+    const std::string& key)
+  {
+    std::ifstream in{path, std::ios_base::binary};
+    if (!in)
+      return nullptr;
+
+    const auto read_size = [&in]
+    {
+      std::uint64_t result{};
+      in.read(reinterpret_cast<char*>(&result), sizeof(result));
+      return in ? result : 0;
+    };
+    std::array<char, magic_.size()> magic{};
+    in.read(magic.data(), magic.size());
+    if (!in || magic != magic_ || read_size() != key.size())
+      return nullptr;
+
+    std::string file_key(key.size(), '\0');
+    in.read(file_key.data(), file_key.size());
+    if (!in || file_key != key)
+      return nullptr;
+
+    const auto stage_count = read_size();
+    if (!stage_count || stage_count > 64)
+      return nullptr;
+    Coefficients result(stage_count);
+    for (auto& stage : result) {
+      const auto size = read_size();
+      if (!size || size > (1 << 24))
+        return nullptr;
+      stage.resize(size);
+      in.read(reinterpret_cast<char*>(stage.data()), size * sizeof(double));
+    }
+    if (!in || in.peek() != std::ifstream::traits_type::eof())
+      return nullptr;
+
+    return std::make_shared<const Coefficients>(std::move(result));
+  }
+
+  /// Writes the coefficients to the file atomically.
+  static void write(const std::filesystem::path& path, const std::string& key,
+    const Coefficients& coefs) noexcept
+  {
+    try {
+      std::error_code error;
+      std::filesystem::create_directories(path.parent_path(), error);
+      if (error)
+        return;
+
+      const auto write_size = [](std::ofstream& out, const std::uint64_t size)
+      {
+        out.write(reinterpret_cast<const char*>(&size), sizeof(size));
+      };
+      auto tmp_path = path;
+      tmp_path += ".tmp" + std::to_string(::getpid()) + "-" +
+        std::to_string(std::hash<std::thread::id>{}(std::this_thread::get_id()));
+      {
+        std::ofstream out{tmp_path, std::ios_base::binary | std::ios_base::trunc};
+        out.write(magic_.data(), magic_.size());
+        write_size(out, key.size());
+        out.write(key.data(), key.size());
+        write_size(out, coefs.size());
+        for (const auto& stage : coefs) {
+          write_size(out, stage.size());
+          out.write(reinterpret_cast<const char*>(stage.data()),
+            stage.size() * sizeof(double));
+        }
+        if (!out.flush()) {
+          std::filesystem::remove(tmp_path, error);
+          return;
+        }
+      }
+      std::filesystem::rename(tmp_path, path, error);
+      if (error)
+        std::filesystem::remove(tmp_path, error);
+    } catch (...) {}
+  }
+};
+
+} // namespace panda::timeswipe::detail
+
+#endif  // PANDA_TIMESWIPE_FIR_CACHE_HPP
@@ -14,14 +14,133 @@
 #include "exceptions.hpp"
 
 #include <algorithm>
+#include <array>
 #include <cmath>
 #include <cstddef>
 #include <iterator>
 #include <type_traits>
 #include <vector>
 
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#elif defined(__AVX__) || defined(__SSE__)
+#include <immintrin.h>
+#endif
+
 namespace panda::timeswipe::detail {
 
+/**
+ * @returns The dot product of `count` coefficients `h` and values `x`.
+ *
+ * @details The product of floats is calculated by the SIMD instructions
+ * selected at compile time (NEON, AVX or SSE) if available, with several
+ * accumulators per vector lane. (So the result can differ from the one of the
+ * sequential summation by the rounding.) Otherwise, the products are summed
+ * sequentially.
+ */
+template<typename Out, typename Coef, typename In>
+inline Out dot_product(const Coef* const h, const In* const x,
+  const std::size_t count) noexcept
+{
+  std::size_t i{};
+  Out result{};
+  if constexpr (std::is_same_v<Out, float> && std::is_same_v<Coef, float> &&
+    std::is_same_v<In, float>) {
+#if defined(__ARM_NEON)
+    float32x4_t acc0{vdupq_n_f32(0)}, acc1{vdupq_n_f32(0)};
+    for (; i + 8 <= count; i += 8) {
+      acc0 = vmlaq_f32(acc0, vld1q_f32(x + i), vld1q_f32(h + i));
+      acc1 = vmlaq_f32(acc1, vld1q_f32(x + i + 4), vld1q_f32(h + i + 4));
+    }
+    const auto acc = vaddq_f32(acc0, acc1);
+    const auto pair = vadd_f32(vget_low_f32(acc), vget_high_f32(acc));
+    result = vget_lane_f32(vpadd_f32(pair, pair), 0);
+#elif defined(__AVX__)
+    __m256 acc0{_mm256_setzero_ps()}, acc1{_mm256_setzero_ps()};
+    for (; i + 16 <= count; i += 16) {
+      acc0 = _mm256_add_ps(acc0, _mm256_mul_ps(_mm256_loadu_ps(x + i),
+          _mm256_loadu_ps(h + i)));
+      acc1 = _mm256_add_ps(acc1, _mm256_mul_ps(_mm256_loadu_ps(x + i + 8),
+          _mm256_loadu_ps(h + i + 8)));
+    }
+    const auto acc = _mm256_add_ps(acc0, acc1);
+    auto sum = _mm_add_ps(_mm256_castps256_ps128(acc), _mm256_extractf128_ps(acc, 1));
+    sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+    result = _mm_cvtss_f32(_mm_add_ss(sum, _mm_shuffle_ps(sum, sum, 1)));
+#elif defined(__SSE__)
+    __m128 acc0{_mm_setzero_ps()}, acc1{_mm_setzero_ps()};
+    for (; i + 8 <= count; i += 8) {
+      acc0 = _mm_add_ps(acc0, _mm_mul_ps(_mm_loadu_ps(x + i), _mm_loadu_ps(h + i)));
+      acc1 = _mm_add_ps(acc1, _mm_mul_ps(_mm_loadu_ps(x + i + 4),
+          _mm_loadu_ps(h + i + 4)));
+    }
+    auto sum = _mm_add_ps(acc0, acc1);
+    sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+    result = _mm_cvtss_f32(_mm_add_ss(sum, _mm_shuffle_ps(sum, sum, 1)));
+#endif
+  }
+  for (; i < count; ++i)
+    result += x[i] * h[i];
+  return result;
+}
+
+/**
+ * @brief The number of values of type `T` per 128-bit vector register (SSE,
+ * NEON), i.e. the number of channels processed by Interleaved_fir_resampler
+ * in one pass.
+ */
+template<typename T>
+constexpr std::size_t interleaved_lane_count{16 / sizeof(T)};
+
+/**
+ * @brief Calculates the dot products of `count` coefficients `h` and each of
+ * the `Lanes` interleaved sequences of values `x` (i.e. `x[i*Lanes + l]` is
+ * the `i`-th value of the lane `l`), and writes them to `result`.
+ *
+ * @details The products of 4 lanes of floats are calculated by the SIMD
+ * instructions selected at compile time (NEON or SSE) if available, so each
+ * coefficient is loaded once for all the lanes. Otherwise, the products are
+ * summed sequentially.
+ */
+template<std::size_t Lanes, typename Out, typename Coef, typename In>
+inline void dot_product_lanes(const Coef* const h, const In* const x,
+  const std::size_t count, Out* const result) noexcept
+{
+  if constexpr (Lanes == 4 && std::is_same_v<Out, float> &&
+    std::is_same_v<Coef, float> && std::is_same_v<In, float>) {
+#if defined(__ARM_NEON)
+    float32x4_t acc0{vdupq_n_f32(0)}, acc1{vdupq_n_f32(0)};
+    std::size_t i{};
+    for (; i + 2 <= count; i += 2) {
+      acc0 = vmlaq_n_f32(acc0, vld1q_f32(x + i*4), h[i]);
+      acc1 = vmlaq_n_f32(acc1, vld1q_f32(x + i*4 + 4), h[i + 1]);
+    }
+    if (i < count)
+      acc0 = vmlaq_n_f32(acc0, vld1q_f32(x + i*4), h[i]);
+    vst1q_f32(result, vaddq_f32(acc0, acc1));
+    return;
+#elif defined(__SSE__)
+    __m128 acc0{_mm_setzero_ps()}, acc1{_mm_setzero_ps()};
+    std::size_t i{};
+    for (; i + 2 <= count; i += 2) {
+      acc0 = _mm_add_ps(acc0, _mm_mul_ps(_mm_loadu_ps(x + i*4), _mm_set1_ps(h[i])));
+      acc1 = _mm_add_ps(acc1, _mm_mul_ps(_mm_loadu_ps(x + i*4 + 4),
+          _mm_set1_ps(h[i + 1])));
+    }
+    if (i < count)
+      acc0 = _mm_add_ps(acc0, _mm_mul_ps(_mm_loadu_ps(x + i*4), _mm_set1_ps(h[i])));
+    _mm_storeu_ps(result, _mm_add_ps(acc0, acc1));
+    return;
+#endif
+  }
+  std::array<Out, Lanes> acc{};
+  for (std::size_t i{}; i < count; ++i) {
+    for (std::size_t l{}; l < Lanes; ++l)
+      acc[l] += x[i*Lanes + l] * h[i];
+  }
+  std::copy(cbegin(acc), cend(acc), result);
+}
+
 /**
  * @brief Signal extrapolation method.
  *
@@ -100,6 +219,157 @@ enum class Signal_extrapolation {
   antireflect
 };
 
+/// Reflects the `state` to the left (see Signal_extrapolation::reflect).
+template<typename T>
+void reflect_left(std::vector<T>& state) noexcept
+{
+  if (state.size() >= 3) {
+    std::copy(begin(state) + 1, end(state), begin(state)); // x2,...,xn,xn
+    std::reverse(begin(state), end(state)); // xn,xn,...,x2
+    state[0] = state[2]; // xn-1,xn,...,x2
+  }
+}
+
+/// Reflects the `state` to the right (see Signal_extrapolation::reflect).
+template<typename T>
+void reflect_right(std::vector<T>& state) noexcept
+{
+  if (state.size() >= 3) {
+    std::reverse(begin(state), end(state)); // xn,...,x2,x1
+    std::copy(begin(state) + 1, end(state), begin(state)); // xn-1,...,x2,x1,x1
+    state.back() = state[state.size() - 3]; // xn-1,...,x2,x1,x2
+  }
+}
+
+/**
+ * @brief Extrapolates the signal which starts with `in_size` samples from
+ * `first` to the left by the given `method`.
+ *
+ * @details The `state` is filled with the extension of the signal, except the
+ * zero extension, in which case the `state` is left as is (i.e. zeros).
+ *
+ * @par Requires
+ * `in_size > 0`.
+ */
+template<typename T, typename InputIt>
+void extrapolate_leading(const Signal_extrapolation method, std::vector<T>& state,
+  const InputIt first, const std::size_t in_size)
+{
+  using It_value = typename std::iterator_traits<InputIt>::value_type;
+  PANDA_TIMESWIPE_ASSERT(in_size);
+
+  // Handle simple extrapolation methods.
+  switch (method) {
+  case Signal_extrapolation::zero:
+    return; // already done upon construction
+  case Signal_extrapolation::smooth: {
+    const auto sz = state.size();
+    const auto [x1, x2] = in_size > 1 ?
+      std::make_pair(first[0], first[1]):
+      std::make_pair(first[0], It_value{});
+    for (auto k = sz; k > 0; --k)
+      state[sz - k] = x1 - k*(x2 - x1);
+    return;
+  }
+  case Signal_extrapolation::constant:
+    std::fill(begin(state), end(state), *first);
+    return;
+  default:;
+  }
+
+  // Copy the input to the state buffer for more complicated extrapolation.
+  {
+    const auto count = std::min(state.size(), in_size);
+    std::copy(first, first + count, end(state) - count);
+  }
+
+  // Handle more complicated extrapolation methods by modifying the state buffer.
+  switch (method) {
+  case Signal_extrapolation::zero:;
+    [[fallthrough]];
+  case Signal_extrapolation::smooth:
+    [[fallthrough]];
+  case Signal_extrapolation::constant:;
+    PANDA_TIMESWIPE_ASSERT(false);
+    std::terminate();
+  case Signal_extrapolation::symmetric:
+    std::reverse(begin(state), end(state));
+    break;
+  case Signal_extrapolation::reflect:
+    reflect_left(state);
+    break;
+  case Signal_extrapolation::periodic:
+    break;
+  case Signal_extrapolation::antisymmetric:
+    std::reverse(begin(state), end(state));
+    std::for_each(begin(state), end(state), [](auto& x){ x = -x; });
+    break;
+  case Signal_extrapolation::antireflect:
+    auto reflected = state;
+    reflect_left(reflected);
+    if (const auto sz = state.size(); sz >= 2) {
+      const auto x1 = state[0];
+      for (std::decay_t<decltype(sz)> i{}; i < sz; ++i)
+        state[i] = 2*x1 - reflected[i];
+    }
+    break;
+  }
+}
+
+/**
+ * @brief Extrapolates the signal which ends with the `extra` to the right by
+ * the given `method`.
+ *
+ * @details The `extra` is replaced with the extension of the signal.
+ */
+template<typename T>
+void extrapolate_trailing(const Signal_extrapolation method, std::vector<T>& extra)
+{
+  if (extra.empty())
+    return;
+
+  const auto b = begin(extra);
+  const auto e = end(extra);
+  switch (method) {
+  case Signal_extrapolation::zero:
+    std::fill(b, e, T{});
+    break;
+  case Signal_extrapolation::smooth: {
+    const auto sz = extra.size();
+    const auto [xn, xn_1] = extra.size() > 1 ?
+      std::make_pair(extra[sz - 1], extra[sz - 2]) :
+      std::make_pair(T{}, extra[sz - 1]);
+    for (std::decay_t<decltype(sz)> k{1}; k <= sz; ++k)
+      extra[k - 1] = xn + k*(xn - xn_1);
+    break;
+  }
+  case Signal_extrapolation::constant:
+    std::fill(b, e, extra.back());
+    break;
+  case Signal_extrapolation::symmetric:
+    std::reverse(b, e);
+    break;
+  case Signal_extrapolation::reflect:
+    reflect_right(extra);
+    break;
+  case Signal_extrapolation::periodic:
+    break;
+  case Signal_extrapolation::antisymmetric:
+    std::reverse(b, e);
+    std::for_each(b, e, [](auto& x){ x = -x; });
+    break;
+  case Signal_extrapolation::antireflect:
+    auto reflected = extra;
+    reflect_right(reflected);
+    if (const auto sz = extra.size(); sz >= 2) {
+      const auto xn = extra.back();
+      for (std::decay_t<decltype(sz)> i{}; i < sz; ++i)
+        extra[i] = 2*xn - reflected[i];
+    }
+    break;
+  }
+}
+
 /**
  * @brief A functor for resampling.
  *
@@ -174,6 +444,7 @@ public:
     // Coefficients per phase and initial state buffer.
     coefs_per_phase_ = transposed_coefs_.size() / up_rate_;
     state_.resize(coefs_per_phase_ - 1);
+    history_.resize(state_.size() + history_block_size);
 
     // Transposing and "flipping" each phase.
     for (int i{}; i < up_rate_; ++i) {
@@ -220,6 +491,7 @@ public:
     swap(coefs_per_phase_, rhs.coefs_per_phase_);
     swap(transposed_coefs_, rhs.transposed_coefs_);
     swap(state_, rhs.state_);
+    swap(history_, rhs.history_);
   }
 
   /**
@@ -258,115 +530,41 @@ public:
 
     PANDA_TIMESWIPE_ASSERT(in_size);
 
-    if (!is_applied_) {
-      // Handle simple extrapolation methods.
-      switch (signal_extrapolation_) {
-      case Signal_extrapolation::zero:
-        goto resample; // already done upon construction
-      case Signal_extrapolation::smooth: {
-        const auto sz = state_.size();
-        const auto [x1, x2] = in_size > 1 ?
-          std::make_pair(first[0], first[1]):
-          std::make_pair(first[0], It_value{});
-        for (auto k = sz; k > 0; --k)
-          state_[sz - k] = x1 - k*(x2 - x1);
-        goto resample;
-      }
-      case Signal_extrapolation::constant:
-        fill(begin(state_), end(state_), *first);
-        goto resample;
-      default:;
+    if (!is_applied_)
+      extrapolate_leading(signal_extrapolation_, state_, first, in_size);
+
+    /*
+     * Make the history contiguous (the state followed by the block of the
+     * input), so each output sample is the single dot product of the phase of
+     * the filter and the window of the history which ends at the current
+     * input sample. The input is processed by blocks of the fixed size, so
+     * the history is never reallocated.
+     */
+    const auto state_size = state_.size();
+    PANDA_TIMESWIPE_ASSERT(history_.size() == state_size + history_block_size);
+    auto* const history = history_.data();
+    std::copy(cbegin(state_), cend(state_), history);
+    const auto* const coefs = transposed_coefs_.data();
+    const auto window_size = static_cast<std::size_t>(coefs_per_phase_);
+    auto in = static_cast<std::size_t>(apply_offset_); // input index
+    for (std::size_t offset{}; offset < in_size; offset += history_block_size) {
+      const auto block_size = std::min(history_block_size, in_size - offset);
+      std::copy(first + offset, first + offset + block_size, history + state_size);
+      for (const auto block_end = offset + block_size; in < block_end;) {
+        *out = dot_product<Output>(coefs + coefs_phase_*coefs_per_phase_,
+          history + (in - offset), window_size);
+        ++out;
+
+        coefs_phase_ += down_rate_;
+        in += coefs_phase_ / up_rate_;
+        coefs_phase_ %= up_rate_;
       }
 
-      // Copy the input to the state buffer for more complicated extrapolation.
-      {
-        const auto count = std::min(state_.size(), in_size);
-        const auto e = end(state_);
-        const auto b = e - count;
-        PANDA_TIMESWIPE_ASSERT(first + count <= last);
-        copy(first, first + count, b);
-      }
-
-      // Handle more complicated extrapolation methods by modifying the state buffer.
-      switch (signal_extrapolation_) {
-      case Signal_extrapolation::zero:;
-        [[fallthrough]];
-      case Signal_extrapolation::smooth:
-        [[fallthrough]];
-      case Signal_extrapolation::constant:;
-        PANDA_TIMESWIPE_ASSERT(false);
-        std::terminate();
-      case Signal_extrapolation::symmetric:
-        reverse(begin(state_), end(state_));
-        break;
-      case Signal_extrapolation::reflect:
-        reflect_left(state_);
-        break;
-      case Signal_extrapolation::periodic:
-        break;
-      case Signal_extrapolation::antisymmetric:
-        reverse(begin(state_), end(state_));
-        for_each(begin(state_), end(state_), [](auto& x){ x = -x; });
-        break;
-      case Signal_extrapolation::antireflect:
-        auto reflected = state_;
-        reflect_left(reflected);
-        if (const auto sz = state_.size(); sz >= 2) {
-          const auto x1 = state_[0];
-          for (std::decay_t<decltype(sz)> i{}; i < sz; ++i)
-            state_[i] = 2*x1 - reflected[i];
-        }
-        break;
-      }
-    }
-
-  resample:
-    auto in = first + apply_offset_;
-    while (in < last) {
-      Output value{};
-      auto h = cbegin(transposed_coefs_) + coefs_phase_*coefs_per_phase_;
-      auto in_ptr = in - state_.size();
-      if (const auto diff = first - in_ptr; diff > 0) {
-        // Use values from the state_ buffer.
-        PANDA_TIMESWIPE_ASSERT(static_cast<typename
-          decltype(state_)::size_type>(diff) <= state_.size());
-        const auto e = cend(state_);
-        for (auto state_ptr = e - diff; state_ptr < e; ++state_ptr, ++h)
-          value += *state_ptr * *h;
-        std::advance(in_ptr, diff);
-      }
-      for (; in_ptr <= in; ++in_ptr, ++h)
-        value += *in_ptr * *h;
-
-      *out = value;
-      ++out;
-
-      coefs_phase_ += down_rate_;
-      const auto advance_amount = coefs_phase_ / up_rate_;
-      std::advance(in, advance_amount);
-      coefs_phase_ %= up_rate_;
+      // Keep the end of the history as the state.
+      std::copy(history + block_size, history + block_size + state_size, history);
     }
-    apply_offset_ = in - last;
-
-    // --------------------
-    // Manage state_ buffer
-    // --------------------
-
-    if (in_size < state_.size()) {
-      // Calculate number of samples retained in the state buffer.
-      const auto retain = state_.size() - in_size;
-
-      // Copy end of buffer to beginning.
-      auto o = copy(cend(state_) - retain, cend(state_), begin(state_));
-
-      // Copy the entire (short) input to end of buffer.
-      o = copy(first, last, o);
-
-      PANDA_TIMESWIPE_ASSERT(static_cast<typename
-        decltype(state_)::size_type>(o - cbegin(state_)) == state_.size());
-    } else
-      // Just copy last input samples into state buffer.
-      copy(last - state_.size(), last, begin(state_));
+    apply_offset_ = static_cast<std::ptrdiff_t>(in - in_size);
+    std::copy(history, history + state_size, begin(state_));
 
     is_applied_ = true;
     PANDA_TIMESWIPE_ASSERT(is_invariant_ok());
@@ -392,47 +590,7 @@ public:
   auto flush(OutputIt out)
   {
     auto extra = state_;
-    const auto b = begin(extra);
-    const auto e = end(extra);
-    switch (signal_extrapolation_) {
-    case Signal_extrapolation::zero:
-      fill(b, e, Input{});
-      break;
-    case Signal_extrapolation::smooth: {
-      using Value = typename decltype(extra)::value_type;
-      const auto sz = extra.size();
-      const auto [xn, xn_1] = extra.size() > 1 ?
-        std::make_pair(extra[sz - 1], extra[sz - 2]) :
-        std::make_pair(Value{}, extra[sz - 1]);
-      for (std::decay_t<decltype(sz)> k{1}; k <= sz; ++k)
-        extra[k - 1] = xn + k*(xn - xn_1);
-      break;
-    }
-    case Signal_extrapolation::constant:
-      fill(b, e, state_.back());
-      break;
-    case Signal_extrapolation::symmetric:
-      reverse(b, e);
-      break;
-    case Signal_extrapolation::reflect:
-      reflect_right(extra);
-      break;
-    case Signal_extrapolation::periodic:
-      break;
-    case Signal_extrapolation::antisymmetric:
-      reverse(b, e);
-      for_each(b, e, [](auto& x){ x = -x; });
-      break;
-    case Signal_extrapolation::antireflect:
-      auto reflected = extra;
-      reflect_right(reflected);
-      if (const auto sz = extra.size(); sz >= 2) {
-        const auto xn = extra.back();
-        for (std::decay_t<decltype(sz)> i{}; i < sz; ++i)
-          extra[i] = 2*xn - reflected[i];
-      }
-      break;
-    }
+    extrapolate_trailing(signal_extrapolation_, extra);
     auto result = apply(cbegin(extra), cend(extra), out);
     is_flushed_ = true;
     return result;
@@ -494,6 +652,10 @@ private:
   int coefs_per_phase_{}; // transposed_coefs_.size() / up_rate_
   std::vector<Coeff> transposed_coefs_;
   std::vector<Input> state_; // state buffer of size (coefs_per_phase_ - 1)
+  std::vector<Input> history_; // the state followed by the block of the input
+
+  /// The maximum number of input samples of the history.
+  static constexpr std::size_t history_block_size{1024};
 
   bool is_invariant_ok() const noexcept
   {
@@ -507,27 +669,291 @@ private:
       !(transposed_coefs_.size() % up_rate_);
     return rates_ok && time_ok && offset_ok && coefs_per_phase_ok && vecs_ok;
   }
+};
+
+/**
+ * @brief A functor for resampling of `Lanes` channels at once.
+ *
+ * @details This class is the same polyphase FIR resampler as Fir_resampler
+ * except that the channels are resampled together: the history of the channels
+ * is interleaved (i.e. the samples of all the channels at the same time are
+ * adjacent), so each coefficient of the filter is loaded once per output
+ * sample of all the channels and is multiplied by the samples of the channels
+ * as by the lanes of the vector (see dot_product_lanes()). Thus, if `Lanes`
+ * is interleaved_lane_count<In>, the memory traffic of the coefficients is
+ * reduced by the factor of `Lanes`. The input and output sequences are the
+ * columns, one per channel, so the (de)interleaving is done internally.
+ *
+ * The result is the same as of `Lanes` instances of Fir_resampler constructed
+ * by the same arguments, up to the rounding.
+ *
+ * @see Fir_resampler.
+ */
+template<typename In, std::size_t Lanes,
+  typename Coef = In, typename Out = std::common_type_t<In, Coef>>
+class Interleaved_fir_resampler final {
+public:
+  /// An alias of input element type.
+  using Input = In;
+
+  /// An alias of coefficient type.
+  using Coeff = Coef;
+
+  /// An alias of output element type.
+  using Output = Out;
+
+  /// The number of channels.
+  static constexpr std::size_t lane_count{Lanes};
+
+  /// The default constructor.
+  Interleaved_fir_resampler() = default;
+
+  /**
+   * @brief The constructor.
+   *
+   * @details The arguments are the same as of Fir_resampler.
+   */
+  template<typename InputIt>
+  Interleaved_fir_resampler(const int up_rate, const int down_rate,
+    const InputIt coefs_first, const InputIt coefs_last,
+    const Signal_extrapolation signal_extrapolation = Signal_extrapolation::zero)
+    : up_rate_{up_rate}
+    , down_rate_{down_rate}
+    , signal_extrapolation_{signal_extrapolation}
+  {
+    using ItCtg = typename std::iterator_traits<InputIt>::iterator_category;
+    static_assert(std::is_same_v<ItCtg, std::random_access_iterator_tag>);
+    static_assert(Lanes > 0);
+
+    const auto coefs_size = std::distance(coefs_first, coefs_last);
+    if (up_rate <= 0)
+      throw Exception{"invalid up rate value for FIR resampler"};
+    else if (down_rate <= 0)
+      throw Exception{"invalid down rate value for FIR resampler"};
+    else if (!coefs_size)
+      throw Exception{"invalid coefficients for FIR resampler"};
+
+    // Transpose and flip the coefficients exactly as Fir_resampler does.
+    transposed_coefs_.resize(coefs_size + (up_rate - coefs_size % up_rate));
+    coefs_per_phase_ = transposed_coefs_.size() / up_rate_;
+    for (int i{}; i < up_rate_; ++i) {
+      for (int j{}; j < coefs_per_phase_; ++j) {
+        if (j*up_rate_ + i < coefs_size)
+          transposed_coefs_[(coefs_per_phase_ - 1 - j) + i*coefs_per_phase_] = coefs_first[j*up_rate_ + i];
+      }
+    }
+
+    // The interleaved state and history, and the state of one channel.
+    const auto state_size = static_cast<std::size_t>(coefs_per_phase_ - 1);
+    state_.resize(state_size * Lanes);
+    history_.resize((state_size + history_block_size) * Lanes);
+    lane_state_.resize(state_size);
+
+    PANDA_TIMESWIPE_ASSERT(is_invariant_ok());
+  }
+
+  /// Non copy-constructible.
+  Interleaved_fir_resampler(const Interleaved_fir_resampler&) = delete;
+
+  /// Non copy-assignable.
+  Interleaved_fir_resampler& operator=(const Interleaved_fir_resampler&) = delete;
 
-  // ---------------------------------------------------------------------------
-  // Helpers
-  // ---------------------------------------------------------------------------
+  /// Move-constructible.
+  Interleaved_fir_resampler(Interleaved_fir_resampler&& rhs) noexcept
+  {
+    swap(rhs);
+  }
 
-  static void reflect_left(std::vector<Input>& state) noexcept
+  /// Move-assignable.
+  Interleaved_fir_resampler& operator=(Interleaved_fir_resampler&& rhs) noexcept
   {
-    if (state.size() >= 3) {
-      copy(begin(state) + 1, end(state), begin(state)); // x2,...,xn,xn
-      reverse(begin(state), end(state)); // xn,xn,...,x2
-      state[0] = state[2]; // xn-1,xn,...,x2
+    if (this != &rhs) {
+      Interleaved_fir_resampler tmp{std::move(rhs)};
+      swap(tmp);
     }
+    return *this;
   }
 
-  static void reflect_right(std::vector<Input>& state) noexcept
+  /// Swappable.
+  void swap(Interleaved_fir_resampler& rhs) noexcept
   {
-    if (state.size() >= 3) {
-      reverse(begin(state), end(state)); // xn,...,x2,x1
-      copy(begin(state) + 1, end(state), begin(state)); // xn-1,...,x2,x1,x1
-      state.back() = state[state.size() - 3]; // xn-1,...,x2,x1,x2
+    using std::swap;
+    swap(is_applied_, rhs.is_applied_);
+    swap(is_flushed_, rhs.is_flushed_);
+    swap(up_rate_, rhs.up_rate_);
+    swap(down_rate_, rhs.down_rate_);
+    swap(signal_extrapolation_, rhs.signal_extrapolation_);
+    swap(coefs_phase_, rhs.coefs_phase_);
+    swap(apply_offset_, rhs.apply_offset_);
+    swap(coefs_per_phase_, rhs.coefs_per_phase_);
+    swap(transposed_coefs_, rhs.transposed_coefs_);
+    swap(state_, rhs.state_);
+    swap(history_, rhs.history_);
+    swap(lane_state_, rhs.lane_state_);
+  }
+
+  /**
+   * @brief Resamples `in_size` samples of each of the channels. Writes
+   * `output_sequence_size(in_size)` samples of each channel to the output.
+   *
+   * @details The first time this function is called, the initial signal
+   * extrapolation performed for each channel as by Fir_resampler::apply().
+   *
+   * @param in The input sequences, one per channel.
+   * @param in_size The size of each of the input sequences.
+   * @param out The output sequences, one per channel.
+   *
+   * @returns The number of samples written to each of the output sequences.
+   */
+  std::size_t apply(const std::array<const Input*, Lanes>& in,
+    const std::size_t in_size, const std::array<Output*, Lanes>& out)
+  {
+    if (!in_size)
+      return 0;
+
+    const auto state_size = lane_state_.size();
+    if (!is_applied_ && signal_extrapolation_ != Signal_extrapolation::zero) {
+      for (std::size_t l{}; l < Lanes; ++l) {
+        for (std::size_t i{}; i < state_size; ++i)
+          lane_state_[i] = state_[i*Lanes + l];
+        extrapolate_leading(signal_extrapolation_, lane_state_, in[l], in_size);
+        for (std::size_t i{}; i < state_size; ++i)
+          state_[i*Lanes + l] = lane_state_[i];
+      }
     }
+
+    /*
+     * Make the interleaved history contiguous (the state followed by the block
+     * of the input) as Fir_resampler::apply() does, so each output sample of
+     * all the channels is the single call of dot_product_lanes().
+     */
+    PANDA_TIMESWIPE_ASSERT(history_.size() == (state_size + history_block_size) * Lanes);
+    auto* const history = history_.data();
+    std::copy(cbegin(state_), cend(state_), history);
+    const auto* const coefs = transposed_coefs_.data();
+    const auto window_size = static_cast<std::size_t>(coefs_per_phase_);
+    std::array<Output, Lanes> values;
+    std::size_t result{};
+    auto in_index = static_cast<std::size_t>(apply_offset_);
+    for (std::size_t offset{}; offset < in_size; offset += history_block_size) {
+      const auto block_size = std::min(history_block_size, in_size - offset);
+      auto* const block = history + state_size * Lanes;
+      for (std::size_t l{}; l < Lanes; ++l) {
+        const auto* const column = in[l] + offset;
+        for (std::size_t i{}; i < block_size; ++i)
+          block[i*Lanes + l] = column[i];
+      }
+      for (const auto block_end = offset + block_size; in_index < block_end;) {
+        dot_product_lanes<Lanes>(coefs + coefs_phase_*coefs_per_phase_,
+          history + (in_index - offset) * Lanes, window_size, values.data());
+        for (std::size_t l{}; l < Lanes; ++l)
+          out[l][result] = values[l];
+        ++result;
+
+        coefs_phase_ += down_rate_;
+        in_index += coefs_phase_ / up_rate_;
+        coefs_phase_ %= up_rate_;
+      }
+
+      // Keep the end of the history as the state.
+      std::copy(history + block_size * Lanes,
+        history + (block_size + state_size) * Lanes, history);
+    }
+    apply_offset_ = static_cast<std::ptrdiff_t>(in_index - in_size);
+    std::copy(history, history + state_.size(), begin(state_));
+
+    is_applied_ = true;
+    PANDA_TIMESWIPE_ASSERT(is_invariant_ok());
+    return result;
+  }
+
+  /**
+   * @brief Resamples the extrapolated (extra) sequence of length of one
+   * polyphase of filter of each channel.
+   *
+   * @details Writes `output_sequence_size(coefs_per_phase() - 1)` samples of
+   * each channel to the output. This method should be called after the last
+   * call of apply() in order to flush the end samples out.
+   *
+   * @returns The number of samples written to each of the output sequences.
+   *
+   * @see Fir_resampler::flush().
+   */
+  std::size_t flush(const std::array<Output*, Lanes>& out)
+  {
+    const auto state_size = lane_state_.size();
+    std::array<std::vector<Input>, Lanes> extras;
+    std::array<const Input*, Lanes> in;
+    for (std::size_t l{}; l < Lanes; ++l) {
+      auto& extra = extras[l];
+      extra.resize(state_size);
+      for (std::size_t i{}; i < state_size; ++i)
+        extra[i] = state_[i*Lanes + l];
+      extrapolate_trailing(signal_extrapolation_, extra);
+      in[l] = extra.data();
+    }
+    const auto result = apply(in, state_size, out);
+    is_flushed_ = true;
+    return result;
+  }
+
+  /// @returns `true` if apply() is successfuly called at least once.
+  bool is_applied() const noexcept
+  {
+    return is_applied_;
+  }
+
+  /// @returns `true` if flush() is successfuly called at least once.
+  bool is_flushed() const noexcept
+  {
+    return is_flushed_;
+  }
+
+  /// @returns The same as Fir_resampler::output_sequence_size().
+  std::size_t output_sequence_size(const std::size_t in_size) const noexcept
+  {
+    const std::size_t np = in_size * up_rate_;
+    std::size_t result = np / down_rate_;
+    if (static_cast<std::size_t>(coefs_phase_ + up_rate_ * apply_offset_) < (np % down_rate_))
+      result++;
+    return result;
+  }
+
+  /// @returns The number of coefficients per phase.
+  int coefs_per_phase() const noexcept
+  {
+    return coefs_per_phase_;
+  }
+
+private:
+  bool is_applied_{};
+  bool is_flushed_{};
+  int up_rate_{};
+  int down_rate_{};
+  Signal_extrapolation signal_extrapolation_{Signal_extrapolation::zero};
+  int coefs_phase_{}; // next phase of the filter to use (mod up_rate_)
+  std::ptrdiff_t apply_offset_{}; // the amount of samples to skip upon apply()
+  int coefs_per_phase_{}; // transposed_coefs_.size() / up_rate_
+  std::vector<Coeff> transposed_coefs_;
+  std::vector<Input> state_; // interleaved state of size (coefs_per_phase_ - 1) * Lanes
+  std::vector<Input> history_; // the state followed by the block of the input
+  std::vector<Input> lane_state_; // state of one channel for the extrapolation
+
+  /// The maximum number of input samples (per channel) of the history.
+  static constexpr std::size_t history_block_size{1024};
+
+  bool is_invariant_ok() const noexcept
+  {
+    const bool rates_ok = up_rate_ > 0 && down_rate_ > 0;
+    const bool time_ok = coefs_phase_ < up_rate_;
+    const bool offset_ok = apply_offset_ >= 0;
+    const bool coefs_per_phase_ok = coefs_per_phase_ > 0;
+    const bool vecs_ok =
+      (lane_state_.size() == static_cast<std::size_t>(coefs_per_phase_ - 1)) &&
+      (state_.size() == lane_state_.size() * Lanes) &&
+      (transposed_coefs_.size() == static_cast<std::size_t>(coefs_per_phase_ * up_rate_)) &&
+      !(transposed_coefs_.size() % up_rate_);
+    return rates_ok && time_ok && offset_ok && coefs_per_phase_ok && vecs_ok;
   }
 };
 
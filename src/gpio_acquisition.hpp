@@ -0,0 +1,298 @@
+// -*- C++ -*-
+
+// PANDA Timeswipe Project
+// Copyright (C) 2021  PANDA GmbH / Dmitry Igrishin
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef PANDA_TIMESWIPE_GPIO_ACQUISITION_HPP
+#define PANDA_TIMESWIPE_GPIO_ACQUISITION_HPP
+
+#include "acquisition.hpp"
+#include "bcmlib.hpp"
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <thread>
+
+namespace panda::timeswipe::detail {
+
+/// A source of the data sets read from the board via BCM GPIO.
+class Gpio_acquisition_source final : public Acquisition_source {
+public:
+  bool is_board_attached() const noexcept override
+  {
+    return true;
+  }
+
+  /*
+   * Initialize GPIO pins.
+   *
+   * @par Effects
+   * Restarts firmware on very first run!
+   *
+   * @warning Firmware developers must remember, that restarting the firmware
+   * causes reset of all the settings the firmware keeps in the on-board RAM!
+   */
+  void initialize() override
+  {
+    if (is_gpio_inited_) return;
+
+    setup_io();
+    init_gpio_input(gpio_data0);
+    init_gpio_input(gpio_data1);
+    init_gpio_input(gpio_data2);
+    init_gpio_input(gpio_data3);
+    init_gpio_input(gpio_data4);
+    init_gpio_input(gpio_data5);
+    init_gpio_input(gpio_data6);
+    init_gpio_input(gpio_data7);
+
+    init_gpio_input(gpio_tco);
+    init_gpio_input(gpio_pi_ok);
+    init_gpio_input(gpio_fail);
+    init_gpio_input(gpio_button);
+
+    // init_gpio_output(gpio_pi_ok);
+    init_gpio_output(gpio_clock);
+    init_gpio_output(gpio_reset);
+
+    // Initial Reset
+    set_gpio_low(gpio_clock);
+    set_gpio_high(gpio_reset);
+
+    /*
+     * On some devices delay is required to get SPI communication work.
+     * There is also delay in Bcm_spi::initialize().
+     */
+    std::this_thread::sleep_for(std::chrono::milliseconds{100});
+
+    is_gpio_inited_ = true;
+  }
+
+  void start() override
+  {
+    PANDA_TIMESWIPE_ASSERT(is_gpio_inited_);
+    start_time_ = Clock::now();
+    read_count_ = 0;
+    data_set_size_ = 0;
+    lost_count_ = 0;
+    is_overflowed_ = false;
+  }
+
+  void stop() override
+  {
+    // Reset clock.
+    set_gpio_low(gpio_clock);
+  }
+
+  void await_data(const std::chrono::microseconds interval) override
+  {
+    std::this_thread::sleep_for(interval);
+    data_set_size_ = 0;
+  }
+
+  Chunk_read read_chunk() noexcept override
+  {
+    Chunk_read result;
+    result.chunk[0] = read().byte;
+    {
+      const auto d = read();
+      result.chunk[1] = d.byte;
+      result.tco = d.tco;
+      result.pi_ok = d.pi_ok;
+    }
+    for (unsigned i{2}; i < result.chunk.size(); ++i)
+      result.chunk[i] = read().byte;
+    ++read_count_;
+    ++data_set_size_;
+    return result;
+  }
+
+  void complete_reading() noexcept override
+  {
+    // The FAIL pin becomes high when the RAM of the board is full.
+    if (read_all_gpio() & gpio_fail_position)
+      is_overflowed_ = true;
+    else if (data_set_size_ < max_data_set_size && !is_overflowed_) {
+      /*
+       * The short data set means that the RAM of the board is drained, so
+       * all the chunks produced so far are either read or lost. Move the
+       * start time accordingly, so the drift between the clocks of the Pi
+       * and the board doesn't accumulate.
+       */
+      const std::chrono::duration<double> accounted{
+        static_cast<double>(read_count_ + lost_count_) / sample_rate};
+      start_time_ = Clock::now() - std::chrono::duration_cast<Clock::duration>(accounted);
+    }
+    sleep_for_55ns();
+  }
+
+  /**
+   * @details The board doesn't tell how many chunks are lost, so the number
+   * is estimated when the FAIL pin has been seen high, as the number of
+   * chunks which the board must have been produced since the RAM was drained
+   * last time minus the chunks read since then and the chunks which are still
+   * in the full RAM. The estimate is bounded by `board_ram_capacity` per
+   * overflow, so the error of the estimate is bounded as well.
+   */
+  std::uint64_t take_lost_count() noexcept override
+  {
+    if (!is_overflowed_)
+      return 0;
+
+    is_overflowed_ = false;
+    const std::chrono::duration<double> elapsed{Clock::now() - start_time_};
+    const auto produced_count = static_cast<std::uint64_t>(elapsed.count() * sample_rate);
+    const auto accounted_count = read_count_ + lost_count_ + board_ram_capacity;
+    const auto result = std::min<std::uint64_t>(produced_count > accounted_count ?
+      produced_count - accounted_count : 0, board_ram_capacity);
+    lost_count_ += result;
+    return result;
+  }
+
+private:
+  using Clock = std::chrono::steady_clock;
+  bool is_gpio_inited_{};
+  bool is_overflowed_{};
+  Clock::time_point start_time_{};
+  std::uint64_t read_count_{};
+  std::uint64_t data_set_size_{}; // the number of chunks read since await_data()
+  std::uint64_t lost_count_{};
+
+  // The number of chunks per second produced by the board.
+  static constexpr int sample_rate{48000};
+
+  // PIN NAMES
+  static constexpr std::uint8_t gpio_data0{24};  // BCM 24 - PIN 18
+  static constexpr std::uint8_t gpio_data1{25};  // BCM 25 - PIN 22
+  static constexpr std::uint8_t gpio_data2{7};   // BCM  7 - PIN 26
+  static constexpr std::uint8_t gpio_data3{5};   // BCM  5 - PIN 29
+  static constexpr std::uint8_t gpio_data4{6};   // BCM  6 - PIN 31
+  static constexpr std::uint8_t gpio_data5{12};  // BCM 12 - PIN 32
+  static constexpr std::uint8_t gpio_data6{13};  // BCM 13 - PIN 33
+  static constexpr std::uint8_t gpio_data7{16};  // BCM 16 - PIN 36
+  static constexpr std::uint8_t gpio_clock{4};   // BCM  4 - PIN  7
+  static constexpr std::uint8_t gpio_tco{14};    // BCM 14 - PIN  8
+  static constexpr std::uint8_t gpio_pi_ok{15};  // BCM 15 - PIN 10
+  static constexpr std::uint8_t gpio_fail{18};   // BCM 18 - PIN 12
+  static constexpr std::uint8_t gpio_reset{17};  // BCM 17 - PIN 11
+  static constexpr std::uint8_t gpio_button{25}; // BCM 25 - PIN 22
+
+  static constexpr std::array<std::uint32_t, 8> gpio_data_position{
+    std::uint32_t{1} << gpio_data0,
+    std::uint32_t{1} << gpio_data1,
+    std::uint32_t{1} << gpio_data2,
+    std::uint32_t{1} << gpio_data3,
+    std::uint32_t{1} << gpio_data4,
+    std::uint32_t{1} << gpio_data5,
+    std::uint32_t{1} << gpio_data6,
+    std::uint32_t{1} << gpio_data7
+  };
+
+  static constexpr std::uint32_t gpio_clock_position{std::uint32_t{1} << gpio_clock};
+  static constexpr std::uint32_t gpio_tco_position{std::uint32_t{1} << gpio_tco};
+  static constexpr std::uint32_t gpio_pi_status_position{std::uint32_t{1} << gpio_pi_ok};
+  static constexpr std::uint32_t gpio_fail_position{std::uint32_t{1} << gpio_fail};
+  static constexpr std::uint32_t gpio_button_position{std::uint32_t{1} << gpio_button};
+  static_assert(gpio_tco_position == chunk_tco_continue);
+
+  // (2^32)-1 - ALL BCM pins
+  static constexpr std::uint32_t gpio_all_32_bits_on{0xFFFFFFFF};
+
+  struct Gpio_data final {
+    std::uint8_t byte{};
+    unsigned tco{};
+    bool pi_ok{};
+  };
+
+  static void pull_gpio(const unsigned pin, const unsigned high) noexcept
+  {
+    PANDA_TIMESWIPE_GPIO_PULL = high << pin;
+  }
+
+  static void init_gpio_input(const unsigned pin) noexcept
+  {
+    PANDA_TIMESWIPE_INP_GPIO(pin);
+  }
+
+  static void init_gpio_output(const unsigned pin) noexcept
+  {
+    PANDA_TIMESWIPE_INP_GPIO(pin);
+    PANDA_TIMESWIPE_OUT_GPIO(pin);
+    pull_gpio(pin, 0);
+  }
+
+  static void set_gpio_high(const unsigned pin) noexcept
+  {
+    PANDA_TIMESWIPE_GPIO_SET = 1 << pin;
+  }
+
+  static void set_gpio_low(const unsigned pin) noexcept
+  {
+    PANDA_TIMESWIPE_GPIO_CLR = 1 << pin;
+  }
+
+  static void reset_all_gpio() noexcept
+  {
+    PANDA_TIMESWIPE_GPIO_CLR = gpio_all_32_bits_on;
+  }
+
+  static unsigned read_all_gpio() noexcept
+  {
+    return (*(bcm_gpio + 13) & gpio_all_32_bits_on);
+  }
+
+  static void sleep_for_55ns() noexcept
+  {
+    read_all_gpio();
+  }
+
+  static void sleep_for_8ns() noexcept
+  {
+    set_gpio_high(10); // ANY UNUSED PIN!!!
+  }
+
+  static Gpio_data read() noexcept
+  {
+    set_gpio_high(gpio_clock);
+    sleep_for_55ns();
+    sleep_for_55ns();
+
+    set_gpio_low(gpio_clock);
+    sleep_for_55ns();
+    sleep_for_55ns();
+
+    const unsigned all_gpio{read_all_gpio()};
+    const std::uint8_t byte =
+      ((all_gpio & gpio_data_position[0]) >> 17) |  // Bit 7
+      ((all_gpio & gpio_data_position[1]) >> 19) |  //     6
+      ((all_gpio & gpio_data_position[2]) >>  2) |  //     5
+      ((all_gpio & gpio_data_position[3]) >>  1) |  //     4
+      ((all_gpio & gpio_data_position[4]) >>  3) |  //     3
+      ((all_gpio & gpio_data_position[5]) >> 10) |  //     2
+      ((all_gpio & gpio_data_position[6]) >> 12) |  //     1
+      ((all_gpio & gpio_data_position[7]) >> 16);   //     0
+
+    sleep_for_55ns();
+    sleep_for_55ns();
+
+    return {byte, (all_gpio & gpio_tco_position), (all_gpio & gpio_pi_status_position) != 0};
+  }
+};
+
+} // namespace panda::timeswipe::detail
+
+#endif  // PANDA_TIMESWIPE_GPIO_ACQUISITION_HPP
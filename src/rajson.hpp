@@ -49,6 +49,30 @@ template<> struct Enum_traits<Measurement_mode> final {
   }
 };
 
+/// Full specialization for Wakeup_policy.
+template<> struct Enum_traits<Wakeup_policy> final {
+  static constexpr const char* singular_name() noexcept
+  {
+    return "wakeup policy";
+  }
+};
+
+/// Full specialization for Overflow_policy.
+template<> struct Enum_traits<Overflow_policy> final {
+  static constexpr const char* singular_name() noexcept
+  {
+    return "overflow policy";
+  }
+};
+
+/// Full specialization for Scheduling_policy.
+template<> struct Enum_traits<Scheduling_policy> final {
+  static constexpr const char* singular_name() noexcept
+  {
+    return "scheduling policy";
+  }
+};
+
 /// Full specialization for Measurement_mode.
 template<> struct Enum_traits<hat::atom::Calibration::Type> final {
   static constexpr const char* singular_name() noexcept
@@ -94,6 +118,21 @@ template<>
 struct Conversions<panda::timeswipe::Measurement_mode> final :
   panda::timeswipe::detail::Enum_conversions<panda::timeswipe::Measurement_mode>{};
 
+/// Full specialization for `panda::timeswipe::Wakeup_policy`.
+template<>
+struct Conversions<panda::timeswipe::Wakeup_policy> final :
+  panda::timeswipe::detail::Enum_conversions<panda::timeswipe::Wakeup_policy>{};
+
+/// Full specialization for `panda::timeswipe::Overflow_policy`.
+template<>
+struct Conversions<panda::timeswipe::Overflow_policy> final :
+  panda::timeswipe::detail::Enum_conversions<panda::timeswipe::Overflow_policy>{};
+
+/// Full specialization for `panda::timeswipe::Scheduling_policy`.
+template<>
+struct Conversions<panda::timeswipe::Scheduling_policy> final :
+  panda::timeswipe::detail::Enum_conversions<panda::timeswipe::Scheduling_policy>{};
+
 /// Full specialization for `panda::timeswipe::detail::hat::atom::Calibration::Type`.
 template<>
 struct Conversions<panda::timeswipe::detail::hat::atom::Calibration::Type> final :
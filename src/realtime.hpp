@@ -0,0 +1,109 @@
+// -*- C++ -*-
+
+// PANDA Timeswipe Project
+// Copyright (C) 2021  PANDA GmbH / Dmitry Igrishin
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+/**
+ * @file
+ *
+ * @remarks The code of this file is exception-free!
+ */
+
+#ifndef PANDA_TIMESWIPE_REALTIME_HPP
+#define PANDA_TIMESWIPE_REALTIME_HPP
+
+#include "basics.hpp"
+
+#include <cstddef>
+#include <optional>
+
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+
+namespace panda::timeswipe::detail {
+
+/**
+ * @brief Pins the `thread` to the `cpu`.
+ *
+ * @returns `true` if the request is granted.
+ */
+inline bool set_thread_affinity(const pthread_t thread, const int cpu) noexcept
+{
+  if (!(0 <= cpu && cpu < CPU_SETSIZE))
+    return false;
+
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  CPU_SET(cpu, &set);
+  return !pthread_setaffinity_np(thread, sizeof(set), &set);
+}
+
+/**
+ * @brief Sets the scheduling `policy` and `priority` of the `thread`.
+ *
+ * @param priority The priority. `std::nullopt` means the minimum priority of
+ * the `policy`.
+ *
+ * @returns `true` if the request is granted.
+ */
+inline bool set_thread_scheduling(const pthread_t thread,
+  const Scheduling_policy policy, const std::optional<int> priority) noexcept
+{
+  int native_policy{};
+  switch (policy) {
+  case Scheduling_policy::other: native_policy = SCHED_OTHER; break;
+  case Scheduling_policy::fifo: native_policy = SCHED_FIFO; break;
+  case Scheduling_policy::round_robin: native_policy = SCHED_RR; break;
+  default: return false;
+  }
+
+  const int min_priority{sched_get_priority_min(native_policy)};
+  const int max_priority{sched_get_priority_max(native_policy)};
+  sched_param param{};
+  param.sched_priority = priority.value_or(min_priority);
+  if (!(min_priority <= param.sched_priority && param.sched_priority <= max_priority))
+    return false;
+
+  return !pthread_setschedparam(thread, native_policy, &param);
+}
+
+/**
+ * @brief Locks all the current and future memory of the process into RAM.
+ *
+ * @returns `true` if the request is granted.
+ */
+inline bool lock_memory() noexcept
+{
+  return !mlockall(MCL_CURRENT | MCL_FUTURE);
+}
+
+/**
+ * @brief Touches `Size` bytes of the stack of the calling thread, so it
+ * doesn't incur page faults later.
+ */
+template<std::size_t Size = 256*1024>
+void prefault_stack() noexcept
+{
+  // (The writes to the volatile array aren't elided, though it's never read.)
+  [[maybe_unused]] volatile unsigned char stack[Size];
+  for (std::size_t i{}; i < Size; i += 4096)
+    stack[i] = 0;
+}
+
+} // namespace panda::timeswipe::detail
+
+#endif  // PANDA_TIMESWIPE_REALTIME_HPP
@@ -0,0 +1,309 @@
+// -*- C++ -*-
+
+// PANDA Timeswipe Project
+// Copyright (C) 2021  PANDA GmbH / Dmitry Igrishin
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef PANDA_TIMESWIPE_RECORDER_HPP
+#define PANDA_TIMESWIPE_RECORDER_HPP
+
+#include "errc.hpp"
+#include "exceptions.hpp"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <utility>
+
+namespace panda::timeswipe {
+
+/// The format of the files written by the recorder.
+enum class Recorder_format {
+  /**
+   * The samples as 32-bit floats of the native byte order, row by row (i.e.
+   * the values of all the channels of the first sample, then the ones of the
+   * second sample and so on), which is the binary format accepted by
+   * `tool/plot.sh`. The files are named with the extension `.bin`.
+   */
+  raw,
+
+  /**
+   * The self-describing capture format (see Capture_reader). The files are
+   * named with the extension `.tswcap`.
+   */
+  capture,
+
+  /**
+   * The capture format with the codes of the ADC (see Driver::Raw_data)
+   * instead of the values. The codes are compressed losslessly by the delta
+   * encoding followed by the bit packing, which shrinks the slowly changing
+   * signals several times. The values are calculated by Capture_reader
+   * exactly as by the driver. Requires the recording at the max sample rate.
+   */
+  compressed_capture
+};
+
+/**
+ * @brief The options of the recorder of the data to the files.
+ *
+ * @details The files are named as `<path_prefix>NNNNNN.<extension>`, where
+ * `NNNNNN` is the zero-padded index of the file, which is counted from zero
+ * for each recorder and isn't reset between the measurements. The existing
+ * files are overwritten.
+ *
+ * @see Driver::add_recorder().
+ */
+class Recorder_options final {
+public:
+  /// The alignment of the buffer size required for the direct I/O.
+  static constexpr std::size_t block_size{4096};
+
+  /**
+   * @brief The constructor.
+   *
+   * @par Requires
+   * `!path_prefix.empty()`.
+   */
+  explicit Recorder_options(std::string path_prefix)
+    : path_prefix_{std::move(path_prefix)}
+  {
+    if (path_prefix_.empty())
+      throw Exception{Errc::driver_settings_invalid,
+        "invalid path prefix for recorder"};
+  }
+
+  /// @returns The path prefix of the files.
+  const std::string& path_prefix() const noexcept
+  {
+    return path_prefix_;
+  }
+
+  /**
+   * @brief Sets the format of the files.
+   *
+   * @details The default is `Recorder_format::raw`.
+   *
+   * @returns *this.
+   */
+  Recorder_options& set_format(const Recorder_format value) noexcept
+  {
+    format_ = value;
+    return *this;
+  }
+
+  /// @returns The format of the files.
+  Recorder_format format() const noexcept
+  {
+    return format_;
+  }
+
+  /**
+   * @brief Sets the maximum number of rows of the chunk of the capture file.
+   *
+   * @details The chunk is the unit of the random access to the capture file.
+   * It must fit into the buffer (see set_buffer_size()) along with its header
+   * of 32 bytes. The default is 4800.
+   *
+   * @par Requires
+   * `(value > 0)`.
+   *
+   * @returns *this.
+   */
+  Recorder_options& set_chunk_row_count(const std::size_t value)
+  {
+    if (!(value > 0))
+      throw Exception{Errc::driver_settings_invalid,
+        "invalid chunk row count for recorder"};
+
+    chunk_row_count_ = value;
+    return *this;
+  }
+
+  /// @returns The maximum number of rows of the chunk of the capture file.
+  std::size_t chunk_row_count() const noexcept
+  {
+    return chunk_row_count_;
+  }
+
+  /**
+   * @brief Sets the size (in bytes) at which the file is rotated.
+   *
+   * @details The file is rotated at the buffer boundary, so it can exceed
+   * this size by less than buffer_size(). If is_preallocation_enabled() this
+   * size is preallocated for each file. The default is 1 GiB.
+   *
+   * @par Requires
+   * `(value > 0)`.
+   *
+   * @returns *this.
+   */
+  Recorder_options& set_file_size(const std::uint64_t value)
+  {
+    if (!(value > 0))
+      throw Exception{Errc::driver_settings_invalid,
+        "invalid file size for recorder"};
+
+    file_size_ = value;
+    return *this;
+  }
+
+  /// @returns The size at which the file is rotated.
+  std::uint64_t file_size() const noexcept
+  {
+    return file_size_;
+  }
+
+  /**
+   * @brief Sets the duration after which the file is rotated regardless of
+   * its size.
+   *
+   * @details The file is rotated at the buffer boundary. The file isn't
+   * rotated by the time by default.
+   *
+   * @par Requires
+   * `(!value || value->count() > 0)`.
+   *
+   * @returns *this.
+   */
+  Recorder_options& set_file_duration(const std::optional<std::chrono::seconds> value)
+  {
+    if (value && !(value->count() > 0))
+      throw Exception{Errc::driver_settings_invalid,
+        "invalid file duration for recorder"};
+
+    file_duration_ = value;
+    return *this;
+  }
+
+  /// @returns The duration after which the file is rotated.
+  std::optional<std::chrono::seconds> file_duration() const noexcept
+  {
+    return file_duration_;
+  }
+
+  /**
+   * @brief Sets the size (in bytes) of each of the two buffers, one of which
+   * is filled by the measurement while the other one is written to the file.
+   *
+   * @details The default is 4 MiB.
+   *
+   * @par Requires
+   * `(value > 0 && !(value % block_size))`.
+   *
+   * @returns *this.
+   */
+  Recorder_options& set_buffer_size(const std::size_t value)
+  {
+    if (!(value > 0 && !(value % block_size)))
+      throw Exception{Errc::driver_settings_invalid,
+        "invalid buffer size for recorder"};
+
+    buffer_size_ = value;
+    return *this;
+  }
+
+  /// @returns The size of each of the two buffers.
+  std::size_t buffer_size() const noexcept
+  {
+    return buffer_size_;
+  }
+
+  /**
+   * @brief Sets the number of bytes written after which the data is flushed
+   * to the storage device by `fdatasync()`.
+   *
+   * @details The data is also flushed when the file is closed. The default
+   * is 16 MiB.
+   *
+   * @par Requires
+   * `(value > 0)`.
+   *
+   * @returns *this.
+   */
+  Recorder_options& set_sync_size(const std::uint64_t value)
+  {
+    if (!(value > 0))
+      throw Exception{Errc::driver_settings_invalid,
+        "invalid sync size for recorder"};
+
+    sync_size_ = value;
+    return *this;
+  }
+
+  /// @returns The number of bytes written after which the data is flushed.
+  std::uint64_t sync_size() const noexcept
+  {
+    return sync_size_;
+  }
+
+  /**
+   * @brief Sets whether the file_size() is preallocated for each file, so
+   * the file system doesn't have to allocate the blocks while recording.
+   *
+   * @details The file is truncated to the size of the data written when it's
+   * closed. The preallocation is enabled by default.
+   *
+   * @returns *this.
+   */
+  Recorder_options& set_preallocation_enabled(const bool value) noexcept
+  {
+    is_preallocation_enabled_ = value;
+    return *this;
+  }
+
+  /// @returns `true` if the preallocation is enabled.
+  bool is_preallocation_enabled() const noexcept
+  {
+    return is_preallocation_enabled_;
+  }
+
+  /**
+   * @brief Sets whether the files are opened with `O_DIRECT`, so the data
+   * bypasses the page cache.
+   *
+   * @details The option is ignored if the file system doesn't support it.
+   * The direct I/O is disabled by default.
+   *
+   * @returns *this.
+   */
+  Recorder_options& set_direct_io_enabled(const bool value) noexcept
+  {
+    is_direct_io_enabled_ = value;
+    return *this;
+  }
+
+  /// @returns `true` if the direct I/O is enabled.
+  bool is_direct_io_enabled() const noexcept
+  {
+    return is_direct_io_enabled_;
+  }
+
+private:
+  std::string path_prefix_;
+  Recorder_format format_{Recorder_format::raw};
+  std::size_t chunk_row_count_{4800};
+  std::uint64_t file_size_{1 << 30};
+  std::optional<std::chrono::seconds> file_duration_;
+  std::size_t buffer_size_{4 << 20};
+  std::uint64_t sync_size_{16 << 20};
+  bool is_preallocation_enabled_{true};
+  bool is_direct_io_enabled_{};
+};
+
+} // namespace panda::timeswipe
+
+#endif  // PANDA_TIMESWIPE_RECORDER_HPP
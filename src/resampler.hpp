@@ -21,16 +21,20 @@
 
 #include "debug.hpp"
 #include "exceptions.hpp"
+#include "fir_cache.hpp"
 #include "fir_resampler.hpp"
 #include "math.hpp"
 #include "table.hpp"
+#include "trace.hpp"
 
 #include <algorithm>
+#include <array>
 #include <cstddef>
 #include <iostream>
 #include <iterator>
 #include <limits>
 #include <numeric>
+#include <optional>
 #include <type_traits>
 #include <vector>
 #include <utility>
@@ -47,6 +51,7 @@ public:
     , down_factor_{1}
     , extrapolation_{Signal_extrapolation::zero}
     , crop_extra_{true}
+    , is_multistage_enabled_{}
     , filter_length_{default_filter_length(up_factor_, down_factor_)}
     , freq_{default_freq(up_factor_)}
     , ampl_{default_ampl()}
@@ -167,6 +172,31 @@ public:
     return crop_extra_;
   }
 
+  /**
+   * @brief Sets the multistage mode.
+   *
+   * @details If this option is set to `true` the large down factor is split
+   * into the cascade of the decimation stages followed by the final polyphase
+   * stage (see plan_resampler_stages()), each with its own short filter which
+   * is designed by design_stage_filter(). In this case, filter_length(),
+   * freq() and ampl() are ignored. If the down factor is too small to split,
+   * the resampling is done by the single stage regardless of this option.
+   *
+   * @returns *this.
+   */
+  Resampler_options& set_multistage_enabled(const bool value)
+  {
+    is_multistage_enabled_ = value;
+    PANDA_TIMESWIPE_ASSERT(is_invariant_ok());
+    return *this;
+  }
+
+  /// @returns The multistage mode.
+  bool is_multistage_enabled() const noexcept
+  {
+    return is_multistage_enabled_;
+  }
+
   /**
    * @brief Sets the filter length.
    *
@@ -314,6 +344,7 @@ private:
   int down_factor_;
   Signal_extrapolation extrapolation_;
   bool crop_extra_;
+  bool is_multistage_enabled_;
   int filter_length_;
   std::vector<double> freq_;
   std::vector<double> ampl_;
@@ -328,6 +359,120 @@ private:
   }
 };
 
+/// A stage of the resampling.
+struct Resampler_stage final {
+  /// The up factor.
+  int up_factor{1};
+
+  /// The down factor.
+  int down_factor{1};
+
+  /**
+   * @brief The passband edge, which is relative to the Nyquist frequency of
+   * the upsampled input of the stage.
+   */
+  double passband_edge{};
+};
+
+/// The ratio of the passband edge to the output Nyquist frequency of the cascade.
+constexpr double resampler_stage_passband_ratio{.9};
+
+/// The stopband attenuation (in dB) of the filters of the cascade.
+constexpr double resampler_stage_attenuation{90};
+
+/**
+ * @returns The stages of the resampling by the given `options`.
+ *
+ * @details If `options.is_multistage_enabled()`, the prime factors of the down
+ * factor are split off in ascending order (so the factors of 2 come first as
+ * the half-band stages) as long as the rest of the down factor is at least
+ * twice the up factor, i.e. as long as the output rate of each decimation
+ * stage is at least twice the output rate of the whole cascade. The rest of
+ * the down factor along with the up factor is the final polyphase stage. Each
+ * stage has to protect only the passband of the whole cascade from aliasing,
+ * so the filters of the early stages are short despite of the high rate.
+ *
+ * @remarks The passband edge of the single stage isn't used.
+ */
+inline std::vector<Resampler_stage> plan_resampler_stages(const Resampler_options& options)
+{
+  const auto up = options.up_factor();
+  auto down = options.down_factor();
+  if (!options.is_multistage_enabled())
+    return {{up, down}};
+
+  // Split off the decimation factors.
+  std::vector<Resampler_stage> result;
+  for (int factor{2}; factor <= down;) {
+    if (down % factor)
+      ++factor;
+    else if (down / factor >= 2*up) {
+      result.push_back({1, factor});
+      down /= factor;
+    } else
+      break;
+  }
+  if (result.empty())
+    return {{up, down}};
+  result.push_back({up, down});
+
+  // Calculate the passband edges relative to the input rate of each stage.
+  const double passband{resampler_stage_passband_ratio * options.up_factor() /
+    options.down_factor()}; // relative to the Nyquist frequency of the input
+  double rate{1}; // relative to the input rate of the cascade
+  for (auto& stage : result) {
+    stage.passband_edge = passband / (rate * stage.up_factor);
+    rate /= stage.down_factor;
+  }
+  return result;
+}
+
+/**
+ * @returns The coefficients of the lowpass filter of the `stage` of the
+ * cascade (see plan_resampler_stages()).
+ *
+ * @details The filter is the windowed sinc which passes the band up to
+ * `stage.passband_edge` and attenuates by `resampler_stage_attenuation` the
+ * bands which are either aliased into the passband by the decimation, or are
+ * the images of the passband produced by the interpolation. The length of the
+ * filter and the shape factor of the Kaiser window are estimated by the
+ * Kaiser's formulas, so no search is needed. The filter of the decimation
+ * by 2 is the half-band one, i.e. each other coefficient of it is zero.
+ */
+inline std::vector<double> design_stage_filter(const Resampler_stage& stage)
+{
+  const auto up = stage.up_factor;
+  const auto down = stage.down_factor;
+  const auto p = stage.passband_edge;
+  const auto s = 2. / std::max(up, down) - p; // the stopband edge
+  PANDA_TIMESWIPE_ASSERT(up > 0 && down > 0);
+  PANDA_TIMESWIPE_ASSERT(0 < p && p < s);
+  constexpr auto a = resampler_stage_attenuation;
+  const double beta{.1102 * (a - 8.7)};
+  const bool is_half_band{up == 1 && down == 2};
+  auto length = static_cast<int>(std::ceil((a - 8) / (2.285 * M_PI * (s - p)))) + 1;
+  if (is_half_band)
+    length += (3 - length % 4 + 4) % 4; // 4k + 3, so the end ones are nonzero
+  else
+    length |= 1;
+
+  const auto cutoff = (p + s) / 2;
+  const auto window = kaiser(length, beta);
+  const int middle{(length - 1) / 2};
+  std::vector<double> result(length);
+  for (int i{}; i < length; ++i) {
+    const auto n = i - middle;
+    result[i] = is_half_band && n && !(n % 2) ? 0 :
+      cutoff * sinc(cutoff * n) * window[i];
+  }
+
+  // Normalize the gain to the up factor (to compensate the zero insertion).
+  const auto sum = std::accumulate(cbegin(result), cend(result), .0);
+  for (auto& c : result)
+    c *= up / sum;
+  return result;
+}
+
 /**
  * @brief A resampler.
  *
@@ -337,8 +482,18 @@ private:
  * in order to resample and flush the extrapolated (extra) sequence of length of
  * one polyphase of filter.
  *
+ * If Resampler_options::is_multistage_enabled() the resampling is done by the
+ * cascade of stages (see plan_resampler_stages()), each of which is the set of
+ * instances of Fir_resampler (one per channel) fed by the output of the
+ * previous stage. The stream-style API remains the same.
+ *
+ * If the channel count is interleaved_lane_count<T> (i.e. the channels fit
+ * into the vector register), each stage is the single instance of
+ * Interleaved_fir_resampler instead, which resamples all the channels in one
+ * pass. The result is the same up to the rounding.
+ *
  * @remarks Both excess leading and excess trailing samples (which are actually
- * artifacts of the resampling) will be cropped automatically.
+ * artifacts of the resampling) will be cropped automatically (by each stage).
  *
  * @see apply(), flush(), Fir_resampler.
  */
@@ -351,7 +506,387 @@ public:
   /// The constructor.
   Resampler(Options options)
     : options_{std::move(options)}
-    , rstates_(options_.channel_count())
+  {
+    const auto stages = plan_resampler_stages(options_);
+    PANDA_TIMESWIPE_ASSERT(!stages.empty());
+
+    // Get the FIR coefficients of the stages from the cache or design them.
+    const auto firc = Fir_cache::instance().get(cache_key(options_), [&]
+    {
+      Fir_cache::Coefficients result;
+      if (stages.size() == 1)
+        result.push_back(firls_kaiser());
+      else {
+        std::clog << "Using " << stages.size() << " resampling stages\n";
+        for (const auto& stage : stages) {
+          std::clog << "Calculating FIR coefficients of stage " << stage.up_factor
+                    << "/" << stage.down_factor << "...";
+          result.push_back(design_stage_filter(stage));
+          std::clog << result.back().size() << " coefficients will be used\n";
+        }
+      }
+      return result;
+    });
+    PANDA_TIMESWIPE_ASSERT(firc->size() == stages.size());
+
+    // Initialize the stages.
+    stages_.resize(stages.size());
+    for (std::size_t i{}; i < stages.size(); ++i) {
+      auto& stage = stages_[i];
+      if (!is_interleaved())
+        stage.rstates.resize(options_.channel_count());
+      if (i + 1 < stages.size())
+        stage.output = Table<T>(options_.channel_count());
+      init_stage(stage, stages[i], (*firc)[i]);
+    }
+
+    PANDA_TIMESWIPE_ASSERT(is_invariant_ok());
+  }
+
+  /// @returns The options instance.
+  const Options& options() const noexcept
+  {
+    return options_;
+  }
+
+  /**
+   * @returns `true` if the channels are resampled together by the instances
+   * of Interleaved_fir_resampler.
+   */
+  bool is_interleaved() const noexcept
+  {
+    return options_.channel_count() == lane_count;
+  }
+
+  /// @returns The number of stages of the resampling.
+  std::size_t stage_count() const noexcept
+  {
+    return stages_.size();
+  }
+
+  /**
+   * @returns The total number of filter coefficients (multiply-accumulates)
+   * used per output sample of one channel.
+   */
+  double coefs_per_output() const noexcept
+  {
+    double result{};
+    double rate{1}; // output samples of the stage per output sample of cascade
+    for (auto i = stages_.size(); i--;) {
+      result += rate * coefs_per_phase(stages_[i]);
+      rate *= static_cast<double>(stages_[i].down_factor) / stages_[i].up_factor;
+    }
+    return result;
+  }
+
+  /**
+   * @brief Reserves the storage of the intermediate stages for the input of
+   * up to `row_count` rows, so apply() doesn't allocate memory for them.
+   */
+  void reserve_rows(const std::size_t row_count)
+  {
+    auto size = row_count;
+    for (auto& stage : stages_) {
+      size = (size * stage.up_factor + stage.down_factor - 1) / stage.down_factor + 1;
+      if (&stage != &stages_.back())
+        stage.output.reserve_rows(size);
+    }
+  }
+
+  /**
+   * @brief Resamples the given table.
+   *
+   * @returns The resampled table.
+   */
+  Table<T> apply(const Table<T>& table)
+  {
+    Table<T> result;
+    apply(table, result);
+    return result;
+  }
+
+  /**
+   * @brief Resamples the given table and appends the result to the `result`.
+   *
+   * @details The storage of the columns of `result` is reused, so no memory
+   * is allocated as long as it's enough to hold the resampled table.
+   *
+   * @par Requires
+   * `(&table != &result) &&
+   *  (!result.column_count() || result.column_count() == table.column_count())`.
+   */
+  void apply(const Table<T>& table, Table<T>& result)
+  {
+    PANDA_TIMESWIPE_TRACE_SCOPE("resample");
+    const auto column_count = options_.channel_count();
+    if (table.column_count() != column_count)
+      throw Exception{std::string{"cannot resample table with "}
+        .append("illegal column count (")
+        .append(std::to_string(table.column_count()))
+        .append(" instead of ")
+        .append(std::to_string(column_count))
+        .append(")")};
+    PANDA_TIMESWIPE_ASSERT(&table != &result);
+
+    if (!result.column_count())
+      result = Table<T>(column_count);
+    else if (result.column_count() != column_count)
+      throw Exception{"cannot append resampled table to table with different "
+        "column count"};
+
+    // Pass the table through the stages.
+    const auto* input = &table;
+    for (auto& stage : stages_) {
+      const bool is_last{&stage == &stages_.back()};
+      auto& output = is_last ? result : stage.output;
+      if (!is_last)
+        output.clear_rows();
+      apply_stage(stage, *input, output);
+      input = &output;
+    }
+  }
+
+  /**
+   * @brief Resamples the extrapolated sequence.
+   *
+   * @returns The resampled table.
+   *
+   * @remarks Normally, this method should be called after the resampling of
+   * the last chunk of data.
+   */
+  Table<T> flush()
+  {
+    /*
+     * Flush the stages one by one, so the extra sequence of each stage is
+     * passed through the stages which follow it (by using their outputs as
+     * apply() does) before they're flushed.
+     */
+    Table<T> result(options_.channel_count());
+    for (std::size_t i{}; i < stages_.size(); ++i) {
+      const auto extra = flush_stage(stages_[i]);
+      if (i + 1 == stages_.size()) {
+        result.append_rows(extra);
+        break;
+      }
+
+      const auto* input = &extra;
+      for (auto j = i + 1; j < stages_.size(); ++j) {
+        auto& stage = stages_[j];
+        const bool is_last{j + 1 == stages_.size()};
+        auto& output = is_last ? result : stage.output;
+        if (!is_last)
+          output.clear_rows();
+        apply_stage(stage, *input, output);
+        input = &output;
+      }
+    }
+    return result;
+  }
+
+private:
+  static constexpr std::size_t lane_count{interleaved_lane_count<T>};
+  using R = Fir_resampler<T>;
+  using Ir = Interleaved_fir_resampler<T, lane_count>;
+  Options options_;
+  template<class Rs>
+  struct Basic_state final {
+    Basic_state() = default;
+
+    template<class U>
+    explicit Basic_state(const Resampler_stage& stage, const Options& options,
+      const std::vector<U>& firc)
+      : resampler{stage.up_factor, stage.down_factor,
+                  cbegin(firc), cend(firc), options.extrapolation()}
+      , unskipped_leading_count{options.crop_extra() ?
+                                leading_skip_count(resampler) : 0}
+    {}
+
+    Rs resampler;
+    std::size_t unskipped_leading_count{};
+  };
+  using State = Basic_state<R>;
+  using Interleaved_state = Basic_state<Ir>;
+  struct Stage final {
+    int up_factor{1};
+    int down_factor{1};
+    std::vector<State> rstates; // one per channel (unless interleaved)
+    std::optional<Interleaved_state> istate; // of all the channels (if interleaved)
+    Table<T> output; // of the stage which isn't the last one
+  };
+  std::vector<Stage> stages_;
+
+  bool is_invariant_ok() const
+  {
+    return !stages_.empty() && std::all_of(cbegin(stages_), cend(stages_),
+      [this](const auto& stage)
+      {
+        return is_interleaved() ? stage.istate && stage.rstates.empty() :
+          !stage.istate && options_.channel_count() == stage.rstates.size();
+      });
+  }
+
+  /// @returns The number of coefficients per phase of the filter of the `stage`.
+  static int coefs_per_phase(const Stage& stage) noexcept
+  {
+    return stage.istate ? stage.istate->resampler.coefs_per_phase() :
+      stage.rstates.front().resampler.coefs_per_phase();
+  }
+
+  /**
+   * @returns The key of the FIR coefficients designed by the `options` in
+   * Fir_cache.
+   *
+   * @remarks Only the options which affect the design are the part of the key.
+   */
+  static std::string cache_key(const Options& options)
+  {
+    std::string result{"resampler-v1"};
+    const auto append = [&result](const auto value)
+    {
+      result.append(reinterpret_cast<const char*>(&value), sizeof(value));
+    };
+    append(options.up_factor());
+    append(options.down_factor());
+    append(options.is_multistage_enabled());
+    append(resampler_stage_passband_ratio);
+    append(resampler_stage_attenuation);
+    append(options.filter_length());
+    append(options.freq().size());
+    for (const auto f : options.freq())
+      append(f);
+    for (const auto a : options.ampl())
+      append(a);
+    return result;
+  }
+
+  /// Initializes the resamplers of the `stage` by the coefficients `firc`.
+  void init_stage(Stage& stage, const Resampler_stage& plan,
+    const std::vector<double>& firc)
+  {
+    stage.up_factor = plan.up_factor;
+    stage.down_factor = plan.down_factor;
+    if (is_interleaved())
+      stage.istate.emplace(plan, options_, firc);
+    else
+      for (auto& rs : stage.rstates)
+        rs = State{plan, options_, firc};
+  }
+
+  /// Resamples the `table` by the `stage` and appends the result to `result`.
+  static void apply_stage(Stage& stage, const Table<T>& table, Table<T>& result)
+  {
+    const auto input_size = table.row_count();
+    if (!input_size)
+      return; // short-circuit
+    else if (stage.istate)
+      return apply_interleaved_stage(*stage.istate, table, result);
+
+    // All the channels are resampled by the same options, so are the sizes.
+    auto& rstates = stage.rstates;
+    const auto& rstate0 = rstates.front();
+    const auto output_size = rstate0.resampler.output_sequence_size(input_size);
+    const auto skip_count = std::min<std::size_t>(rstate0.unskipped_leading_count,
+      output_size);
+    const auto offset = result.row_count();
+    result.append_generated_rows(output_size, [&](const auto column_index, T* const out)
+    {
+      auto& rstate = rstates[column_index];
+      auto& resampler = rstate.resampler;
+      const auto& input = table.column(column_index);
+      PANDA_TIMESWIPE_ASSERT(resampler.output_sequence_size(input_size) == output_size);
+
+      // Apply the filter.
+      const auto e = resampler.apply(cbegin(input), cend(input), out);
+      PANDA_TIMESWIPE_ASSERT(static_cast<std::size_t>(e - out) == output_size);
+      PANDA_TIMESWIPE_ASSERT(rstate.unskipped_leading_count >= skip_count);
+      rstate.unskipped_leading_count -= skip_count;
+    });
+    result.remove_rows(offset, skip_count);
+  }
+
+  /**
+   * @brief Resamples the `table` by the interleaved resampler of the stage
+   * and appends the result to `result`.
+   */
+  static void apply_interleaved_stage(Interleaved_state& istate,
+    const Table<T>& table, Table<T>& result)
+  {
+    auto& resampler = istate.resampler;
+    std::array<const T*, lane_count> in;
+    for (std::size_t i{}; i < lane_count; ++i)
+      in[i] = table.column(i).data();
+
+    /*
+     * The columns are appended one by one, so the resampling is done when the
+     * pointer to the output of the last column is known.
+     */
+    const auto input_size = table.row_count();
+    const auto output_size = resampler.output_sequence_size(input_size);
+    const auto skip_count = std::min<std::size_t>(istate.unskipped_leading_count,
+      output_size);
+    const auto offset = result.row_count();
+    std::array<T*, lane_count> out;
+    result.append_generated_rows(output_size, [&](const auto column_index, T* const o)
+    {
+      out[column_index] = o;
+      if (column_index + 1 == lane_count) {
+        [[maybe_unused]] const auto size = resampler.apply(in, input_size, out);
+        PANDA_TIMESWIPE_ASSERT(size == output_size);
+      }
+    });
+    istate.unskipped_leading_count -= skip_count;
+    result.remove_rows(offset, skip_count);
+  }
+
+  /// @returns The resampled extrapolated sequence of the `stage`.
+  Table<T> flush_stage(Stage& stage)
+  {
+    if (stage.istate) {
+      auto& resampler = stage.istate->resampler;
+      Table<T> result(lane_count);
+      if (!resampler.is_applied())
+        return result; // short-circuit
+
+      // Flush the end samples.
+      const auto size = resampler.output_sequence_size(resampler.coefs_per_phase() - 1);
+      std::array<T*, lane_count> out;
+      result.append_generated_rows(size, [&](const auto column_index, T* const o)
+      {
+        out[column_index] = o;
+        if (column_index + 1 == lane_count)
+          resampler.flush(out);
+      });
+      if (options_.crop_extra()) {
+        const auto skip_count = trailing_skip_count(resampler);
+        PANDA_TIMESWIPE_ASSERT(skip_count < size);
+        result.remove_end_rows(skip_count);
+      }
+      return result;
+    }
+
+    return resample(stage, [this, &stage](const std::size_t column_index)
+    {
+      auto& rstate = stage.rstates[column_index];
+      auto& resampler = rstate.resampler;
+      if (!resampler.is_applied())
+        return typename Table<T>::Column{}; // short-circuit
+
+      // Flush the end samples.
+      auto result = make_zero_result(resampler, resampler.coefs_per_phase() - 1);
+      if (options_.crop_extra()) {
+        const auto skip_count = trailing_skip_count(resampler);
+        PANDA_TIMESWIPE_ASSERT(skip_count < result.size());
+        resampler.flush(begin(result));
+        result.resize(result.size() - skip_count);
+      } else
+        resampler.flush(begin(result));
+
+      return result;
+    });
+  }
+
+  /// @returns The coefficients designed by firls() and the Kaiser window.
+  std::vector<double> firls_kaiser() const
   {
     // Calculate FIR coefficients.
     const auto firc = [this]
@@ -428,120 +963,13 @@ public:
       return result;
     }();
     // print_firc(firc);
-
-    // Initializing the underlying resamplers and the associated states.
-    for (auto& rs : rstates_)
-      rs = State{options_, firc};
-
-    PANDA_TIMESWIPE_ASSERT(is_invariant_ok());
-  }
-
-  /// @returns The options instance.
-  const Options& options() const noexcept
-  {
-    return options_;
-  }
-
-  /**
-   * @brief Resamples the given table.
-   *
-   * @returns The resampled table.
-   */
-  Table<T> apply(const Table<T>& table)
-  {
-    if (table.column_count() != rstates_.size())
-      throw Exception{std::string{"cannot resample table with "}
-        .append("illegal column count (")
-        .append(std::to_string(table.column_count()))
-        .append(" instead of ")
-        .append(std::to_string(rstates_.size()))
-        .append(")")};
-
-    return resample([this, &table](const std::size_t column_index)
-    {
-      auto& rstate = rstates_[column_index];
-      auto& resampler = rstate.resampler;
-      auto& input = table.column(column_index);
-      const auto input_size = input.size();
-      if (!input_size)
-        return typename Table<T>::Column{}; // short-circuit
-
-      // Apply the filter.
-      auto result = make_zero_result(resampler, input_size);
-      const auto out = resampler.apply(cbegin(input), cend(input), begin(result));
-      using Sz = decltype(result.size());
-      PANDA_TIMESWIPE_ASSERT(result.size() == static_cast<Sz>(std::distance(begin(result), out)));
-      if (rstate.unskipped_leading_count) {
-        PANDA_TIMESWIPE_ASSERT(options_.crop_extra());
-        const auto b = cbegin(result);
-        const auto skip_count = std::min<std::size_t>(rstate.unskipped_leading_count, result.size());
-        result.erase(b, b + skip_count);
-        rstate.unskipped_leading_count -= skip_count;
-      }
-
-      return result;
-    });
-  }
-
-  /**
-   * @brief Resamples the extrapolated sequence.
-   *
-   * @returns The resampled table.
-   *
-   * @remarks Normally, this method should be called after the resampling of
-   * the last chunk of data.
-   */
-  Table<T> flush()
-  {
-    return resample([this](const std::size_t column_index)
-    {
-      auto& rstate = rstates_[column_index];
-      auto& resampler = rstate.resampler;
-      if (!resampler.is_applied())
-        return typename Table<T>::Column{}; // short-circuit
-
-      // Flush the end samples.
-      auto result = make_zero_result(resampler, resampler.coefs_per_phase() - 1);
-      if (options_.crop_extra()) {
-        const auto skip_count = trailing_skip_count(resampler);
-        PANDA_TIMESWIPE_ASSERT(skip_count < result.size());
-        resampler.flush(begin(result));
-        result.resize(result.size() - skip_count);
-      } else
-        resampler.flush(begin(result));
-
-      return result;
-    });
-  }
-
-private:
-  using R = Fir_resampler<T>;
-  Options options_;
-  struct State final {
-    State() = default;
-
-    template<class U>
-    explicit State(const Options& options, const std::vector<U>& firc)
-      : resampler{options.up_factor(), options.down_factor(),
-                  cbegin(firc), cend(firc), options.extrapolation()}
-      , unskipped_leading_count{options.crop_extra() ?
-                                leading_skip_count(resampler) : 0}
-    {}
-
-    R resampler;
-    std::size_t unskipped_leading_count{};
-  };
-  std::vector<State> rstates_;
-
-  bool is_invariant_ok() const
-  {
-    return !rstates_.empty() && (options_.channel_count() == rstates_.size());
+    return firc;
   }
 
   template<typename F>
-  Table<T> resample(const F& make_resampled)
+  static Table<T> resample(const Stage& stage, const F& make_resampled)
   {
-    const auto column_count = rstates_.size();
+    const auto column_count = stage.rstates.size();
     Table<T> result;
     result.reserve_columns(column_count);
     for (std::decay_t<decltype(column_count)> i{}; i < column_count; ++i)
@@ -556,12 +984,14 @@ private:
     return typename Table<T>::Column(result_size);
   }
 
-  static std::size_t leading_skip_count(const R& resampler) noexcept
+  template<class Rs>
+  static std::size_t leading_skip_count(const Rs& resampler) noexcept
   {
     return resampler.output_sequence_size(resampler.coefs_per_phase() - 1) / 2;
   }
 
-  static std::size_t trailing_skip_count(const R& resampler) noexcept
+  template<class Rs>
+  static std::size_t trailing_skip_count(const Rs& resampler) noexcept
   {
     const auto sz = resampler.output_sequence_size(resampler.coefs_per_phase() - 1);
     return (sz + sz % 2) / 2;
@@ -0,0 +1,189 @@
+// -*- C++ -*-
+
+// PANDA Timeswipe Project
+// Copyright (C) 2021  PANDA GmbH / Dmitry Igrishin
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef PANDA_TIMESWIPE_RING_HPP
+#define PANDA_TIMESWIPE_RING_HPP
+
+#include "debug.hpp"
+#include "exceptions.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <vector>
+
+namespace panda::timeswipe::detail {
+
+/**
+ * @brief A lock-free ring buffer of fixed capacity for exactly one producer
+ * thread and exactly one consumer thread.
+ *
+ * @details The storage is allocated upon construction or reset() only. The
+ * elements are written and read by blocks, so the synchronization cost is
+ * paid per block rather than per element.
+ */
+template<typename T>
+class Spsc_ring final {
+  static_assert(std::is_trivially_copyable_v<T>);
+public:
+  /// An alias of the value type.
+  using Value = T;
+
+  /// An alias of the size type.
+  using Size = std::size_t;
+
+  /**
+   * @brief The constructor.
+   *
+   * @par Requires
+   * `capacity > 0`.
+   */
+  explicit Spsc_ring(const Size capacity)
+  {
+    reset(capacity);
+  }
+
+  /**
+   * @brief Replaces the storage of the ring with the storage of the given
+   * `capacity` and discards all the elements.
+   *
+   * @par Requires
+   * `capacity > 0`. Neither write() nor read() is in progress.
+   *
+   * @par Effects
+   * `(capacity() == capacity && !size() && !max_size())`.
+   *
+   * @par Exception safety guarantee
+   * Strong.
+   */
+  void reset(const Size capacity)
+  {
+    if (!capacity)
+      throw Exception{"cannot create ring buffer of zero capacity"};
+
+    if (capacity != storage_.size()) {
+      std::vector<Value> storage(capacity);
+      storage_.swap(storage);
+    }
+    head_.store(0, std::memory_order_relaxed);
+    tail_.store(0, std::memory_order_relaxed);
+    max_size_.store(0, std::memory_order_release);
+  }
+
+  /// @returns The maximum number of elements the ring can hold.
+  Size capacity() const noexcept
+  {
+    return storage_.size();
+  }
+
+  /**
+   * @returns The number of elements available for reading.
+   *
+   * @remarks The result is exact only if neither write() nor read() is in
+   * progress.
+   */
+  Size size() const noexcept
+  {
+    const auto tail = tail_.load(std::memory_order_acquire);
+    return head_.load(std::memory_order_acquire) - tail;
+  }
+
+  /**
+   * @returns The maximum number of elements the ring held since the
+   * construction or the last reset() (the high-water mark).
+   */
+  Size max_size() const noexcept
+  {
+    return max_size_.load(std::memory_order_relaxed);
+  }
+
+  /**
+   * @brief Writes either all the `count` elements starting from `data`
+   * or nothing.
+   *
+   * @returns `true` if the elements are written, or `false` if there is not
+   * enough free space in the ring.
+   *
+   * @remarks Must be called by the producer thread only.
+   */
+  bool write(const Value* const data, const Size count) noexcept
+  {
+    const auto head = head_.load(std::memory_order_relaxed);
+    const auto tail = tail_.load(std::memory_order_acquire);
+    if (capacity() - (head - tail) < count)
+      return false;
+
+    const auto offset = static_cast<Size>(head % capacity());
+    const auto first = std::min(count, capacity() - offset);
+    std::copy(data, data + first, storage_.data() + offset);
+    std::copy(data + first, data + count, storage_.data());
+    head_.store(head + count, std::memory_order_release);
+    const auto size = static_cast<Size>(head + count - tail);
+    if (size > max_size_.load(std::memory_order_relaxed))
+      max_size_.store(size, std::memory_order_relaxed);
+    return true;
+  }
+
+  /**
+   * @brief Reads no more than `count` elements into `out`.
+   *
+   * @returns The number of elements read.
+   *
+   * @remarks Must be called by the consumer thread only.
+   */
+  Size read(Value* const out, const Size count) noexcept
+  {
+    const auto tail = tail_.load(std::memory_order_relaxed);
+    const auto head = head_.load(std::memory_order_acquire);
+    const auto result = static_cast<Size>(std::min<std::uint64_t>(head - tail, count));
+
+    const auto offset = static_cast<Size>(tail % capacity());
+    const auto first = std::min(result, capacity() - offset);
+    const auto* const data = storage_.data();
+    std::copy(data + offset, data + offset + first, out);
+    std::copy(data, data + (result - first), out + first);
+    tail_.store(tail + result, std::memory_order_release);
+    return result;
+  }
+
+  /**
+   * @brief Discards all the elements.
+   *
+   * @par Requires
+   * Neither write() nor read() is in progress.
+   */
+  void clear() noexcept
+  {
+    tail_.store(head_.load(std::memory_order_acquire), std::memory_order_release);
+  }
+
+private:
+  // Keep the indexes in distinct cache lines to avoid false sharing.
+  static constexpr std::size_t cache_line_size{64};
+
+  std::vector<Value> storage_;
+  alignas(cache_line_size) std::atomic<std::uint64_t> head_{}; // written count
+  alignas(cache_line_size) std::atomic<std::uint64_t> tail_{}; // read count
+  std::atomic<Size> max_size_{}; // written by the producer only
+};
+
+} // namespace panda::timeswipe::detail
+
+#endif  // PANDA_TIMESWIPE_RING_HPP
@@ -149,6 +149,30 @@ public:
       columns_[i].push_back(make_value(i));
   }
 
+  /**
+   * @brief Appends `count` rows filled by using `fill_column`.
+   *
+   * @param fill_column Function with parameters "current column index" of
+   * type Size and "output" of type `Value*` which must write `count` values
+   * into the output. This function will be called column_count() times.
+   *
+   * @par Effects
+   * row_count() increased by `count`.
+   *
+   * @par Exception safety guarantee
+   * Basic.
+   */
+  template<typename F>
+  void append_generated_rows(const Size count, const F& fill_column)
+  {
+    const Size cc = column_count();
+    const Size offset = row_count();
+    for (Size i{}; i < cc; ++i) {
+      columns_[i].resize(offset + count);
+      fill_column(i, columns_[i].data() + offset);
+    }
+  }
+
   /**
    * @brief Appends no more than `count` rows of `other` to the end of this
    * table.
@@ -264,6 +288,24 @@ public:
       columns_[i].erase(columns_[i].begin(), columns_[i].begin() + count);
   }
 
+  /**
+   * @brief Removes `std::min(row_count() - offset, count))` rows starting
+   * from the row at the given `offset`.
+   *
+   * @remarks Nothing is removed if `(offset >= row_count())`.
+   */
+  void remove_rows(Size offset, Size count) noexcept
+  {
+    const Size cc = column_count();
+    const Size rc = row_count();
+    offset = std::min(rc, offset);
+    count = std::min(rc - offset, count);
+    for (Size i{}; i < cc; ++i) {
+      const auto b = columns_[i].begin() + offset;
+      columns_[i].erase(b, b + count);
+    }
+  }
+
   /// Removes `std::min(row_count(), count))` rows from the end of this table.
   void remove_end_rows(Size count) noexcept
   {
@@ -0,0 +1,173 @@
+// -*- C++ -*-
+
+// PANDA Timeswipe Project
+// Copyright (C) 2021  PANDA GmbH / Dmitry Igrishin
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef PANDA_TIMESWIPE_TABLE_POOL_HPP
+#define PANDA_TIMESWIPE_TABLE_POOL_HPP
+
+#include "table.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace panda::timeswipe::detail {
+
+/**
+ * @brief A thread-safe pool of preallocated tables.
+ *
+ * @details The tables are recycled rather than destroyed, so the storage of
+ * their columns (which is never shrunk) is reused by subsequent acquire().
+ */
+template<typename T>
+class Table_pool final {
+public:
+  /// An alias of the table type.
+  using Table = timeswipe::Table<T>;
+
+  /// An alias of the size type.
+  using Size = typename Table::Size;
+
+  /// Constructs the empty pool.
+  Table_pool() = default;
+
+  /**
+   * @brief Constructs the pool of `table_count` tables of `column_count`
+   * columns with room for `row_count` rows in each.
+   *
+   * @par Effects
+   * `(allocation_count() == table_count)`.
+   *
+   * @see reset().
+   */
+  Table_pool(const Size table_count, const Size column_count, const Size row_count)
+  {
+    reset(table_count, column_count, row_count);
+  }
+
+  /// Non copy-constructible.
+  Table_pool(const Table_pool&) = delete;
+
+  /// Non copy-assignable.
+  Table_pool& operator=(const Table_pool&) = delete;
+
+  /**
+   * @brief Replaces the tables of the pool with `table_count` tables of
+   * `column_count` columns with room for `row_count` rows in each.
+   *
+   * @par Effects
+   * allocation_count() increased by `table_count`.
+   *
+   * @par Exception safety guarantee
+   * Strong.
+   */
+  void reset(const Size table_count, const Size column_count, const Size row_count)
+  {
+    std::vector<Table> tables;
+    tables.reserve(table_count);
+    for (Size i{}; i < table_count; ++i) {
+      Table table(column_count);
+      table.reserve_rows(row_count);
+      tables.push_back(std::move(table));
+    }
+
+    const std::lock_guard lock{mutex_};
+    free_.swap(tables);
+    table_count_ = table_count;
+    column_count_ = column_count;
+    row_count_ = row_count;
+    allocation_count_.fetch_add(table_count, std::memory_order_relaxed);
+  }
+
+  /**
+   * @returns The table without rows from the pool, or a new one if the pool
+   * is exhausted.
+   *
+   * @par Effects
+   * allocation_count() increased by one if the pool is exhausted.
+   */
+  Table acquire()
+  {
+    Size column_count{}, row_count{};
+    {
+      const std::lock_guard lock{mutex_};
+      if (!free_.empty()) {
+        auto result = std::move(free_.back());
+        free_.pop_back();
+        return result;
+      }
+      column_count = column_count_;
+      row_count = row_count_;
+    }
+
+    Table result(column_count);
+    result.reserve_rows(row_count);
+    allocation_count_.fetch_add(1, std::memory_order_relaxed);
+    return result;
+  }
+
+  /**
+   * @brief Returns the `table` to the pool.
+   *
+   * @details The table is destroyed if it's not of the pool's column count,
+   * or if the pool is full.
+   */
+  void release(Table&& table) noexcept
+  {
+    table.clear_rows();
+    const std::lock_guard lock{mutex_};
+    if (table.column_count() == column_count_ && free_.size() < table_count_)
+      free_.push_back(std::move(table));
+  }
+
+  /**
+   * @brief Touches the storage reserved for the rows of the tables of the
+   * pool, so the subsequent writes to it don't incur page faults.
+   */
+  void prefault()
+  {
+    const std::lock_guard lock{mutex_};
+    for (auto& table : free_) {
+      table.append_generated_rows(row_count_, [this](Size, T* const out)
+      {
+        std::fill(out, out + row_count_, T{});
+      });
+      table.clear_rows();
+    }
+  }
+
+  /// @returns The number of tables allocated by this pool.
+  std::uint64_t allocation_count() const noexcept
+  {
+    return allocation_count_.load(std::memory_order_relaxed);
+  }
+
+private:
+  std::mutex mutex_;
+  std::vector<Table> free_;
+  Size table_count_{};
+  Size column_count_{};
+  Size row_count_{};
+  std::atomic<std::uint64_t> allocation_count_{};
+};
+
+} // namespace panda::timeswipe::detail
+
+#endif  // PANDA_TIMESWIPE_TABLE_POOL_HPP
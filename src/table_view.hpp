@@ -0,0 +1,199 @@
+// -*- C++ -*-
+
+// PANDA Timeswipe Project
+// Copyright (C) 2021  PANDA GmbH / Dmitry Igrishin
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef PANDA_TIMESWIPE_TABLE_VIEW_HPP
+#define PANDA_TIMESWIPE_TABLE_VIEW_HPP
+
+#include "exceptions.hpp"
+#include "table.hpp"
+
+#include <cstddef>
+
+namespace panda::timeswipe {
+
+/**
+ * @brief A non-owning read-only view of the table.
+ *
+ * @warning The view is valid only as long as the viewed table isn't modified
+ * or destroyed.
+ */
+template<typename T>
+class Table_view final {
+public:
+  /// Alias of the value type.
+  using Value = T;
+
+  /// Alias of the size type.
+  using Size = std::size_t;
+
+  /// A non-owning read-only view of the column.
+  class Column final {
+  public:
+    /// Constructs the view of empty column.
+    Column() = default;
+
+    /// Constructs the view of `size` values starting from `data`.
+    Column(const Value* const data, const Size size) noexcept
+      : data_{data}
+      , size_{size}
+    {}
+
+    /// @returns The pointer to the first value of the column.
+    const Value* data() const noexcept
+    {
+      return data_;
+    }
+
+    /// @returns The number of values of the column.
+    Size size() const noexcept
+    {
+      return size_;
+    }
+
+    /// @returns `!size()`.
+    bool empty() const noexcept
+    {
+      return !size_;
+    }
+
+    /**
+     * @returns The value at the given `index`.
+     *
+     * @par Requires
+     * `index < size()`.
+     */
+    const Value& operator[](const Size index) const noexcept
+    {
+      return data_[index];
+    }
+
+    /// @returns The iterator to the first value of the column.
+    const Value* begin() const noexcept
+    {
+      return data_;
+    }
+
+    /// @returns The iterator to the past-the-last value of the column.
+    const Value* end() const noexcept
+    {
+      return data_ + size_;
+    }
+
+  private:
+    const Value* data_{};
+    Size size_{};
+  };
+
+  /// Constructs the view of empty table.
+  Table_view() = default;
+
+  /// Constructs the view of the `table`.
+  Table_view(const Table<T>& table) noexcept
+    : table_{&table}
+  {}
+
+  /**
+   * @brief Constructs the view of the column-major data of `column_count`
+   * columns of `row_count` rows, where the column `i` starts from
+   * `data + i * column_stride`.
+   *
+   * @par Requires
+   * `(column_stride >= row_count)`.
+   */
+  Table_view(const Value* const data, const Size column_count,
+    const Size row_count, const Size column_stride) noexcept
+    : data_{data}
+    , column_count_{column_count}
+    , row_count_{row_count}
+    , column_stride_{column_stride}
+  {}
+
+  /// @returns The number of columns of the viewed table.
+  Size column_count() const noexcept
+  {
+    return table_ ? table_->column_count() : column_count_;
+  }
+
+  /// @returns The number of rows of the viewed table.
+  Size row_count() const noexcept
+  {
+    return table_ ? table_->row_count() : row_count_;
+  }
+
+  /**
+   * @returns The view of the column at the given `index`.
+   *
+   * @par Requires
+   * `index` in range `[0, column_count())`.
+   */
+  Column column(const Size index) const
+  {
+    if (!(index < column_count()))
+      throw Exception{"cannot get table view column by invalid index"};
+
+    if (!table_)
+      return {data_ + index * column_stride_, row_count_};
+
+    const auto& column = table_->column(index);
+    return {column.data(), column.size()};
+  }
+
+  /**
+   * @returns The reference to the value of the given `column` and `row`.
+   *
+   * @par Requires
+   * `column` in range `[0, column_count())`.
+   * `row` in range `[0, row_count())`.
+   */
+  const Value& value(const Size column, const Size row) const
+  {
+    if (table_)
+      return table_->value(column, row);
+    else if (!(column < column_count_))
+      throw Exception{"cannot get table view value by invalid column index"};
+    else if (!(row < row_count_))
+      throw Exception{"cannot get table view value by invalid row index"};
+
+    return data_[column * column_stride_ + row];
+  }
+
+  /// @returns The copy of the viewed table.
+  Table<T> to_table() const
+  {
+    if (table_)
+      return *table_;
+
+    Table<T> result;
+    for (Size i{}; i < column_count_; ++i) {
+      const auto* const column = data_ + i * column_stride_;
+      result.append_column(typename Table<T>::Column(column, column + row_count_));
+    }
+    return result;
+  }
+
+private:
+  const Table<T>* table_{};
+  const Value* data_{};
+  Size column_count_{};
+  Size row_count_{};
+  Size column_stride_{};
+};
+
+} // namespace panda::timeswipe
+
+#endif  // PANDA_TIMESWIPE_TABLE_VIEW_HPP
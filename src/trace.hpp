@@ -0,0 +1,308 @@
+// -*- C++ -*-
+
+// PANDA Timeswipe Project
+// Copyright (C) 2021  PANDA GmbH / Dmitry Igrishin
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+/**
+ * @file
+ *
+ * @brief The tracepoints of the data pipeline.
+ *
+ * @details The tracepoints are compiled in only if `PANDA_TIMESWIPE_TRACE` is
+ * defined (see the CMake option of the same name). Otherwise, the macros of
+ * this file expand to nothing, so the tracing costs nothing.
+ */
+
+#ifndef PANDA_TIMESWIPE_TRACE_HPP
+#define PANDA_TIMESWIPE_TRACE_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace panda::timeswipe::detail::trace {
+
+/// The event of the duration of the scope.
+struct Event final {
+  const char* name{}; // must be the string literal
+  std::int64_t begin{}; // ns
+  std::int64_t end{}; // ns
+};
+
+/**
+ * @brief The ring of the events of the thread.
+ *
+ * @details The events are written by the owner thread only, so the writing
+ * is lock-free and wait-free. The oldest events are overwritten when the ring
+ * is full.
+ */
+class Ring final {
+public:
+  /// The maximum number of events the ring can hold.
+  static constexpr std::size_t capacity{1 << 16};
+
+  /// The constructor.
+  Ring(const std::size_t id, std::string thread_name)
+    : id_{id}
+    , thread_name_{std::move(thread_name)}
+    , events_(capacity)
+  {}
+
+  /// @returns The identifier of the thread.
+  std::size_t id() const noexcept
+  {
+    return id_;
+  }
+
+  /// @returns The name of the thread.
+  const std::string& thread_name() const noexcept
+  {
+    return thread_name_;
+  }
+
+  /// Writes the `event`.
+  void write(const Event& event) noexcept
+  {
+    const auto head = head_.load(std::memory_order_relaxed);
+    events_[head % capacity] = event;
+    head_.store(head + 1, std::memory_order_release);
+  }
+
+  /**
+   * @brief Calls `f(event)` for each event of the ring from the oldest to
+   * the newest one.
+   *
+   * @remarks The result is consistent only if the owner thread doesn't write
+   * the events during the call.
+   */
+  template<typename F>
+  void for_each(const F& f) const
+  {
+    const auto head = head_.load(std::memory_order_acquire);
+    const auto count = std::min<std::uint64_t>(head, capacity);
+    for (auto i = head - count; i < head; ++i)
+      f(events_[i % capacity]);
+  }
+
+  /// Discards the events.
+  void clear() noexcept
+  {
+    head_.store(0, std::memory_order_release);
+  }
+
+  /// Marks the ring as the one of the exited thread.
+  void orphan() noexcept
+  {
+    is_orphaned_.store(true, std::memory_order_release);
+  }
+
+  /// @returns `true` if the thread of the ring is exited.
+  bool is_orphaned() const noexcept
+  {
+    return is_orphaned_.load(std::memory_order_acquire);
+  }
+
+private:
+  std::size_t id_{};
+  std::string thread_name_;
+  std::vector<Event> events_;
+  std::atomic<std::uint64_t> head_{};
+  std::atomic_bool is_orphaned_{};
+};
+
+/// The registry of the rings of all the threads.
+class Registry final {
+public:
+  /// @returns The instance.
+  static Registry& instance()
+  {
+    static Registry result;
+    return result;
+  }
+
+  /**
+   * @returns The ring of the calling thread.
+   *
+   * @remarks The registry is locked upon the first call in the thread only.
+   */
+  Ring& ring()
+  {
+    auto& owner = thread_local_ring_owner();
+    if (!owner.ring)
+      owner.ring = make_ring("thread");
+    return *owner.ring;
+  }
+
+  /**
+   * @brief Names the calling thread in the trace.
+   *
+   * @remarks The events of the thread written before the call are kept under
+   * the previous name.
+   */
+  void set_thread_name(std::string name)
+  {
+    auto& owner = thread_local_ring_owner();
+    if (owner.ring)
+      owner.ring->orphan();
+    owner.ring = make_ring(std::move(name));
+  }
+
+  /**
+   * @brief Discards the events of all the threads, and the rings of the
+   * exited threads.
+   */
+  void clear()
+  {
+    const std::lock_guard lock{mutex_};
+    rings_.erase(std::remove_if(rings_.begin(), rings_.end(),
+        [](const auto& ring){ return ring->is_orphaned(); }), rings_.end());
+    for (auto& ring : rings_)
+      ring->clear();
+  }
+
+  /**
+   * @brief Writes the events of all the threads to `out` in the Chrome
+   * trace event format (JSON), which can be opened in Perfetto or
+   * `chrome://tracing`.
+   */
+  void write_chrome_trace(std::ostream& out) const
+  {
+    const std::lock_guard lock{mutex_};
+    out << R"({"displayTimeUnit":"ns","traceEvents":[)";
+    bool is_first{true};
+    const auto separate = [&out, &is_first]
+    {
+      if (!is_first)
+        out << ",\n";
+      is_first = false;
+    };
+    for (const auto& ring : rings_) {
+      separate();
+      out << R"({"name":"thread_name","ph":"M","pid":1,"tid":)" << ring->id()
+          << R"(,"args":{"name":")" << ring->thread_name() << R"("}})";
+      ring->for_each([&](const Event& event)
+      {
+        separate();
+        out << R"({"name":")" << event.name << R"(","ph":"X","pid":1,"tid":)"
+            << ring->id() << R"(,"ts":)" << to_microseconds(event.begin)
+            << R"(,"dur":)" << to_microseconds(event.end - event.begin) << "}";
+      });
+    }
+    out << "]}\n";
+  }
+
+  /// @returns The current time in nanoseconds.
+  static std::int64_t now() noexcept
+  {
+    using std::chrono::steady_clock;
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+      steady_clock::now().time_since_epoch()).count();
+  }
+
+private:
+  struct Ring_owner final {
+    Ring* ring{};
+
+    ~Ring_owner()
+    {
+      if (ring)
+        ring->orphan();
+    }
+  };
+
+  mutable std::mutex mutex_;
+  std::vector<std::unique_ptr<Ring>> rings_;
+  std::size_t next_id_{1};
+
+  Registry() = default;
+
+  Ring_owner& thread_local_ring_owner()
+  {
+    thread_local Ring_owner owner;
+    return owner;
+  }
+
+  Ring* make_ring(std::string thread_name)
+  {
+    const std::lock_guard lock{mutex_};
+    rings_.push_back(std::make_unique<Ring>(next_id_++, std::move(thread_name)));
+    return rings_.back().get();
+  }
+
+  /// @returns The non-negative `ns` in microseconds as decimal string.
+  static std::string to_microseconds(const std::int64_t ns)
+  {
+    const auto fraction = std::to_string(1000 + ns % 1000); // 1xxx
+    return std::to_string(ns / 1000).append(".").append(fraction, 1, 3);
+  }
+};
+
+/// Writes the event of the duration of the scope upon destruction.
+class Scope final {
+public:
+  /// Non copy-constructible.
+  Scope(const Scope&) = delete;
+
+  /// Non copy-assignable.
+  Scope& operator=(const Scope&) = delete;
+
+  /// The constructor.
+  explicit Scope(const char* const name) noexcept
+    : name_{name}
+    , begin_{Registry::now()}
+  {}
+
+  /// The destructor.
+  ~Scope()
+  {
+    Registry::instance().ring().write({name_, begin_, Registry::now()});
+  }
+
+private:
+  const char* name_{};
+  std::int64_t begin_{};
+};
+
+} // namespace panda::timeswipe::detail::trace
+
+#define PANDA_TIMESWIPE_TRACE_CONCAT__(a, b) a ## b
+#define PANDA_TIMESWIPE_TRACE_CONCAT(a, b) PANDA_TIMESWIPE_TRACE_CONCAT__(a, b)
+
+#ifdef PANDA_TIMESWIPE_TRACE
+/**
+ * @brief Traces the duration of the enclosing scope as the event of the
+ * given `name`, which must be the string literal.
+ */
+#define PANDA_TIMESWIPE_TRACE_SCOPE(name)                               \
+  const ::panda::timeswipe::detail::trace::Scope                        \
+  PANDA_TIMESWIPE_TRACE_CONCAT(panda_timeswipe_trace_scope_, __LINE__){name}
+
+/// Names the calling thread in the trace.
+#define PANDA_TIMESWIPE_TRACE_THREAD_NAME(name)                         \
+  ::panda::timeswipe::detail::trace::Registry::instance().set_thread_name(name)
+#else
+#define PANDA_TIMESWIPE_TRACE_SCOPE(name) do {} while (false)
+#define PANDA_TIMESWIPE_TRACE_THREAD_NAME(name) do {} while (false)
+#endif
+
+#endif  // PANDA_TIMESWIPE_TRACE_HPP
@@ -24,14 +24,21 @@ namespace panda::timeswipe {
 
 enum class Errc;
 enum class Measurement_mode;
+enum class Wakeup_policy;
+enum class Overflow_policy;
+enum class Recorder_format;
+enum class Scheduling_policy;
 
 class Exception;
 class Generic_error_category;
 
 class Board_settings;
+class Capture_reader;
 class Driver;
 class Driver_settings;
+class Recorder_options;
 template<typename> class Table;
+template<typename> class Table_view;
 
 /// Implementation details.
 namespace detail {
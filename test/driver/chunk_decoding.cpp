@@ -0,0 +1,61 @@
+// -*- C++ -*-
+/*
+  This Source Code Form is subject to the terms of the Mozilla Public
+  License, v. 2.0. If a copy of the MPL was not distributed with this
+  file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+  Copyright (c) 2021 PANDA GmbH / Dmitry Igrishin
+*/
+
+// Prints the time spent by the chunk decoders in nanoseconds per sample.
+
+#include "../../src/chunk.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <vector>
+
+int main()
+{
+  namespace chrono = std::chrono;
+  using namespace panda::timeswipe::detail;
+
+  // The maximum size of the data set.
+  constexpr std::size_t count{255*32};
+  constexpr int iteration_count{1000};
+
+  std::vector<Chunk> chunks(count);
+  std::mt19937 generator;
+  std::uniform_int_distribution<unsigned> distribution{0, 255};
+  for (auto& chunk : chunks) {
+    for (auto& byte : chunk)
+      byte = static_cast<std::uint8_t>(distribution(generator));
+  }
+
+  std::vector<std::uint16_t> codes(count * max_channel_count);
+  Chunk_code_columns columns;
+  for (std::size_t c{}; c < columns.size(); ++c)
+    columns[c] = codes.data() + c*count;
+
+  std::uint64_t checksum{};
+  const auto measure = [&](const char* const name, const auto& decoder)
+  {
+    const auto start = chrono::steady_clock::now();
+    for (int i{}; i < iteration_count; ++i) {
+      decoder(chunks.data(), count, columns);
+      checksum += codes[i % codes.size()];
+    }
+    const chrono::duration<double, std::nano> elapsed{
+      chrono::steady_clock::now() - start};
+    std::cout << std::setw(10) << std::left << name
+              << std::fixed << std::setprecision(2)
+              << elapsed.count() / (iteration_count * count)
+              << " ns/sample" << std::endl;
+  };
+  measure("reference", decode_chunks_reference);
+  measure("lut", decode_chunks_lut);
+  std::cout << "checksum: " << checksum << std::endl;
+}
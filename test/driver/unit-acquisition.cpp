@@ -0,0 +1,1205 @@
+// -*- C++ -*-
+/*
+  This Source Code Form is subject to the terms of the Mozilla Public
+  License, v. 2.0. If a copy of the MPL was not distributed with this
+  file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+  Copyright (c) 2021 PANDA GmbH / Dmitry Igrishin
+*/
+
+#include "../../src/acquisition.hpp"
+#include "../../src/capture.hpp"
+#include "../../src/debug.hpp"
+#include "../../src/driver.hpp"
+#include "../../src/exceptions.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <limits>
+#include <mutex>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include <sched.h>
+#include <unistd.h>
+
+#define ASSERT PANDA_TIMESWIPE_ASSERT
+
+int main()
+try {
+  namespace ts = panda::timeswipe;
+  using ts::detail::Simulated_acquisition_source;
+
+  // Chunk encoding and decoding.
+  {
+    const ts::detail::Chunk_codes codes{0x0001, 0x8000, 0xa5c3, 0xffff};
+    ASSERT(ts::detail::decode_chunk(ts::detail::encode_chunk(codes)) == codes);
+    for (std::uint64_t i{}; i < 960; ++i) {
+      ts::detail::Chunk_codes expected;
+      for (unsigned c{}; c < expected.size(); ++c)
+        expected[c] = Simulated_acquisition_source::code(c, i);
+      ASSERT(ts::detail::decode_chunk(ts::detail::encode_chunk(expected)) == expected);
+    }
+  }
+
+  // Batch decoding.
+  {
+    constexpr std::size_t count{1000};
+    std::vector<ts::detail::Chunk> chunks(count);
+    std::mt19937 generator;
+    std::uniform_int_distribution<unsigned> distribution{0, 255};
+    for (auto& chunk : chunks) {
+      for (auto& byte : chunk)
+        byte = static_cast<std::uint8_t>(distribution(generator));
+    }
+
+    using Columns = std::array<std::vector<std::uint16_t>, ts::detail::max_channel_count>;
+    const auto decode = [&chunks](const auto& decoder)
+    {
+      Columns result;
+      ts::detail::Chunk_code_columns columns;
+      for (std::size_t c{}; c < result.size(); ++c) {
+        result[c].resize(count);
+        columns[c] = result[c].data();
+      }
+      decoder(chunks.data(), count, columns);
+      return result;
+    };
+    const auto expected = decode(ts::detail::decode_chunks_reference);
+    ASSERT(decode(ts::detail::decode_chunks_lut) == expected);
+    ASSERT(decode(ts::detail::decode_chunks) == expected);
+    for (std::size_t i{}; i < count; ++i) {
+      const auto codes = ts::detail::decode_chunk(chunks[i]);
+      for (std::size_t c{}; c < codes.size(); ++c)
+        ASSERT(expected[c][i] == codes[c]);
+    }
+  }
+
+  // Read pacing.
+  {
+    using ts::detail::Read_pacer;
+    Read_pacer pacer;
+    ASSERT(pacer.interval() == Read_pacer::initial_interval);
+
+    // The interval converges so the data sets are of the target size.
+    constexpr double rate{48}; // chunks per millisecond
+    for (int i{}; i < 100; ++i) {
+      const auto count = static_cast<std::uint64_t>(pacer.interval().count()
+        * rate / 1000 + 1);
+      pacer.update(count, false);
+      ASSERT(Read_pacer::min_interval <= pacer.interval());
+      ASSERT(pacer.interval() <= Read_pacer::max_interval);
+    }
+    const auto count = pacer.interval().count() * rate / 1000;
+    ASSERT(Read_pacer::target_count - 2 <= count && count <= Read_pacer::target_count + 2);
+
+    // The late read shortens the interval, and the early one lengthens it.
+    auto interval = pacer.interval();
+    pacer.update(10*Read_pacer::target_count, false);
+    ASSERT(pacer.interval() < interval);
+    interval = pacer.interval();
+    pacer.update(1, true);
+    ASSERT(pacer.interval() > interval);
+
+    // The interval is bounded.
+    for (int i{}; i < 100; ++i)
+      pacer.update(1, false);
+    ASSERT(pacer.interval() == Read_pacer::max_interval);
+    for (int i{}; i < 100; ++i)
+      pacer.update(Read_pacer::max_interval.count(), false);
+    ASSERT(pacer.interval() == Read_pacer::min_interval);
+    pacer.reset();
+    ASSERT(pacer.interval() == Read_pacer::initial_interval);
+  }
+
+  // Data set framing of the simulated source.
+  {
+    Simulated_acquisition_source source{48000, 0};
+    source.initialize();
+    source.start();
+    source.await_data(ts::detail::Read_pacer::initial_interval);
+    std::uint64_t count{1};
+    while (!source.read_chunk().is_last())
+      count++;
+    ASSERT(count == Simulated_acquisition_source::max_data_set_size);
+    ASSERT(!source.take_lost_count());
+  }
+
+  // Overflow of the RAM of the simulated source.
+  {
+    Simulated_acquisition_source source{48000, 1};
+    source.initialize();
+    source.start();
+    std::this_thread::sleep_for(std::chrono::milliseconds{500});
+    source.await_data(ts::detail::Read_pacer::initial_interval);
+    const auto lost_count = source.take_lost_count();
+    ASSERT(lost_count > 0);
+    ASSERT(!source.take_lost_count());
+    const auto codes = ts::detail::decode_chunk(source.read_chunk().chunk);
+    for (unsigned c{}; c < codes.size(); ++c)
+      ASSERT(codes[c] == Simulated_acquisition_source::code(c, lost_count));
+  }
+
+  // Measurement with the simulated source.
+  ASSERT(!setenv("PANDA_TIMESWIPE_ACQUISITION", "simulation", 1));
+  ASSERT(!setenv("PANDA_TIMESWIPE_ACQUISITION_SPEED", "4", 1));
+  const std::tuple<ts::Wakeup_policy, float, bool> cases[]{
+    {ts::Wakeup_policy::low_latency, 1, false},
+    {ts::Wakeup_policy::low_cpu, 2, false},
+    {ts::Wakeup_policy::low_latency, 2, true}};
+  for (const auto& test_case : cases) {
+    const auto [policy, translation_slope, is_zero_copy] = test_case;
+    auto& driver = ts::Driver::instance().initialize();
+    constexpr std::size_t row_count{4800};
+    std::vector<float> translation_offsets(driver.max_channel_count());
+    for (unsigned c{}; c < translation_offsets.size(); ++c)
+      translation_offsets[c] = (translation_slope - 1) * (c + 1);
+    driver.set_settings(ts::Driver_settings{}.set_sample_rate(48000)
+      .set_burst_buffer_size(row_count).set_wakeup_policy(policy)
+      .set_translation_offsets(translation_offsets)
+      .set_translation_slopes(std::vector<float>(translation_offsets.size(),
+          translation_slope)));
+
+    std::mutex mutex;
+    std::condition_variable done;
+    std::optional<ts::Driver::Data> result;
+    const auto handle = [&](auto&& data)
+    {
+      const std::lock_guard lock{mutex};
+      if (!result) {
+        result = std::forward<decltype(data)>(data);
+        done.notify_one();
+      }
+    };
+    if (is_zero_copy)
+      driver.start_measurement(ts::Driver::zero_copy, [&](const auto& data, const int)
+      {
+        handle(data.to_table());
+      });
+    else
+      driver.start_measurement([&](auto data, const int)
+      {
+        handle(std::move(data));
+      });
+    {
+      std::unique_lock lock{mutex};
+      done.wait(lock, [&result]{ return result.has_value(); });
+    }
+    driver.stop_measurement();
+    ASSERT(!driver.is_measurement_started());
+
+    // Find the index of the first sample (the leading data sets are skipped).
+    const auto& data = *result;
+    ASSERT(data.column_count() == driver.max_channel_count());
+    ASSERT(data.row_count() >= row_count);
+    const auto value = [&translation_offsets, translation_slope = translation_slope]
+      (const unsigned channel, const std::uint64_t index)
+    {
+      const auto mv = static_cast<float>(Simulated_acquisition_source::code(channel, index)
+        - ts::detail::chunk_code_offset);
+      return (mv - translation_offsets[channel]) / translation_slope;
+    };
+    std::optional<std::uint64_t> first;
+    for (std::uint64_t i{}; i < 960 && !first; ++i) {
+      bool matches{true};
+      for (unsigned c{}; c < data.column_count() && matches; ++c) {
+        for (std::size_t r{}; r < 4 && matches; ++r)
+          matches = data.value(c, r) == value(c, i + r);
+      }
+      if (matches)
+        first = i;
+    }
+    ASSERT(first);
+
+    // Check all the samples.
+    for (unsigned c{}; c < data.column_count(); ++c) {
+      for (std::size_t r{}; r < data.row_count(); ++r)
+        ASSERT(data.value(c, r) == value(c, *first + r));
+    }
+  }
+
+  // Measurement with the data loss.
+  {
+    auto& driver = ts::Driver::instance().initialize();
+    driver.set_settings(ts::Driver_settings{}.set_sample_rate(48000)
+      .set_burst_buffer_size(4800)
+      .set_translation_offsets(std::vector<float>(driver.max_channel_count(), 0))
+      .set_translation_slopes(std::vector<float>(driver.max_channel_count(), 1)));
+
+    /*
+     * The handler is stalled on the first call, so the record ring (which
+     * is enough to store the records for 2s at the speed of 1) overflows.
+     */
+    std::mutex mutex;
+    std::condition_variable done;
+    std::vector<std::pair<ts::Driver::Data_info, ts::Driver::Data>> results;
+    bool is_stalled{};
+    std::optional<std::size_t> loss_index;
+    const auto start_time = std::chrono::steady_clock::now();
+    driver.start_measurement([&](auto data, const int error_marker)
+    {
+      if (!is_stalled) {
+        std::this_thread::sleep_for(std::chrono::milliseconds{1000});
+        is_stalled = true;
+      }
+      const auto& info = driver.data_info();
+      ASSERT(info.lost_sample_count == static_cast<std::uint64_t>(error_marker));
+      const std::lock_guard lock{mutex};
+      if (!loss_index || results.size() < *loss_index + 3) {
+        if (!loss_index && info.lost_sample_count)
+          loss_index = results.size();
+        results.emplace_back(info, std::move(data));
+        done.notify_one();
+      }
+    });
+    {
+      std::unique_lock lock{mutex};
+      done.wait(lock, [&]{ return loss_index && results.size() == *loss_index + 3; });
+    }
+    driver.stop_measurement();
+
+    // Check the continuity of the sample indexes and the read times.
+    std::uint64_t lost_count{};
+    for (std::size_t i{}; i < results.size(); ++i) {
+      const auto& [info, data] = results[i];
+      ASSERT(info.sample_count == data.row_count());
+      ASSERT(info.first_read_time <= info.last_read_time);
+      ASSERT(info.read_time(0) == info.first_read_time);
+      ASSERT(info.read_time(info.sample_count - 1) == info.last_read_time);
+      ASSERT(info.read_time(info.sample_count / 2) >= info.first_read_time);
+      ASSERT(info.read_time(info.sample_count / 2) <= info.last_read_time);
+      ASSERT(info.first_read_system_time <= info.last_read_system_time);
+      ASSERT(info.read_system_time(info.sample_count - 1) == info.last_read_system_time);
+      lost_count += info.lost_sample_count;
+      ASSERT(info.total_lost_sample_count == lost_count);
+      if (i) {
+        const auto& prev_info = results[i - 1].first;
+        ASSERT(info.sample_index == prev_info.sample_index + prev_info.sample_count +
+          info.lost_sample_count);
+        ASSERT(info.first_read_time >= prev_info.last_read_time);
+      }
+    }
+    ASSERT(lost_count > 0);
+
+    // The loss and the stalled handler are reflected by the statistics.
+    const auto statistics = driver.statistics();
+    ASSERT(statistics.lost_sample_count >= lost_count);
+    ASSERT(statistics.dropped_batch_count > 0);
+    ASSERT(statistics.handler_overrun_count > 0);
+    ASSERT(statistics.handler_duration.max >= 1000000);
+    ASSERT(statistics.queue_high_water_mark > 0);
+
+    // The records are queued while the handler is stalled.
+    ASSERT(results[1].first.queue_size > 0);
+    ASSERT(results.front().first.first_read_time >= start_time);
+
+    // Check that the samples are at their indexes.
+    const auto& [info0, data0] = results.front();
+    std::optional<std::uint64_t> first;
+    for (std::uint64_t i{}; i < 960 && !first; ++i) {
+      bool matches{true};
+      for (unsigned c{}; c < data0.column_count() && matches; ++c) {
+        for (std::size_t r{}; r < 4 && matches; ++r)
+          matches = data0.value(c, r) == Simulated_acquisition_source::code(c, i + r)
+            - ts::detail::chunk_code_offset;
+      }
+      if (matches)
+        first = i;
+    }
+    ASSERT(first);
+    for (const auto& [info, data] : results) {
+      for (unsigned c{}; c < data.column_count(); ++c) {
+        for (std::size_t r{}; r < data.row_count(); ++r)
+          ASSERT(data.value(c, r) == Simulated_acquisition_source::code(c,
+              *first + info.sample_index + r) - ts::detail::chunk_code_offset);
+      }
+    }
+  }
+
+  // Measurement with the subscribers.
+  {
+    auto& driver = ts::Driver::instance().initialize();
+    driver.set_settings(ts::Driver_settings{}.set_sample_rate(48000)
+      .set_burst_buffer_size(4800)
+      .set_translation_offsets(std::vector<float>(driver.max_channel_count(), 0))
+      .set_translation_slopes(std::vector<float>(driver.max_channel_count(), 1)));
+
+    /*
+     * The handler of measurement and the subscriber of the same rate but of
+     * the lesser burst buffer size must receive the same samples, while the
+     * subscriber of the half rate must receive the half of samples.
+     */
+    struct Result final {
+      std::vector<std::pair<ts::Driver::Data_info, ts::Driver::Data>> bursts;
+      std::size_t sample_count{};
+    };
+    constexpr std::size_t min_sample_count{9600};
+    std::mutex mutex;
+    std::condition_variable done;
+    Result results[3];
+    const auto handle = [&](Result& result, ts::Driver::Data data)
+    {
+      const auto& info = driver.data_info();
+      ASSERT(info.sample_count == data.row_count());
+      const std::lock_guard lock{mutex};
+      if (result.sample_count < min_sample_count) {
+        result.sample_count += data.row_count();
+        result.bursts.emplace_back(info, std::move(data));
+        done.notify_one();
+      }
+    };
+    ASSERT(driver.min_sample_rate() <= 24000);
+    driver.add_subscriber(48000, 1200, ts::Driver::zero_copy,
+      [&](const auto& data, const int)
+      {
+        handle(results[1], data.to_table());
+      });
+    driver.add_subscriber(24000, 2400, [&](auto data, const int)
+    {
+      handle(results[2], std::move(data));
+    });
+    driver.start_measurement([&](auto data, const int)
+    {
+      handle(results[0], std::move(data));
+    });
+    {
+      std::unique_lock lock{mutex};
+      done.wait(lock, [&results]
+      {
+        for (const auto& result : results) {
+          if (result.sample_count < min_sample_count)
+            return false;
+        }
+        return true;
+      });
+    }
+    try {
+      std::ostringstream trace;
+      driver.write_trace(trace); // the threads are writing the trace
+      ASSERT(false);
+    } catch (const ts::Exception&) {}
+    driver.stop_measurement();
+
+    // Check the burst sizes and the continuity of the sample indexes.
+    const std::size_t burst_buffer_sizes[]{4800, 1200, 2400};
+    for (std::size_t i{}; i < std::size(results); ++i) {
+      const auto& bursts = results[i].bursts;
+      ASSERT(!bursts.empty());
+      for (std::size_t j{}; j < bursts.size(); ++j) {
+        const auto& [info, data] = bursts[j];
+        ASSERT(data.column_count() == driver.max_channel_count());
+        ASSERT(data.row_count() >= burst_buffer_sizes[i]);
+        ASSERT(!info.lost_sample_count);
+        ASSERT(info.sample_index == (j ? bursts[j - 1].first.sample_index +
+            bursts[j - 1].first.sample_count : 0));
+      }
+    }
+
+    // Check the statistics.
+    const auto statistics = driver.statistics();
+    for (const auto* const histogram : {&statistics.read_loop_duration,
+        &statistics.read_chunk_count, &statistics.resampling_duration,
+        &statistics.handler_duration}) {
+      ASSERT(histogram->count > 0);
+      std::uint64_t count{};
+      for (std::size_t i{}; i < histogram->bins.size(); ++i) {
+        if (histogram->bins[i])
+          ASSERT(ts::Driver::Histogram::bin_lower_bound(i) <= histogram->max);
+        count += histogram->bins[i];
+      }
+      ASSERT(count == histogram->count);
+      ASSERT(histogram->mean() <= histogram->max);
+    }
+    ASSERT(statistics.read_chunk_count.sum > 0);
+    ASSERT(!statistics.lost_sample_count && !statistics.dropped_batch_count);
+    ASSERT(statistics.queue_capacity == driver.queue_capacity());
+
+    // Check the trace.
+    {
+      std::ostringstream trace;
+      driver.write_trace(trace);
+      const auto text = trace.str();
+      ASSERT(text.find(R"("traceEvents":[)") != std::string::npos);
+#ifdef PANDA_TIMESWIPE_TRACE
+      for (const auto* const name : {"data_reading", "data_processing",
+          "read_chunks", "decode", "resample", "assemble_burst", "handler"})
+        ASSERT(text.find(std::string{'"'}.append(name).append("\"")) != std::string::npos);
+#else
+      ASSERT(text.find(R"("traceEvents":[])") != std::string::npos);
+#endif
+    }
+
+    // Check that the samples of the same rate are the same.
+    const auto value = [](const Result& result, const unsigned channel,
+      std::size_t row)
+    {
+      for (const auto& [info, data] : result.bursts) {
+        if (row < data.row_count())
+          return data.value(channel, row);
+        row -= data.row_count();
+      }
+      ASSERT(false);
+      return 0.f;
+    };
+    for (unsigned c{}; c < driver.max_channel_count(); ++c) {
+      for (std::size_t r{}; r < min_sample_count; ++r)
+        ASSERT(value(results[0], c, r) == value(results[1], c, r));
+    }
+
+    // Check the measurement without the handler.
+    std::size_t sample_count{};
+    driver.remove_subscribers();
+    try {
+      driver.start_measurement();
+      ASSERT(false);
+    } catch (const ts::Exception&) {}
+    driver.add_subscriber(24000, 2400, [&](const auto data, const int)
+    {
+      const std::lock_guard lock{mutex};
+      sample_count += data.row_count();
+      done.notify_one();
+    });
+    driver.start_measurement();
+    {
+      std::unique_lock lock{mutex};
+      done.wait(lock, [&sample_count]{ return sample_count > 0; });
+    }
+    driver.stop_measurement();
+    driver.remove_subscribers();
+  }
+
+  // Measurement with the subscriber of the sample rate less than min_sample_rate().
+  {
+    auto& driver = ts::Driver::instance().initialize();
+    driver.set_settings(ts::Driver_settings{}
+      .set_translation_offsets(std::vector<float>(driver.max_channel_count(), 0))
+      .set_translation_slopes(std::vector<float>(driver.max_channel_count(), 1)));
+    constexpr int sample_rate{10};
+    constexpr std::size_t burst_buffer_size{5};
+    ASSERT(driver.min_subscriber_sample_rate() <= sample_rate &&
+      sample_rate < driver.min_sample_rate());
+    for (const auto& [rate, size] : {std::pair<int, std::size_t>{
+          driver.min_subscriber_sample_rate() - 1, burst_buffer_size}, {sample_rate, 0}}) {
+      try {
+        driver.add_subscriber(rate, size, [](auto, int){});
+        ASSERT(false);
+      } catch (const ts::Exception& e) {
+        ASSERT(e.condition() == ts::Errc::driver_settings_invalid);
+      }
+    }
+
+    std::mutex mutex;
+    std::condition_variable done;
+    std::vector<std::pair<ts::Driver::Data_info, ts::Driver::Data>> bursts;
+    driver.add_subscriber(sample_rate, burst_buffer_size, [&](auto data, const int)
+    {
+      const auto& info = driver.data_info();
+      ASSERT(info.sample_count == data.row_count());
+      const std::lock_guard lock{mutex};
+      if (bursts.size() < 6) { // the last burst flushed on stop may be partial
+        bursts.emplace_back(info, std::move(data));
+        done.notify_one();
+      }
+    });
+    const auto start_time = std::chrono::steady_clock::now();
+    driver.start_measurement();
+    {
+      std::unique_lock lock{mutex};
+      done.wait(lock, [&bursts]{ return bursts.size() >= 6; });
+    }
+    driver.stop_measurement();
+    driver.remove_subscribers();
+
+    /*
+     * The samples can't be read before they are produced by the source. The
+     * burst followed by the loss may be flushed partially, so the size and
+     * the continuity are checked only for the bursts followed by no loss.
+     */
+    const auto speed = std::stod(std::getenv("PANDA_TIMESWIPE_ACQUISITION_SPEED"));
+    std::size_t checked_count{};
+    for (std::size_t i{}; i < bursts.size(); ++i) {
+      const auto& [info, data] = bursts[i];
+      ASSERT(data.column_count() == driver.max_channel_count());
+      const std::chrono::duration<double> duration{info.last_read_time - start_time};
+      ASSERT(duration.count() >= (info.sample_index + info.sample_count - 1) /
+        (sample_rate * speed));
+      if (i + 1 < bursts.size() && !bursts[i + 1].first.lost_sample_count) {
+        ASSERT(data.row_count() == burst_buffer_size);
+        ASSERT(bursts[i + 1].first.sample_index == info.sample_index + info.sample_count);
+        ++checked_count;
+      }
+    }
+    ASSERT(checked_count > 0);
+  }
+
+  // Measurement with the reading.
+  for (const auto policy : {ts::Overflow_policy::block,
+      ts::Overflow_policy::drop_newest}) {
+    auto& driver = ts::Driver::instance().initialize();
+    driver.set_settings(ts::Driver_settings{}.set_sample_rate(48000)
+      .set_burst_buffer_size(2400)
+      .set_read_buffer_size(4800)
+      .set_read_overflow_policy(policy)
+      .set_translation_offsets(std::vector<float>(driver.max_channel_count(), 0))
+      .set_translation_slopes(std::vector<float>(driver.max_channel_count(), 1)));
+    driver.start_measurement(ts::Driver::pull);
+
+    /*
+     * Read the data slower than it's produced, so the read buffer overflows.
+     * Nothing is lost with the blocking policy as long as the record ring
+     * doesn't overflow.
+     */
+    ts::Driver::Data data;
+    for (int i{}; i < 3; ++i) {
+      auto d = driver.read(4800, std::chrono::seconds{10});
+      ASSERT(d.row_count() == 4800);
+      data.append_rows(d);
+      driver.recycle_data(std::move(d));
+      std::this_thread::sleep_for(std::chrono::milliseconds{100});
+    }
+    ASSERT(!driver.read(0, std::chrono::milliseconds{}).row_count());
+    driver.stop_measurement();
+    ASSERT(driver.read(4800, std::chrono::seconds{10}).row_count() <= 4800);
+    const auto lost_count = driver.read_lost_sample_count();
+    if (policy == ts::Overflow_policy::block)
+      ASSERT(!lost_count);
+    else
+      ASSERT(lost_count > 0);
+
+    // Check the samples.
+    std::optional<std::uint64_t> first;
+    for (std::uint64_t i{}; i < 960 && !first; ++i) {
+      bool matches{true};
+      for (unsigned c{}; c < data.column_count() && matches; ++c) {
+        for (std::size_t r{}; r < 4 && matches; ++r)
+          matches = data.value(c, r) == Simulated_acquisition_source::code(c, i + r)
+            - ts::detail::chunk_code_offset;
+      }
+      if (matches)
+        first = i;
+    }
+    ASSERT(first);
+    const auto row_count = policy == ts::Overflow_policy::block ?
+      data.row_count() : 4800;
+    for (unsigned c{}; c < data.column_count(); ++c) {
+      for (std::size_t r{}; r < row_count; ++r)
+        ASSERT(data.value(c, r) == Simulated_acquisition_source::code(c,
+            *first + r) - ts::detail::chunk_code_offset);
+    }
+  }
+
+  // Reading of measurement not started for reading.
+  {
+    auto& driver = ts::Driver::instance().initialize();
+    driver.start_measurement([](auto, int){});
+    driver.stop_measurement();
+    bool is_thrown{};
+    try {
+      driver.read(1, std::chrono::milliseconds{});
+    } catch (const ts::Exception&) {
+      is_thrown = true;
+    }
+    ASSERT(is_thrown);
+  }
+
+  // Measurement with the queue memory budget.
+  {
+    auto& driver = ts::Driver::instance().initialize();
+    constexpr std::size_t budget{48000*8};
+    driver.set_settings(ts::Driver_settings{}.set_sample_rate(48000)
+      .set_burst_buffer_size(4800)
+      .set_read_buffer_size(48000)
+      .set_queue_memory_budget(budget));
+    driver.start_measurement(ts::Driver::pull);
+    const auto data = driver.read(48000, std::chrono::seconds{10});
+    driver.stop_measurement();
+    ASSERT(data.row_count() == 48000);
+    ASSERT(driver.queue_capacity() == budget / 8);
+    ASSERT(driver.queue_high_water_mark() > 0);
+    ASSERT(driver.queue_high_water_mark() <= driver.queue_capacity());
+
+    bool is_thrown{};
+    try {
+      driver.set_settings(ts::Driver_settings{}.set_queue_memory_budget(8));
+      driver.start_measurement(ts::Driver::pull);
+    } catch (const ts::Exception&) {
+      is_thrown = true;
+    }
+    ASSERT(is_thrown);
+    ASSERT(!driver.is_measurement_started());
+    driver.set_settings(ts::Driver_settings{}.set_queue_memory_budget(
+        2*48000*8));
+  }
+
+  // Measurement with the recorder.
+  {
+    auto& driver = ts::Driver::instance().initialize();
+    driver.set_settings(ts::Driver_settings{}
+      .set_translation_offsets(std::vector<float>(driver.max_channel_count(), 0))
+      .set_translation_slopes(std::vector<float>(driver.max_channel_count(), 1)));
+    const auto directory = std::filesystem::temp_directory_path() /
+      ("panda_timeswipe_recorder_" + std::to_string(getpid()));
+    std::filesystem::create_directories(directory);
+    constexpr std::uint64_t file_size{64*1024};
+    constexpr std::size_t buffer_size{4*ts::Recorder_options::block_size};
+    driver.add_recorder(48000, 4800, ts::Recorder_options{
+        (directory / "capture-").string()}
+      .set_file_size(file_size)
+      .set_buffer_size(buffer_size)
+      .set_sync_size(2*buffer_size)
+      .set_direct_io_enabled(true));
+    driver.start_measurement();
+    std::this_thread::sleep_for(std::chrono::milliseconds{500});
+    driver.stop_measurement();
+
+    // The files are rotated by the size.
+    const auto statistics = driver.statistics();
+    driver.remove_subscribers();
+    ASSERT(statistics.recorded_file_count > 1);
+    std::vector<float> values;
+    for (std::uint64_t i{}; i < statistics.recorded_file_count; ++i) {
+      const auto index = std::to_string(i);
+      const auto path = directory / ("capture-" + std::string(6 - index.size(), '0')
+        + index + ".bin");
+      const auto size = std::filesystem::file_size(path);
+      ASSERT(!(size % sizeof(float)));
+      if (i + 1 < statistics.recorded_file_count)
+        ASSERT(file_size <= size && size < file_size + buffer_size);
+      std::ifstream file{path, std::ios_base::binary};
+      const auto offset = values.size();
+      values.resize(offset + size / sizeof(float));
+      ASSERT(file.read(reinterpret_cast<char*>(values.data() + offset), size));
+    }
+    ASSERT(values.size() * sizeof(float) == statistics.recorded_byte_count);
+    std::filesystem::remove_all(directory);
+
+    // Check that the rows are recorded in order.
+    const auto column_count = driver.max_channel_count();
+    ASSERT(!(values.size() % column_count));
+    const auto value = [](const unsigned channel, const std::uint64_t index)
+    {
+      return static_cast<float>(Simulated_acquisition_source::code(channel, index)
+        - ts::detail::chunk_code_offset);
+    };
+    std::optional<std::uint64_t> first;
+    for (std::uint64_t i{}; i < 960 && !first; ++i) {
+      bool matches{true};
+      for (unsigned c{}; c < column_count && matches; ++c) {
+        for (std::size_t r{}; r < 4 && matches; ++r)
+          matches = values[r*column_count + c] == value(c, i + r);
+      }
+      if (matches)
+        first = i;
+    }
+    ASSERT(first);
+    for (std::size_t i{}; i < values.size(); ++i)
+      ASSERT(values[i] == value(i % column_count, *first + i / column_count));
+  }
+
+  // Measurement with the capture recorder.
+  {
+    auto& driver = ts::Driver::instance().initialize();
+    driver.set_settings(ts::Driver_settings{}
+      .set_translation_offsets(std::vector<float>(driver.max_channel_count(), 0))
+      .set_translation_slopes(std::vector<float>(driver.max_channel_count(), 1)));
+    const auto directory = std::filesystem::temp_directory_path() /
+      ("panda_timeswipe_capture_" + std::to_string(getpid()));
+    std::filesystem::create_directories(directory);
+    constexpr std::size_t chunk_row_count{480};
+    driver.add_recorder(48000, 4800, ts::Recorder_options{
+        (directory / "capture-").string()}
+      .set_format(ts::Recorder_format::capture)
+      .set_chunk_row_count(chunk_row_count)
+      .set_file_size(64*1024)
+      .set_buffer_size(4*ts::Recorder_options::block_size)
+      .set_direct_io_enabled(true));
+    driver.start_measurement();
+    std::this_thread::sleep_for(std::chrono::milliseconds{500});
+    driver.stop_measurement();
+    const auto statistics = driver.statistics();
+    driver.remove_subscribers();
+    ASSERT(statistics.recorded_file_count > 1);
+
+    // Read the files.
+    const auto column_count = driver.max_channel_count();
+    std::vector<ts::Capture_reader> readers;
+    std::uint64_t recorded_byte_count{};
+    for (std::uint64_t i{}; i < statistics.recorded_file_count; ++i) {
+      const auto index = std::to_string(i);
+      auto& reader = readers.emplace_back((directory / ("capture-" +
+            std::string(6 - index.size(), '0') + index + ".tswcap")).string());
+      ASSERT(reader.sample_rate() == 48000);
+      ASSERT(reader.column_count() == column_count);
+      ASSERT(reader.chunk_row_count() == chunk_row_count);
+      ASSERT(reader.metadata().find(R"("boardSettings":{)") != std::string_view::npos);
+      ASSERT(reader.metadata().find(R"("calibrationSlopes":[)") != std::string_view::npos);
+      ASSERT(reader.chunk_count() > 0);
+      for (std::size_t j{}; j < reader.chunk_count(); ++j)
+        recorded_byte_count += 32 + column_count *
+          reader.chunk_info(j).row_count * sizeof(float);
+    }
+    ASSERT(recorded_byte_count == statistics.recorded_byte_count);
+
+    // The truncated or corrupted files are rejected.
+    {
+      std::string content;
+      {
+        std::ifstream file{directory / "capture-000000.tswcap", std::ios::binary};
+        content.assign(std::istreambuf_iterator<char>{file}, {});
+        ASSERT(file && content.size() > 4096 + 24);
+      }
+      const auto is_rejected = [&directory](const std::string& content)
+      {
+        const auto path = directory / "corrupted.tswcap";
+        {
+          std::ofstream file{path, std::ios::binary | std::ios::trunc};
+          ASSERT(file.write(content.data(), content.size()));
+        }
+        try {
+          ts::Capture_reader{path.string()};
+        } catch (const ts::Exception& e) {
+          return e.condition() == ts::Errc::capture_file_invalid;
+        }
+        return false;
+      };
+      const auto patched = [&content](const std::size_t offset, const auto value)
+      {
+        auto result = content;
+        std::memcpy(result.data() + offset, &value, sizeof(value));
+        return result;
+      };
+      std::uint64_t index_offset{};
+      std::memcpy(&index_offset, content.data() + content.size() - 24,
+        sizeof(index_offset));
+      ASSERT(index_offset < content.size() - 24);
+      ASSERT(!is_rejected(content));
+      ASSERT(is_rejected(content.substr(0, content.size() - 1)));
+      ASSERT(is_rejected(content.substr(0, index_offset) +
+          content.substr(index_offset + 40)));
+      ASSERT(is_rejected(patched(16, std::uint32_t{0x40000001}))); // column count
+      ASSERT(is_rejected(patched(20, std::uint32_t{0xffffffff}))); // chunk row count
+      ASSERT(is_rejected(patched(index_offset,
+            std::numeric_limits<std::uint64_t>::max() - 31))); // chunk offset
+      ASSERT(is_rejected(patched(index_offset, index_offset - 16))); // chunk offset
+      ASSERT(is_rejected(patched(index_offset + 8 + 28,
+            std::uint32_t{0xffffffff}))); // chunk size
+    }
+    std::filesystem::remove_all(directory);
+
+    // Check that the chunks are contiguous and hold the values in order.
+    const auto value = [](const unsigned channel, const std::uint64_t index)
+    {
+      return static_cast<float>(Simulated_acquisition_source::code(channel, index)
+        - ts::detail::chunk_code_offset);
+    };
+    const auto first_chunk = readers.front().chunk(0);
+    std::optional<std::uint64_t> first;
+    for (std::uint64_t i{}; i < 960 && !first; ++i) {
+      bool matches{true};
+      for (unsigned c{}; c < column_count && matches; ++c) {
+        for (std::size_t r{}; r < 4 && matches; ++r)
+          matches = first_chunk.value(c, r) == value(c, i + r);
+      }
+      if (matches)
+        first = i;
+    }
+    ASSERT(first);
+    std::uint64_t sample_index{readers.front().chunk_info(0).sample_index};
+    for (const auto& reader : readers) {
+      for (std::size_t i{}; i < reader.chunk_count(); ++i) {
+        const auto info = reader.chunk_info(i);
+        const auto chunk = reader.chunk(i);
+        ASSERT(info.sample_index == sample_index);
+        ASSERT(info.row_count <= chunk_row_count);
+        ASSERT(info.first_read_time <= info.last_read_time);
+        ASSERT(chunk.row_count() == info.row_count);
+        for (unsigned c{}; c < column_count; ++c) {
+          for (std::size_t r{}; r < chunk.row_count(); ++r)
+            ASSERT(chunk.value(c, r) == value(c, *first + sample_index + r));
+        }
+        sample_index += info.row_count;
+      }
+    }
+
+    // Check the access by the time range.
+    const auto& reader = readers.front();
+    ASSERT(reader.chunk_count() > 2);
+    const auto info1 = reader.chunk_info(1);
+    const auto info2 = reader.chunk_info(2);
+    ASSERT(reader.view(info1.first_read_time, info1.first_read_time).empty());
+    const auto views = reader.view(info1.first_read_time,
+      info2.last_read_time + std::chrono::nanoseconds{1});
+    ASSERT(views.size() == 2);
+    ASSERT(views[0].row_count() == info1.row_count);
+    ASSERT(views[1].row_count() == info2.row_count);
+    const auto table = reader.read(info1.first_read_time + std::chrono::nanoseconds{1},
+      info2.first_read_time);
+    ASSERT(table.column_count() == column_count);
+    ASSERT(0 < table.row_count() && table.row_count() < info1.row_count);
+    const auto offset = info1.row_count - table.row_count();
+    for (unsigned c{}; c < column_count; ++c) {
+      for (std::size_t r{}; r < table.row_count(); ++r)
+        ASSERT(table.value(c, r) == value(c, *first + info1.sample_index + offset + r));
+    }
+  }
+
+  // Measurement with the compressed capture recorder.
+  {
+    auto& driver = ts::Driver::instance().initialize();
+    driver.set_settings(ts::Driver_settings{}
+      .set_translation_offsets(std::vector<float>(driver.max_channel_count(), 0))
+      .set_translation_slopes(std::vector<float>(driver.max_channel_count(), 1)));
+    const auto directory = std::filesystem::temp_directory_path() /
+      ("panda_timeswipe_compressed_capture_" + std::to_string(getpid()));
+    std::filesystem::create_directories(directory);
+    const auto options = ts::Recorder_options{(directory / "capture-").string()}
+      .set_format(ts::Recorder_format::compressed_capture)
+      .set_chunk_row_count(1000)
+      .set_file_size(64*1024)
+      .set_buffer_size(4*ts::Recorder_options::block_size);
+    try {
+      driver.add_recorder(24000, 4800, options);
+      ASSERT(false);
+    } catch (const ts::Exception& e) {
+      ASSERT(e.condition() == ts::Errc::driver_settings_invalid);
+    }
+    try {
+      // The chunk of 4 columns of 4800 codes doesn't fit into the buffer.
+      driver.add_recorder(48000, 4800, ts::Recorder_options{options}
+        .set_chunk_row_count(4800).set_buffer_size(ts::Recorder_options::block_size));
+      ASSERT(false);
+    } catch (const ts::Exception& e) {
+      ASSERT(e.condition() == ts::Errc::driver_settings_invalid);
+    }
+    driver.add_recorder(48000, 4800, options);
+    driver.start_measurement();
+    std::this_thread::sleep_for(std::chrono::milliseconds{500});
+    driver.stop_measurement();
+    const auto statistics = driver.statistics();
+    driver.remove_subscribers();
+    ASSERT(statistics.recorded_file_count > 0);
+
+    // Read the files.
+    const auto column_count = driver.max_channel_count();
+    const auto transforms = driver.value_transforms();
+    std::vector<ts::Capture_reader> readers;
+    std::uint64_t row_count{};
+    for (std::uint64_t i{}; i < statistics.recorded_file_count; ++i) {
+      const auto index = std::to_string(i);
+      auto& reader = readers.emplace_back((directory / ("capture-" +
+            std::string(6 - index.size(), '0') + index + ".tswcap")).string());
+      ASSERT(reader.is_compressed());
+      ASSERT(reader.column_count() == column_count);
+      ASSERT(reader.chunk_count() > 0);
+      const auto reader_transforms = reader.value_transforms();
+      ASSERT(reader_transforms.size() == column_count);
+      for (unsigned c{}; c < column_count; ++c) {
+        ASSERT(reader_transforms[c].code_offset == transforms[c].code_offset);
+        ASSERT(reader_transforms[c].scale == transforms[c].scale);
+        ASSERT(reader_transforms[c].offset == transforms[c].offset);
+      }
+      for (std::size_t j{}; j < reader.chunk_count(); ++j)
+        row_count += reader.chunk_info(j).row_count;
+    }
+    std::filesystem::remove_all(directory);
+
+    // The slowly changing codes take much less space than the values.
+    ASSERT(row_count > 0);
+    ASSERT(statistics.recorded_byte_count < row_count * column_count * sizeof(float) / 2);
+
+    // Check that the decoded values are exactly as the ones of the driver.
+    const auto value = [](const unsigned channel, const std::uint64_t index)
+    {
+      return static_cast<float>(Simulated_acquisition_source::code(channel, index)
+        - ts::detail::chunk_code_offset);
+    };
+    const auto first_codes = readers.front().chunk_codes(0);
+    std::optional<std::uint64_t> first;
+    for (std::uint64_t i{}; i < 960 && !first; ++i) {
+      bool matches{true};
+      for (unsigned c{}; c < column_count && matches; ++c) {
+        for (std::size_t r{}; r < 4 && matches; ++r)
+          matches = first_codes.value(c, r) == Simulated_acquisition_source::code(c, i + r);
+      }
+      if (matches)
+        first = i;
+    }
+    ASSERT(first);
+    const auto sample_index = readers.front().chunk_info(0).sample_index;
+    std::uint64_t offset{};
+    for (const auto& reader : readers) {
+      const auto table = reader.read(ts::Capture_reader::System_time::min(),
+        ts::Capture_reader::System_time::max());
+      ASSERT(table.column_count() == column_count);
+      for (unsigned c{}; c < column_count; ++c) {
+        for (std::size_t r{}; r < table.row_count(); ++r)
+          ASSERT(table.value(c, r) == value(c, *first + sample_index + offset + r));
+      }
+      offset += table.row_count();
+    }
+    ASSERT(offset == row_count);
+  }
+
+  /*
+   * Measurement with the subscriber of raw data (without and with the handler
+   * queue, and with the translation slope which is inexact in binary).
+   */
+  const std::pair<std::size_t, float> raw_cases[]{{0, 1}, {2, 1}, {0, 3.3f}};
+  for (const auto& [queue_size, translation_slope] : raw_cases) {
+    auto& driver = ts::Driver::instance().initialize();
+    std::vector<float> translation_offsets(driver.max_channel_count());
+    if (translation_slope != 1) {
+      for (unsigned c{}; c < translation_offsets.size(); ++c)
+        translation_offsets[c] = 0.1f * (c + 1);
+    }
+    auto settings = ts::Driver_settings{}
+      .set_translation_offsets(translation_offsets)
+      .set_translation_slopes(std::vector<float>(translation_offsets.size(),
+          translation_slope));
+    if (queue_size)
+      settings.set_handler_queue_size(queue_size);
+    driver.set_settings(settings);
+
+    // The subscribers of both the raw data and the data receive the same samples.
+    constexpr std::size_t min_sample_count{9600};
+    std::mutex mutex;
+    std::condition_variable done;
+    ts::Driver::Raw_data raw_data;
+    ts::Driver::Data data;
+    driver.add_subscriber(1200, ts::Driver::raw, [&](const auto& burst, const int)
+    {
+      ASSERT(driver.data_info().sample_index == raw_data.row_count());
+      const std::lock_guard lock{mutex};
+      raw_data.append_rows(burst.to_table());
+      done.notify_one();
+    });
+    driver.add_subscriber(48000, 2400, [&](auto burst, const int)
+    {
+      ASSERT(driver.data_info().sample_index == data.row_count());
+      const std::lock_guard lock{mutex};
+      data.append_rows(burst);
+      done.notify_one();
+    });
+    driver.start_measurement();
+    {
+      std::unique_lock lock{mutex};
+      done.wait(lock, [&]
+      {
+        return raw_data.row_count() >= min_sample_count &&
+          data.row_count() >= min_sample_count;
+      });
+    }
+    driver.stop_measurement();
+    driver.remove_subscribers();
+
+    // The values are calculated from the raw data by the value transforms.
+    const auto transforms = driver.value_transforms();
+    ASSERT(transforms.size() == driver.max_channel_count());
+    ASSERT(raw_data.column_count() == driver.max_channel_count());
+    for (unsigned c{}; c < raw_data.column_count(); ++c) {
+      const auto [code_offset, scale, offset] = transforms[c];
+      ASSERT(code_offset == ts::detail::chunk_code_offset);
+      ASSERT(translation_slope != 1 || (scale == 1 && offset == 0));
+      for (std::size_t r{}; r < min_sample_count; ++r) {
+        const auto code = raw_data.value(c, r);
+        const auto value = data.value(c, r);
+        ASSERT(value == static_cast<float>(code - code_offset) * scale + offset);
+
+        // The values near zero are as precise as the large ones.
+        const double reference{((code - static_cast<double>(code_offset))
+            - translation_offsets[c]) / translation_slope};
+        ASSERT(std::abs(value - reference) <= 1e-6 * std::max(1.0, std::abs(reference)));
+      }
+    }
+  }
+
+  // Measurement with the handler queue.
+  for (const auto policy : {ts::Overflow_policy::block,
+      ts::Overflow_policy::drop_oldest, ts::Overflow_policy::coalesce}) {
+    auto& driver = ts::Driver::instance().initialize();
+    constexpr std::size_t burst_buffer_size{480};
+    driver.set_settings(ts::Driver_settings{}.set_sample_rate(48000)
+      .set_burst_buffer_size(burst_buffer_size)
+      .set_handler_queue_size(2)
+      .set_handler_overflow_policy(policy)
+      .set_translation_offsets(std::vector<float>(driver.max_channel_count(), 0))
+      .set_translation_slopes(std::vector<float>(driver.max_channel_count(), 1)));
+
+    // The handler is slower than the data, so the handler queue overflows.
+    std::mutex mutex;
+    std::condition_variable done;
+    std::vector<std::pair<ts::Driver::Data_info, ts::Driver::Data>> results;
+    driver.start_measurement([&](auto data, const int error_marker)
+    {
+      const auto& info = driver.data_info();
+      ASSERT(info.lost_sample_count == static_cast<std::uint64_t>(error_marker));
+      std::this_thread::sleep_for(std::chrono::milliseconds{10});
+      const std::lock_guard lock{mutex};
+      if (results.size() < 8) {
+        results.emplace_back(info, std::move(data));
+        done.notify_one();
+      }
+    });
+    {
+      std::unique_lock lock{mutex};
+      done.wait(lock, [&]{ return results.size() == 8; });
+    }
+    driver.stop_measurement();
+
+    // Check the continuity of the sample indexes.
+    std::uint64_t lost_count{};
+    bool is_coalesced{};
+    for (std::size_t i{}; i < results.size(); ++i) {
+      const auto& [info, data] = results[i];
+      ASSERT(info.sample_count == data.row_count());
+      is_coalesced = is_coalesced || info.sample_count > burst_buffer_size;
+      lost_count += info.lost_sample_count;
+      ASSERT(info.total_lost_sample_count == lost_count);
+      if (i) {
+        const auto& prev_info = results[i - 1].first;
+        ASSERT(info.sample_index == prev_info.sample_index + prev_info.sample_count +
+          info.lost_sample_count);
+      }
+    }
+    const auto statistics = driver.statistics();
+    if (policy == ts::Overflow_policy::drop_oldest) {
+      ASSERT(lost_count > 0);
+      ASSERT(statistics.dropped_burst_count > 0);
+    } else {
+      ASSERT(!lost_count);
+      ASSERT(!statistics.dropped_burst_count);
+    }
+    if (policy == ts::Overflow_policy::coalesce)
+      ASSERT(is_coalesced);
+
+    // Check that the samples are at their indexes.
+    const auto& data0 = results.front().second;
+    std::optional<std::uint64_t> first;
+    for (std::uint64_t i{}; i < 960 && !first; ++i) {
+      bool matches{true};
+      for (unsigned c{}; c < data0.column_count() && matches; ++c) {
+        for (std::size_t r{}; r < 4 && matches; ++r)
+          matches = data0.value(c, r) == Simulated_acquisition_source::code(c, i + r)
+            - ts::detail::chunk_code_offset;
+      }
+      if (matches)
+        first = i;
+    }
+    ASSERT(first);
+    for (const auto& [info, data] : results) {
+      for (unsigned c{}; c < data.column_count(); ++c) {
+        for (std::size_t r{}; r < data.row_count(); ++r)
+          ASSERT(data.value(c, r) == Simulated_acquisition_source::code(c,
+              *first + info.sample_index + r) - ts::detail::chunk_code_offset);
+      }
+    }
+  }
+
+  // Measurement with the coalescing handler queue shared by the subscribers.
+  {
+    auto& driver = ts::Driver::instance().initialize();
+    constexpr std::size_t queue_size{2};
+    driver.set_settings(ts::Driver_settings{}.set_sample_rate(48000)
+      .set_handler_queue_size(queue_size)
+      .set_handler_overflow_policy(ts::Overflow_policy::coalesce)
+      .set_translation_offsets(std::vector<float>(driver.max_channel_count(), 0))
+      .set_translation_slopes(std::vector<float>(driver.max_channel_count(), 1)));
+
+    /*
+     * The handlers are slower than the data, and the bursts of the frequent
+     * subscriber fill the queue, so the bursts of the rare one can't be
+     * coalesced.
+     */
+    std::mutex mutex;
+    std::condition_variable done;
+    std::size_t rare_count{};
+    driver.add_subscriber(48000, 480, [&](auto, const int)
+    {
+      std::this_thread::sleep_for(std::chrono::milliseconds{20});
+    });
+    driver.add_subscriber(48000, 9600, [&](auto, const int)
+    {
+      std::this_thread::sleep_for(std::chrono::milliseconds{20});
+      const std::lock_guard lock{mutex};
+      ++rare_count;
+      done.notify_one();
+    });
+    driver.start_measurement();
+    {
+      std::unique_lock lock{mutex};
+      done.wait(lock, [&]{ return rare_count >= 4; });
+    }
+    const auto statistics = driver.statistics();
+    driver.stop_measurement();
+    driver.remove_subscribers();
+
+    ASSERT(statistics.handler_queue_high_water_mark <= queue_size);
+    ASSERT(statistics.dropped_burst_count > 0);
+  }
+
+  // Measurement with the real-time requests.
+  {
+    auto& driver = ts::Driver::instance().initialize();
+    ASSERT(!driver.realtime_report().memory_locking);
+    const int cpu{sched_getcpu()};
+    ASSERT(cpu >= 0);
+    driver.set_settings(ts::Driver_settings{}.set_sample_rate(48000)
+      .set_burst_buffer_size(4800)
+      .set_translation_offsets(std::vector<float>(driver.max_channel_count(), 0))
+      .set_translation_slopes(std::vector<float>(driver.max_channel_count(), 1))
+      .set_scheduling_policy(ts::Scheduling_policy::other)
+      .set_reading_thread_priority(0)
+      .set_reading_thread_cpu(cpu)
+      .set_handler_queue_size(2)
+      .set_handling_thread_priority(0)
+      .set_handling_thread_cpu(cpu)
+      .set_memory_locking(true));
+
+    std::mutex mutex;
+    std::condition_variable done;
+    std::size_t row_count{};
+    driver.start_measurement([&](const auto data, const int)
+    {
+      const std::lock_guard lock{mutex};
+      row_count += data.row_count();
+      done.notify_one();
+    });
+    {
+      std::unique_lock lock{mutex};
+      done.wait(lock, [&row_count]{ return row_count > 0; });
+    }
+    driver.stop_measurement();
+
+    /*
+     * The default policy is always granted unlike the real-time ones, and the
+     * memory locking depends on the privileges.
+     */
+    const auto report = driver.realtime_report();
+    ASSERT(report.reading_thread_affinity == true);
+    ASSERT(report.reading_thread_scheduling == true);
+    ASSERT(!report.processing_thread_affinity);
+    ASSERT(report.processing_thread_scheduling == true);
+    ASSERT(report.handling_thread_affinity == true);
+    ASSERT(report.handling_thread_scheduling == true);
+    ASSERT(report.memory_locking.has_value());
+  }
+ } catch (const std::exception& e) {
+  std::cerr << "error: " << e.what() << std::endl;
+  return 1;
+ } catch (...) {
+  std::cerr << "unknown error\n";
+  return 2;
+ }
@@ -0,0 +1,116 @@
+// -*- C++ -*-
+/*
+  This Source Code Form is subject to the terms of the Mozilla Public
+  License, v. 2.0. If a copy of the MPL was not distributed with this
+  file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+  Copyright (c) 2021 PANDA GmbH / Dmitry Igrishin
+*/
+
+#include "../../src/debug.hpp"
+#include "../../src/delta_bitpack.hpp"
+
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#define ASSERT PANDA_TIMESWIPE_ASSERT
+
+namespace {
+
+namespace codec = panda::timeswipe::detail::delta_bitpack;
+
+/// @returns The encoded `codes` after checking that they're decoded back.
+std::vector<unsigned char> round_trip(const std::vector<std::uint16_t>& codes)
+{
+  std::vector<unsigned char> encoded(codec::max_encoded_size(codes.size()));
+  const auto size = codec::encode(codes.data(), codes.size(), encoded.data());
+  ASSERT(size <= encoded.size());
+  encoded.resize(size);
+
+  std::vector<std::uint16_t> decoded(codes.size());
+  ASSERT(codec::decode(encoded.data(), encoded.size(), decoded.data(),
+      decoded.size()) == size);
+  ASSERT(decoded == codes);
+  return encoded;
+}
+
+} // namespace
+
+int main()
+try {
+  // Zigzag.
+  for (unsigned i{}; i <= 0xffff; ++i) {
+    const auto delta = static_cast<std::uint16_t>(i);
+    ASSERT(codec::unzigzag(codec::zigzag(delta)) == delta);
+  }
+  ASSERT(codec::zigzag(0) == 0);
+  ASSERT(codec::zigzag(0xffff) == 1); // -1
+  ASSERT(codec::zigzag(1) == 2);
+
+  // Empty and single code.
+  ASSERT(round_trip({}).empty());
+  ASSERT(round_trip({12345}).size() == 2);
+
+  // Constant codes take one byte per block.
+  ASSERT(round_trip(std::vector<std::uint16_t>(1 + 3*codec::block_size, 777))
+    .size() == 2 + 3);
+
+  // Small deltas of both signs, including the partial blocks.
+  for (const std::size_t count : {2, 63, 64, 65, 66, 129, 1000}) {
+    std::vector<std::uint16_t> codes(count);
+    for (std::size_t i{}; i < count; ++i)
+      codes[i] = static_cast<std::uint16_t>(32768 + (i % 7) - 3);
+    const auto encoded = round_trip(codes);
+    if (count > codec::block_size)
+      ASSERT(encoded.size() < count * sizeof(std::uint16_t));
+  }
+
+  // Wrap around the extremes and the widest deltas.
+  {
+    std::vector<std::uint16_t> codes;
+    for (int i{}; i < 100; ++i)
+      codes.insert(codes.end(), {0, 0xffff, 0x8000, 0x7fff, 0, 1});
+    const auto encoded = round_trip(codes);
+    ASSERT(encoded.size() <= codec::max_encoded_size(codes.size()));
+  }
+
+  // Random codes of every bit width.
+  {
+    std::mt19937 generator{1};
+    for (unsigned width{}; width <= 16; ++width) {
+      std::uniform_int_distribution<unsigned> distribution{0, (1u << width) - 1};
+      std::vector<std::uint16_t> codes(777);
+      for (auto& code : codes)
+        code = static_cast<std::uint16_t>(distribution(generator));
+      round_trip(codes);
+    }
+  }
+
+  // Invalid input.
+  {
+    std::vector<std::uint16_t> codes(100, 1);
+    codes[50] = 1000;
+    const auto encoded = round_trip(codes);
+    std::vector<std::uint16_t> decoded(codes.size());
+    ASSERT(!codec::decode(encoded.data(), 1, decoded.data(), decoded.size()));
+    ASSERT(!codec::decode(encoded.data(), encoded.size() - 1, decoded.data(),
+        decoded.size()));
+    {
+      std::vector<std::uint16_t> longer(codes.size() + codec::block_size);
+      ASSERT(!codec::decode(encoded.data(), encoded.size(), longer.data(),
+          longer.size()));
+    }
+    auto corrupted = encoded;
+    corrupted[2] = 17; // the width of the first block
+    ASSERT(!codec::decode(corrupted.data(), corrupted.size(), decoded.data(),
+        decoded.size()));
+  }
+ } catch (const std::exception& e) {
+  std::cerr << "error: " << e.what() << std::endl;
+  return 1;
+ } catch (...) {
+  std::cerr << "unknown error\n";
+  return 2;
+ }
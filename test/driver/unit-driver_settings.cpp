@@ -9,6 +9,7 @@
 
 #include "../../src/debug.hpp"
 #include "../../src/driver_settings.hpp"
+#include "../../src/exceptions.hpp"
 
 #include <iostream>
 
@@ -18,6 +19,16 @@ constexpr std::string_view json_text{R"(
 {
 "sampleRate": 24000,
 "burstBufferSize": 12000,
+"wakeupPolicy": 1,
+"readBufferSize": 96000,
+"readOverflowPolicy": 2,
+"handlerQueueSize": 4,
+"handlerOverflowPolicy": 3,
+"queueMemoryBudget": 1048576,
+"schedulingPolicy": 1,
+"readingThreadPriority": 50,
+"readingThreadCpu": 3,
+"memoryLocking": true,
 "translationOffsets": [1.1, 2.2, 3.3, 4.4],
 "translationSlopes": [1.1, 2.2, 3.3, 4.4]
 }
@@ -46,6 +57,115 @@ try {
     ASSERT(ds.frequency() == std::nullopt);
   }
 
+  // Wakeup policy
+  {
+    ASSERT(ds.wakeup_policy() == ts::Wakeup_policy::low_cpu);
+    ts::Driver_settings other;
+    ASSERT(!other.wakeup_policy());
+    other.set_wakeup_policy(ts::Wakeup_policy::low_latency);
+    ASSERT(!other.is_empty());
+    ds.merge_not_null(other);
+    ASSERT(ds.wakeup_policy() == ts::Wakeup_policy::low_latency);
+  }
+
+  // Read buffer
+  {
+    ASSERT(ds.read_buffer_size() == 96000);
+    ASSERT(ds.read_overflow_policy() == ts::Overflow_policy::drop_newest);
+    ts::Driver_settings other;
+    other.set_read_overflow_policy(ts::Overflow_policy::block);
+    ds.merge_not_null(other);
+    ASSERT(ds.read_buffer_size() == 96000);
+    ASSERT(ds.read_overflow_policy() == ts::Overflow_policy::block);
+
+    bool is_thrown{};
+    try {
+      other.set_read_buffer_size(0);
+    } catch (const ts::Exception&) {
+      is_thrown = true;
+    }
+    ASSERT(is_thrown);
+  }
+
+  // Handler queue
+  {
+    ASSERT(ds.handler_queue_size() == 4);
+    ASSERT(ds.handler_overflow_policy() == ts::Overflow_policy::coalesce);
+
+    bool is_thrown{};
+    try {
+      ts::Driver_settings{R"({"readOverflowPolicy": 3})"};
+    } catch (const ts::Exception&) {
+      is_thrown = true;
+    }
+    ASSERT(is_thrown);
+
+    is_thrown = false;
+    try {
+      ts::Driver_settings{}.set_handler_queue_size(0);
+    } catch (const ts::Exception&) {
+      is_thrown = true;
+    }
+    ASSERT(is_thrown);
+  }
+
+  // Queue memory budget
+  {
+    ASSERT(ds.queue_memory_budget() == 1048576);
+    bool is_thrown{};
+    try {
+      ts::Driver_settings{R"({"queueMemoryBudget": 0})"};
+    } catch (const ts::Exception&) {
+      is_thrown = true;
+    }
+    ASSERT(is_thrown);
+  }
+
+  // Real-time control
+  {
+    ASSERT(ds.scheduling_policy() == ts::Scheduling_policy::fifo);
+    ASSERT(ds.reading_thread_priority() == 50);
+    ASSERT(!ds.processing_thread_priority());
+    ASSERT(ds.reading_thread_cpu() == 3);
+    ASSERT(!ds.processing_thread_cpu());
+    ASSERT(!ds.handling_thread_priority());
+    ASSERT(!ds.handling_thread_cpu());
+    ASSERT(ds.memory_locking() == true);
+    ts::Driver_settings other;
+    other.set_scheduling_policy(ts::Scheduling_policy::round_robin)
+      .set_processing_thread_priority(10).set_processing_thread_cpu(1)
+      .set_handling_thread_priority(5).set_handling_thread_cpu(2);
+    ds.merge_not_null(other);
+    ASSERT(ds.scheduling_policy() == ts::Scheduling_policy::round_robin);
+    ASSERT(ds.reading_thread_priority() == 50);
+    ASSERT(ds.processing_thread_priority() == 10);
+    ASSERT(ds.processing_thread_cpu() == 1);
+    ASSERT(ds.handling_thread_priority() == 5);
+    ASSERT(ds.handling_thread_cpu() == 2);
+
+    bool is_thrown{};
+    try {
+      other.set_reading_thread_priority(100);
+    } catch (const ts::Exception&) {
+      is_thrown = true;
+    }
+    ASSERT(is_thrown);
+    is_thrown = false;
+    try {
+      ts::Driver_settings{R"({"readingThreadCpu": -1})"};
+    } catch (const ts::Exception&) {
+      is_thrown = true;
+    }
+    ASSERT(is_thrown);
+    is_thrown = false;
+    try {
+      other.set_handling_thread_cpu(-1);
+    } catch (const ts::Exception&) {
+      is_thrown = true;
+    }
+    ASSERT(is_thrown);
+  }
+
   // Translation offsets
   {
     const std::vector<float> expected{1.1,2.2,3.3,4.4};
@@ -0,0 +1,109 @@
+// -*- C++ -*-
+/*
+  This Source Code Form is subject to the terms of the Mozilla Public
+  License, v. 2.0. If a copy of the MPL was not distributed with this
+  file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+  Copyright (c) 2021 PANDA GmbH / Dmitry Igrishin
+*/
+
+#include "../../src/debug.hpp"
+#include "../../src/fir_cache.hpp"
+#include "../../src/resampler.hpp"
+
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+#include <unistd.h>
+
+#define ASSERT PANDA_TIMESWIPE_ASSERT
+
+int main()
+try {
+  namespace detail = panda::timeswipe::detail;
+  auto& cache = detail::Fir_cache::instance();
+  const auto directory = std::filesystem::temp_directory_path() /
+    ("panda_timeswipe_fir_cache_" + std::to_string(getpid()));
+  std::filesystem::remove_all(directory);
+
+  int design_count{};
+  const auto design = [&design_count]
+  {
+    ++design_count;
+    return detail::Fir_cache::Coefficients{{1, 2, 3}, {.5, .25}};
+  };
+
+  // Memory cache only.
+  {
+    ASSERT(cache.directory().empty());
+    const auto firc = cache.get("a", design);
+    ASSERT(design_count == 1 && cache.miss_count() == 1);
+    ASSERT(*firc == design());
+    --design_count;
+    ASSERT(cache.get("a", design) == firc);
+    ASSERT(design_count == 1 && cache.memory_hit_count() == 1);
+    cache.get("b", design);
+    ASSERT(design_count == 2);
+    cache.clear();
+  }
+
+  // Disk cache.
+  {
+    cache.set_directory(directory);
+    design_count = 0;
+    const auto firc = *cache.get("a", design);
+    ASSERT(design_count == 1);
+    ASSERT(std::distance(std::filesystem::directory_iterator{directory},
+        std::filesystem::directory_iterator{}) == 1);
+    cache.clear();
+    ASSERT(*cache.get("a", design) == firc);
+    ASSERT(design_count == 1 && cache.disk_hit_count() == 1);
+
+    // The corrupted file is a miss, and is rewritten.
+    cache.clear();
+    const auto path = std::filesystem::directory_iterator{directory}->path();
+    std::filesystem::resize_file(path, std::filesystem::file_size(path) - 1);
+    ASSERT(*cache.get("a", design) == firc);
+    ASSERT(design_count == 2);
+    cache.clear();
+    ASSERT(*cache.get("a", design) == firc);
+    ASSERT(design_count == 2 && cache.disk_hit_count() == 2);
+  }
+
+  // Resampler designs the coefficients once per options.
+  {
+    cache.clear();
+    const auto miss_count = cache.miss_count();
+    const auto options = detail::Resampler_options{}.set_channel_count(4)
+      .set_up_down(1, 1500).set_multistage_enabled(true);
+    detail::Resampler<float> resampler1{options};
+    ASSERT(cache.miss_count() == miss_count + 1);
+    detail::Resampler<float> resampler2{detail::Resampler_options{options}
+      .set_channel_count(1).set_extrapolation(detail::Signal_extrapolation::constant)};
+    ASSERT(cache.miss_count() == miss_count + 1);
+    cache.clear();
+    detail::Resampler<float> resampler3{options};
+    ASSERT(cache.miss_count() == miss_count + 1);
+    detail::Resampler<float> resampler4{detail::Resampler_options{options}
+      .set_up_down(1, 1200)};
+    ASSERT(cache.miss_count() == miss_count + 2);
+
+    // The resampling by the cached coefficients is the same.
+    panda::timeswipe::Table<float> table(4);
+    table.append_generated_rows(48000, [](const auto column, float* const out)
+    {
+      for (std::size_t i{}; i < 48000; ++i)
+        out[i] = static_cast<float>(i % 100 + column);
+    });
+    ASSERT(resampler1.apply(table).column(0) == resampler3.apply(table).column(0));
+  }
+  std::filesystem::remove_all(directory);
+ } catch (const std::exception& e) {
+  std::cerr << "error: " << e.what() << std::endl;
+  return 1;
+ } catch (...) {
+  std::cerr << "unknown error\n";
+  return 2;
+ }
@@ -0,0 +1,196 @@
+// -*- C++ -*-
+/*
+  This Source Code Form is subject to the terms of the Mozilla Public
+  License, v. 2.0. If a copy of the MPL was not distributed with this
+  file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+  Copyright (c) 2021 PANDA GmbH / Dmitry Igrishin
+*/
+
+#include "../../src/debug.hpp"
+#include "../../src/fir_resampler.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#define ASSERT PANDA_TIMESWIPE_ASSERT
+
+namespace {
+
+namespace detail = panda::timeswipe::detail;
+
+/**
+ * @returns The first `count` samples of the upsampled by `up`, filtered by `h`
+ * and downsampled by `down` sequence `x`, which are calculated sequentially
+ * by the definition.
+ */
+std::vector<double> reference(const int up, const int down,
+  const std::vector<double>& h, const std::vector<double>& x,
+  const std::size_t count)
+{
+  std::vector<double> result(count);
+  for (std::size_t m{}; m < count; ++m) {
+    for (std::size_t k{}; k < h.size(); ++k) {
+      const auto j = static_cast<long>(m*down) - static_cast<long>(k);
+      if (j >= 0 && !(j % up) && static_cast<std::size_t>(j / up) < x.size())
+        result[m] += h[k] * x[j / up];
+    }
+  }
+  return result;
+}
+
+/// Checks the resampling of `x` by chunks against the reference.
+template<typename T>
+void check(const int up, const int down, const std::size_t coef_count,
+  const std::size_t chunk_size, std::mt19937& generator)
+{
+  std::uniform_real_distribution<double> distribution{-1, 1};
+  std::vector<double> h(coef_count), x(2000);
+  for (auto& c : h) c = distribution(generator);
+  for (auto& v : x) v = distribution(generator);
+  const std::vector<T> th(h.cbegin(), h.cend()), tx(x.cbegin(), x.cend());
+
+  detail::Fir_resampler<T> resampler{up, down, th.cbegin(), th.cend()};
+  std::vector<T> result;
+  for (std::size_t offset{}; offset < tx.size(); offset += chunk_size) {
+    const auto b = tx.cbegin() + offset;
+    const auto e = tx.cbegin() + std::min(offset + chunk_size, tx.size());
+    const auto size = result.size();
+    result.resize(size + resampler.output_sequence_size(e - b));
+    ASSERT(resampler.apply(b, e, result.begin() + size) == result.end());
+  }
+  ASSERT(result.size() == (x.size()*up + down - 1) / down);
+
+  const auto expected = reference(up, down, h, x, result.size());
+  const double tolerance{std::is_same_v<T, float> ? 1e-4 : 1e-12};
+  for (std::size_t i{}; i < result.size(); ++i)
+    ASSERT(std::abs(result[i] - expected[i]) <= tolerance * (1 + std::abs(expected[i])));
+}
+
+/**
+ * @brief Checks the resampling of `Lanes` channels by chunks by the instance
+ * of Interleaved_fir_resampler against the instances of Fir_resampler.
+ */
+template<typename T, std::size_t Lanes>
+void check_interleaved(const int up, const int down, const std::size_t coef_count,
+  const std::size_t chunk_size, const detail::Signal_extrapolation extrapolation,
+  std::mt19937& generator)
+{
+  std::uniform_real_distribution<T> distribution{-1, 1};
+  std::vector<T> h(coef_count);
+  for (auto& c : h) c = distribution(generator);
+  std::array<std::vector<T>, Lanes> x;
+  for (auto& column : x) {
+    column.resize(3000);
+    for (auto& v : column) v = distribution(generator);
+  }
+
+  /*
+   * The reference resamplers are fed by the same chunks, since the initial
+   * extrapolation depends on the size of the first chunk.
+   */
+  detail::Interleaved_fir_resampler<T, Lanes> resampler{up, down,
+    h.cbegin(), h.cend(), extrapolation};
+  std::array<detail::Fir_resampler<T>, Lanes> expected_resamplers;
+  for (auto& r : expected_resamplers)
+    r = detail::Fir_resampler<T>{up, down, h.cbegin(), h.cend(), extrapolation};
+  std::array<std::vector<T>, Lanes> result, expected;
+  const auto size = x[0].size();
+  for (std::size_t offset{}; offset <= size; offset += chunk_size) {
+    const auto in_size = offset < size ? std::min(chunk_size, size - offset) : 0;
+    const auto out_size = in_size ? resampler.output_sequence_size(in_size) :
+      resampler.output_sequence_size(resampler.coefs_per_phase() - 1);
+    std::array<const T*, Lanes> in;
+    std::array<T*, Lanes> out;
+    for (std::size_t l{}; l < Lanes; ++l) {
+      in[l] = x[l].data() + offset;
+      result[l].resize(result[l].size() + out_size);
+      out[l] = result[l].data() + result[l].size() - out_size;
+
+      auto& r = expected_resamplers[l];
+      expected[l].resize(result[l].size());
+      const auto e = expected[l].begin() + (result[l].size() - out_size);
+      ASSERT((in_size ? r.apply(x[l].cbegin() + offset,
+            x[l].cbegin() + offset + in_size, e) : r.flush(e)) == expected[l].end());
+    }
+    ASSERT((in_size ? resampler.apply(in, in_size, out) : resampler.flush(out)) ==
+      out_size);
+  }
+
+  const T tolerance{std::is_same_v<T, float> ? T(1e-4) : T(1e-12)};
+  for (std::size_t l{}; l < Lanes; ++l) {
+    for (std::size_t i{}; i < expected[l].size(); ++i)
+      ASSERT(std::abs(result[l][i] - expected[l][i]) <=
+        tolerance * (1 + std::abs(expected[l][i])));
+  }
+}
+
+} // namespace
+
+int main()
+try {
+  std::mt19937 generator{1};
+  for (const auto& [up, down] : {std::pair{1, 1}, {1, 2}, {1, 5}, {3, 2},
+      {2, 3}, {147, 160}, {7, 25}}) {
+    for (const std::size_t coef_count : {1, 5, 16, 31, 101}) {
+      for (const std::size_t chunk_size : {1, 7, 64, 2000}) {
+        check<float>(up, down, coef_count, chunk_size, generator);
+        check<double>(up, down, coef_count, chunk_size, generator);
+      }
+    }
+  }
+
+  // The dot product of the various sizes (the SIMD body and the tail).
+  for (std::size_t count{}; count < 40; ++count) {
+    std::vector<float> h(count), x(count);
+    double expected{};
+    for (std::size_t i{}; i < count; ++i) {
+      h[i] = static_cast<float>(i + 1);
+      x[i] = static_cast<float>(count - i);
+      expected += h[i] * x[i];
+    }
+    ASSERT(detail::dot_product<float>(h.data(), x.data(), count) == expected);
+  }
+
+  // The interleaved resampling of the channels.
+  using Se = detail::Signal_extrapolation;
+  for (const auto extrapolation : {Se::zero, Se::constant, Se::symmetric,
+      Se::reflect, Se::periodic, Se::smooth, Se::antisymmetric, Se::antireflect}) {
+    for (const auto& [up, down] : {std::pair{1, 2}, {3, 2}, {147, 160}}) {
+      for (const std::size_t coef_count : {1, 16, 101}) {
+        for (const std::size_t chunk_size : {1, 5, 1500, 3000}) {
+          check_interleaved<float, 4>(up, down, coef_count, chunk_size,
+            extrapolation, generator);
+          check_interleaved<double, 2>(up, down, coef_count, chunk_size,
+            extrapolation, generator);
+        }
+      }
+    }
+  }
+
+  // The dot products of the lanes of the various sizes.
+  for (std::size_t count{}; count < 10; ++count) {
+    std::vector<float> h(count), x(count * 4);
+    std::array<float, 4> expected{}, result;
+    for (std::size_t i{}; i < count; ++i) {
+      h[i] = static_cast<float>(i + 1);
+      for (std::size_t l{}; l < 4; ++l) {
+        x[i*4 + l] = static_cast<float>(count - i + l);
+        expected[l] += h[i] * x[i*4 + l];
+      }
+    }
+    detail::dot_product_lanes<4>(h.data(), x.data(), count, result.data());
+    ASSERT(result == expected);
+  }
+ } catch (const std::exception& e) {
+  std::cerr << "error: " << e.what() << std::endl;
+  return 1;
+ } catch (...) {
+  std::cerr << "unknown error\n";
+  return 2;
+ }
@@ -0,0 +1,154 @@
+// -*- C++ -*-
+/*
+  This Source Code Form is subject to the terms of the Mozilla Public
+  License, v. 2.0. If a copy of the MPL was not distributed with this
+  file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+  Copyright (c) 2021 PANDA GmbH / Dmitry Igrishin
+*/
+
+#include "../../src/debug.hpp"
+#include "../../src/resampler.hpp"
+
+#include <cmath>
+#include <cstddef>
+#include <iostream>
+#include <numeric>
+#include <vector>
+
+#define ASSERT PANDA_TIMESWIPE_ASSERT
+
+namespace {
+
+namespace detail = panda::timeswipe::detail;
+using Table = panda::timeswipe::Table<float>;
+
+/// @returns The table of `column_count` sines of `freq` (relative to the rate).
+Table make_sines(const unsigned column_count, const std::size_t row_count,
+  const double freq)
+{
+  Table result(column_count);
+  result.append_generated_rows(row_count, [&](const auto column, float* const out)
+  {
+    for (std::size_t i{}; i < row_count; ++i)
+      out[i] = static_cast<float>(std::sin(2*M_PI*freq*i + column));
+  });
+  return result;
+}
+
+/// @returns The RMS of the rows `[offset, row_count - offset)` of the `column`.
+double rms(const Table& table, const unsigned column, const std::size_t offset)
+{
+  const auto& data = table.column(column);
+  double sum{};
+  for (auto i = offset; i < data.size() - offset; ++i)
+    sum += data[i] * data[i];
+  return std::sqrt(sum / (data.size() - 2*offset));
+}
+
+} // namespace
+
+int main()
+try {
+  // Planning.
+  {
+    detail::Resampler_options options;
+    options.set_up_down(1, 1500);
+    ASSERT(detail::plan_resampler_stages(options).size() == 1);
+    options.set_multistage_enabled(true);
+    const auto stages = detail::plan_resampler_stages(options);
+    const int expected[][2]{{1, 2}, {1, 2}, {1, 3}, {1, 5}, {1, 5}, {1, 5}};
+    ASSERT(stages.size() == std::size(expected));
+    for (std::size_t i{}; i < stages.size(); ++i) {
+      ASSERT(stages[i].up_factor == expected[i][0]);
+      ASSERT(stages[i].down_factor == expected[i][1]);
+      ASSERT(0 < stages[i].passband_edge && stages[i].passband_edge < 1);
+    }
+    ASSERT(detail::plan_resampler_stages(options.set_up_down(1, 2)).size() == 1);
+    ASSERT(detail::plan_resampler_stages(options.set_up_down(147, 160)).size() == 1);
+    ASSERT(detail::plan_resampler_stages(options.set_up_down(7, 48000)).back()
+      .down_factor == 25);
+  }
+
+  // Half-band filter.
+  {
+    const auto firc = detail::design_stage_filter({1, 2, .1});
+    ASSERT(firc.size() % 4 == 3);
+    const auto middle = firc.size() / 2;
+    for (std::size_t i{}; i < firc.size(); ++i) {
+      if (i != middle && !((i - middle) % 2))
+        ASSERT(firc[i] == 0);
+      else
+        ASSERT(firc[i] != 0);
+    }
+    ASSERT(std::abs(std::accumulate(firc.cbegin(), firc.cend(), .0) - 1) < 1e-12);
+  }
+
+  // Resampling from 48 kHz to 1 kHz.
+  {
+    constexpr unsigned column_count{4};
+    constexpr std::size_t row_count{48000};
+    const auto options = detail::Resampler_options{}
+      .set_channel_count(column_count).set_up_down(1, 48).set_multistage_enabled(true);
+    detail::Resampler<float> resampler{options};
+    ASSERT(resampler.stage_count() == 5);
+    ASSERT(resampler.is_interleaved());
+
+    // The cascade takes fewer MACs than the single stage of the same spec.
+    const auto single = detail::design_stage_filter({1, 48,
+        detail::resampler_stage_passband_ratio / 48});
+    ASSERT(resampler.coefs_per_output() < single.size() / 2.);
+
+    // The passband passes, the chunked resampling is the same as the whole one.
+    const auto passband = make_sines(column_count, row_count, 100. / 48000);
+    auto whole = resampler.apply(passband);
+    whole.append_rows(resampler.flush());
+    ASSERT(std::abs(static_cast<double>(whole.row_count()) - row_count / 48) <= 2);
+    detail::Resampler<float> chunked_resampler{options};
+    Table chunked;
+    for (std::size_t offset{}, size{1}; offset < row_count; offset += size, size = size*3 + 1) {
+      Table chunk(column_count);
+      chunk.append_generated_rows(std::min(size, row_count - offset),
+        [&](const auto column, float* const out)
+        {
+          const auto& data = passband.column(column);
+          std::copy(data.begin() + offset,
+            data.begin() + offset + std::min(size, row_count - offset), out);
+        });
+      chunked_resampler.apply(chunk, chunked);
+    }
+    chunked.append_rows(chunked_resampler.flush());
+    ASSERT(chunked.row_count() == whole.row_count());
+    for (unsigned c{}; c < column_count; ++c) {
+      ASSERT(chunked.column(c) == whole.column(c));
+      ASSERT(std::abs(rms(whole, c, 100) - 1 / std::sqrt(2.)) < .01);
+    }
+
+    // The interleaved resampling is the same as the one of each channel.
+    for (unsigned c{}; c < column_count; ++c) {
+      detail::Resampler<float> channel_resampler{detail::Resampler_options{options}
+        .set_channel_count(1)};
+      ASSERT(!channel_resampler.is_interleaved());
+      Table channel;
+      channel.append_column(passband.column(c));
+      auto expected = channel_resampler.apply(channel);
+      expected.append_rows(channel_resampler.flush());
+      ASSERT(expected.row_count() == whole.row_count());
+      for (std::size_t i{}; i < expected.row_count(); ++i)
+        ASSERT(std::abs(expected.value(0, i) - whole.value(c, i)) < 1e-5);
+    }
+
+    // The band which would be aliased is suppressed.
+    detail::Resampler<float> stopband_resampler{options};
+    auto suppressed = stopband_resampler.apply(make_sines(column_count,
+        row_count, 1300. / 48000));
+    for (unsigned c{}; c < column_count; ++c)
+      ASSERT(rms(suppressed, c, 100) < 1e-3);
+  }
+ } catch (const std::exception& e) {
+  std::cerr << "error: " << e.what() << std::endl;
+  return 1;
+ } catch (...) {
+  std::cerr << "unknown error\n";
+  return 2;
+ }
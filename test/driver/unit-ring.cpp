@@ -0,0 +1,116 @@
+// -*- C++ -*-
+/*
+  This Source Code Form is subject to the terms of the Mozilla Public
+  License, v. 2.0. If a copy of the MPL was not distributed with this
+  file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+  Copyright (c) 2021 PANDA GmbH / Dmitry Igrishin
+*/
+
+#include "../../src/debug.hpp"
+#include "../../src/ring.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <iostream>
+#include <iterator>
+#include <numeric>
+#include <thread>
+#include <vector>
+
+#define ASSERT PANDA_TIMESWIPE_ASSERT
+
+int main()
+try {
+  namespace ts = panda::timeswipe;
+  using Ring = ts::detail::Spsc_ring<int>;
+
+  // Empty ring.
+  Ring ring{5};
+  ASSERT(ring.capacity() == 5);
+  ASSERT(!ring.size());
+  int out[5]{};
+  ASSERT(!ring.read(out, 5));
+
+  // Write and read with wrap around.
+  {
+    const int in[]{1, 2, 3, 4};
+    ASSERT(ring.write(in, 3));
+    ASSERT(ring.size() == 3);
+    ASSERT(!ring.write(in, 3)); // all or nothing
+    ASSERT(ring.size() == 3);
+    ASSERT(ring.read(out, 2) == 2);
+    ASSERT(out[0] == 1 && out[1] == 2);
+    ASSERT(ring.write(in, 4)); // wraps around
+    ASSERT(ring.size() == 5);
+    ASSERT(ring.read(out, 10) == 5);
+    ASSERT(out[0] == 3 && out[1] == 1 && out[2] == 2 && out[3] == 3 && out[4] == 4);
+    ASSERT(!ring.size());
+  }
+
+  // Clear.
+  {
+    const int in[]{1, 2};
+    ASSERT(ring.write(in, 2));
+    ring.clear();
+    ASSERT(!ring.size());
+    ASSERT(!ring.read(out, 5));
+  }
+
+  // High-water mark and reset.
+  {
+    ASSERT(ring.max_size() == 5);
+    ring.reset(3);
+    ASSERT(ring.capacity() == 3);
+    ASSERT(!ring.size() && !ring.max_size());
+    const int in[]{1, 2, 3};
+    ASSERT(ring.write(in, 2));
+    ASSERT(ring.read(out, 1) == 1);
+    ASSERT(ring.write(in, 2));
+    ASSERT(ring.max_size() == 3);
+    ASSERT(ring.read(out, 3) == 3);
+    ASSERT(out[0] == 2 && out[1] == 1 && out[2] == 2);
+    ASSERT(ring.max_size() == 3);
+    bool is_thrown{};
+    try {
+      ring.reset(0);
+    } catch (const std::exception&) {
+      is_thrown = true;
+    }
+    ASSERT(is_thrown && ring.capacity() == 3);
+  }
+
+  // Concurrent producer and consumer.
+  {
+    using Ring = ts::detail::Spsc_ring<std::uint64_t>;
+    constexpr std::uint64_t count{1000000};
+    Ring ring{1000};
+    std::thread producer{[&ring]
+    {
+      std::uint64_t block[7];
+      for (std::uint64_t i{}; i < count;) {
+        const auto size = std::min<std::uint64_t>(std::size(block), count - i);
+        std::iota(block, block + size, i);
+        if (ring.write(block, size))
+          i += size;
+        else
+          std::this_thread::yield();
+      }
+    }};
+    std::vector<std::uint64_t> block(11);
+    for (std::uint64_t i{}; i < count;) {
+      const auto size = ring.read(block.data(), block.size());
+      for (std::size_t j{}; j < size; ++j)
+        ASSERT(block[j] == i + j);
+      i += size;
+    }
+    producer.join();
+    ASSERT(!ring.size());
+  }
+ } catch (const std::exception& e) {
+  std::cerr << "error: " << e.what() << std::endl;
+  return 1;
+ } catch (...) {
+  std::cerr << "unknown error\n";
+  return 2;
+ }
@@ -9,6 +9,7 @@
 
 #include "../../src/debug.hpp"
 #include "../../src/table.hpp"
+#include "../../src/table_view.hpp"
 
 #include <iostream>
 #include <vector>
@@ -58,6 +59,54 @@ try {
   ASSERT(tab.value(0, 1) == 2);
   ASSERT(tab.value(1, 1) == 4);
   ASSERT(tab.value(2, 1) == 6);
+
+  // Add rows with generated values.
+  tab.append_generated_rows(2, [](const auto column, float* const out)
+  {
+    out[0] = column;
+    out[1] = column + 10;
+  });
+  ASSERT(tab.row_count() == 4);
+  ASSERT(tab.value(0, 1) == 2);
+  ASSERT(tab.value(0, 2) == 0);
+  ASSERT(tab.value(1, 2) == 1);
+  ASSERT(tab.value(2, 3) == 12);
+
+  // Remove rows.
+  tab.remove_rows(1, 2);
+  ASSERT(tab.row_count() == 2);
+  ASSERT(tab.value(0, 0) == 3);
+  ASSERT(tab.value(0, 1) == 10);
+  tab.remove_rows(5, 1);
+  ASSERT(tab.row_count() == 2);
+
+  // View.
+  {
+    ts::Table_view<float> view;
+    ASSERT(!view.column_count() && !view.row_count());
+    view = tab;
+    ASSERT(view.column_count() == tab.column_count());
+    ASSERT(view.row_count() == tab.row_count());
+    const auto column = view.column(2);
+    ASSERT(column.size() == 2);
+    ASSERT(column.data() == tab.column(2).data());
+    ASSERT(column[0] == 7 && column[1] == 12);
+    ASSERT(view.value(1, 0) == 5);
+    const auto copy = view.to_table();
+    ASSERT(copy.row_count() == 2 && copy.value(2, 1) == 12);
+  }
+
+  // View of the column-major data with the column stride.
+  {
+    const float data[]{1, 2, 3, 0, 4, 5, 6, 0};
+    const ts::Table_view<float> view{data + 1, 2, 2, 4};
+    ASSERT(view.column_count() == 2 && view.row_count() == 2);
+    const auto column = view.column(1);
+    ASSERT(column.size() == 2 && column.data() == data + 5);
+    ASSERT(view.value(0, 1) == 3 && view.value(1, 0) == 5);
+    const auto copy = view.to_table();
+    ASSERT(copy.row_count() == 2 && copy.value(1, 1) == 6);
+  }
  } catch (const std::exception& e) {
   std::cerr << "error: " << e.what() << std::endl;
   return 1;
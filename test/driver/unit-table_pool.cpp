@@ -0,0 +1,134 @@
+// -*- C++ -*-
+/*
+  This Source Code Form is subject to the terms of the Mozilla Public
+  License, v. 2.0. If a copy of the MPL was not distributed with this
+  file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+  Copyright (c) 2021 PANDA GmbH / Dmitry Igrishin
+*/
+
+#include "../../src/debug.hpp"
+#include "../../src/driver.hpp"
+#include "../../src/table_pool.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdlib>
+#include <iostream>
+#include <mutex>
+#include <new>
+
+#define ASSERT PANDA_TIMESWIPE_ASSERT
+
+namespace {
+std::atomic<std::uint64_t> heap_allocation_count;
+} // namespace
+
+void* operator new(const std::size_t size)
+{
+  heap_allocation_count.fetch_add(1, std::memory_order_relaxed);
+  if (auto* const result = std::malloc(size ? size : 1))
+    return result;
+  throw std::bad_alloc{};
+}
+
+void operator delete(void* const ptr) noexcept
+{
+  std::free(ptr);
+}
+
+void operator delete(void* const ptr, std::size_t) noexcept
+{
+  std::free(ptr);
+}
+
+int main()
+try {
+  namespace ts = panda::timeswipe;
+  using Pool = ts::detail::Table_pool<float>;
+
+  // Pool.
+  {
+    Pool pool{2, 4, 100};
+    ASSERT(pool.allocation_count() == 2);
+    auto t1 = pool.acquire();
+    auto t2 = pool.acquire();
+    ASSERT(pool.allocation_count() == 2);
+    ASSERT(t1.column_count() == 4 && !t1.row_count());
+    ASSERT(t1.column(0).capacity() >= 100);
+    t1.append_generated_row([](auto){return 1;});
+    pool.release(std::move(t1));
+    pool.release(std::move(t2));
+    pool.release(ts::Table<float>(4)); // the pool is full
+    pool.release(ts::Table<float>(3)); // the column count mismatch
+
+    auto t3 = pool.acquire();
+    ASSERT(!t3.row_count());
+    auto t4 = pool.acquire();
+    auto t5 = pool.acquire(); // the pool is exhausted
+    ASSERT(pool.allocation_count() == 3);
+    ASSERT(t5.column_count() == 4);
+
+    pool.reset(1, 2, 10);
+    ASSERT(pool.allocation_count() == 4);
+    pool.release(std::move(t3)); // the column count mismatch
+    ASSERT(pool.acquire().column_count() == 2);
+    ASSERT(pool.allocation_count() == 4);
+  }
+
+  // No heap allocations in the steady state of the measurement.
+  {
+    ASSERT(!setenv("PANDA_TIMESWIPE_ACQUISITION", "simulation", 1));
+    ASSERT(!setenv("PANDA_TIMESWIPE_ACQUISITION_SPEED", "4", 1));
+    auto& driver = ts::Driver::instance().initialize();
+    for (const int sample_rate : {48000, 32000, 6400, -48000}) {
+      const bool is_zero_copy = sample_rate < 0;
+      driver.set_settings(ts::Driver_settings{}.set_sample_rate(std::abs(sample_rate))
+        .set_burst_buffer_size(std::abs(sample_rate) / 100));
+
+      constexpr int warmup_count{20};
+      constexpr int check_count{50};
+      std::mutex mutex;
+      std::condition_variable done;
+      int call_count{};
+      std::uint64_t heap_allocations{};
+      std::uint64_t data_allocations{};
+      const auto handle = [&]
+      {
+        const std::lock_guard lock{mutex};
+        if (++call_count == warmup_count) {
+          heap_allocations = heap_allocation_count.load();
+          data_allocations = driver.data_allocation_count();
+        } else if (call_count == warmup_count + check_count) {
+          heap_allocations = heap_allocation_count.load() - heap_allocations;
+          data_allocations = driver.data_allocation_count() - data_allocations;
+          done.notify_one();
+        }
+      };
+      if (is_zero_copy)
+        driver.start_measurement(ts::Driver::zero_copy, [&](const auto&, const int)
+        {
+          handle();
+        });
+      else
+        driver.start_measurement([&](auto data, const int)
+        {
+          driver.recycle_data(std::move(data));
+          handle();
+        });
+      {
+        std::unique_lock lock{mutex};
+        done.wait(lock, [&]{ return call_count >= warmup_count + check_count; });
+      }
+      driver.stop_measurement();
+      ASSERT(!heap_allocations);
+      ASSERT(!data_allocations);
+    }
+  }
+ } catch (const std::exception& e) {
+  std::cerr << "error: " << e.what() << std::endl;
+  return 1;
+ } catch (...) {
+  std::cerr << "unknown error\n";
+  return 2;
+ }